@@ -1,7 +1,9 @@
-#ifndef NTPSYNC_H
-#define NTPSYNC_H
+#ifndef ESP_LCD_LAMP_H
+#define ESP_LCD_LAMP_H
 
-extern void MAIN_setStatusMsg(String msg);
-extern String MAIN_getStatusMsg(void);
+#define STATUS_MSG_SIZE   (96)
+
+extern void MAIN_setStatusMsg(const char* msg);   // copied, longer messages are cut
+extern const char* MAIN_getStatusMsg(void);
 
 #endif
@@ -3,7 +3,8 @@
  *  email: ujagaga@gmail.com
  *  
  *  This is the main sketch file. 
- *  It provides a periodic pooling of other services.
+ *  It registers every service with the task scheduler, which runs each at its own rate,
+ *  and reacts to the button, network and time events posted on the event bus.
  */
 
 #include "wifi_connection.h"
@@ -13,22 +14,64 @@
 #include "NTPSync.h"
 #include "web_socket.h"
 #include "lcd_display.h"
+#include "snow_anim.h"
+#include "timezones.h"
+#include "config_store.h"
+#include "scheduler.h"
+#include "metrics.h"
+#include "logger.h"
+#include "event_bus.h"
+#include "light_schedule.h"
+#include "ESP_LCD_Lamp.h"
 
-static String statusMessage = "";         /* This is set and requested from other modules. */
-static bool state_wifi_creds = false;
-static bool state_show_clk_wait = false;
-static String timeStringHH = "";
-static String timeStringMM = "";
+/* Boot screens, each entered by the UI task once its time has come. */
+enum UiState { UI_SPLASH, UI_CREDENTIALS, UI_WAITING, UI_CLOCK };
+
+#define UI_CREDENTIALS_MS   (7000)      // splash is shown until then
+#define UI_WAITING_MS       (20000)     // WiFi credentials are shown until then
+
+static char statusMessage[STATUS_MSG_SIZE] = "";   /* This is set and requested from other modules. */
+static uint8_t uiState = UI_SPLASH;
+static bool clockDirty = true;             /* set by the minute change subscription */
+static bool stationIpPending = false;       /* set when an IP arrives while the credentials are shown */
 static bool stationIpDisplayed = false;
+static bool timeSynced = false;
 
-void MAIN_setStatusMsg(String msg){
-  statusMessage = msg;
+void MAIN_setStatusMsg(const char* msg){
+  strncpy(statusMessage, msg, sizeof(statusMessage) - 1);
+  statusMessage[sizeof(statusMessage) - 1] = 0;
 }
 
-String MAIN_getStatusMsg(void){
+const char* MAIN_getStatusMsg(void){
   return statusMessage;
 }
 
+static void onMinuteChange(const struct tm* local, uint8_t changed)
+{
+  clockDirty = true;
+}
+
+static void onEvent(const Event* evt)
+{
+  switch(evt->type){
+    case EVT_BUTTON:
+      if(evt->value == BTN_CLICK){
+        PINCTRL_toggle();
+      }else if(evt->value == BTN_LONG_PRESS){
+        PINCTRL_rampStart();
+      }else if(evt->value == BTN_HOLD){
+        PINCTRL_rampStep();
+      }
+      break;
+    case EVT_IP_ACQUIRED:
+      stationIpPending = true;
+      break;
+    case EVT_TIME_SYNCED:
+      timeSynced = true;
+      break;
+  }
+}
+
 static void display_wifi_credentials()
 {
   LCD_clear();
@@ -36,76 +79,117 @@ static void display_wifi_credentials()
   LCD_color(C_YELLOW);
   LCD_write("WiFi SSID:\n");
   LCD_color(C_WHITE);
-  String message = String(WIFIC_getDeviceName()) + "\n";
-  LCD_write(message);
+  LCD_write(WIFIC_getDeviceName());
+  LCD_write("\n");
   LCD_color(C_YELLOW);
   LCD_write("WiFi PASS:\n");
   LCD_color(C_WHITE);
   LCD_write(AP_PASS); 
 }
 
+// --- Tasks ---
+static void taskHttp(void){
+  uint32_t start = micros();
+  HTTP_SERVER_process();
+  ANIM_networkLoad(micros() - start);
+}
+
+static void taskWs(void){
+  uint32_t start = micros();
+  WS_process();
+  ANIM_networkLoad(micros() - start);
+}
+
+static void taskInput(void){
+  PINCTRL_btnProcess();
+  PINCTRL_lightProcess();
+}
+
+static void taskUi(void){
+  uint32_t now = millis();
+
+  switch(uiState){
+    case UI_SPLASH:
+      if(now >= UI_CREDENTIALS_MS){
+        uiState = UI_CREDENTIALS;
+        display_wifi_credentials();
+      }
+      break;
+
+    case UI_CREDENTIALS:
+      if(stationIpPending && !stationIpDisplayed){
+        char ip[16];
+        WIFIC_formatStationIp(ip, sizeof(ip));
+        LCD_color(C_YELLOW);
+        LCD_write("\nConnected IP:\n");
+        LCD_color(C_WHITE);
+        LCD_write(ip);
+        stationIpDisplayed = true;
+      }
+      if(now >= UI_WAITING_MS){
+        uiState = UI_WAITING;
+        LCD_clear();
+        LCD_write("Waiting for WiFi,\nNTP sync...");
+      }
+      break;
+
+    case UI_WAITING:
+      if(timeSynced){
+        uiState = UI_CLOCK;
+        clockDirty = true;
+      }
+      break;
+
+    case UI_CLOCK:
+      if(clockDirty){
+        clockDirty = false;
+        const struct tm* local = NTPS_getLocalTime();
+        LCD_drawClock(local->tm_hour, local->tm_min);
+      }
+      break;
+  }
+}
+
+static void taskStats(void){
+  if(LCD_getFrameSpiBytes() > 0){
+    LOG_I(LOG_MOD_MAIN, "clock frame %u bytes", LCD_getFrameSpiBytes());
+  }
+  LOG_I(LOG_MOD_MAIN, "snow %u fps, worst frame %u us, %u dropped",
+        ANIM_getFps(), ANIM_getWorstFrameUs(), ANIM_getDroppedFrames());
+  LOG_I(LOG_MOD_MAIN, "WS %u msg/s, %u total", WS_getMsgRate(), WS_getMsgCount());
+  TASK_printStats();
+}
+
 void setup(void) {
   /* Need to wait for background processes to complete. Otherwise trouble with gpio.*/
   delay(100);   
   Serial.begin(115200); 
+  CFG_init();
   PINCTRL_init(); 
   WIFIC_init();
   WS_init();  
   HTTP_SERVER_init();  
   LCD_init();
+  ANIM_init();
+  TZ_init();
   NTPS_init();
+  SCHED_init();
+  NTPS_subscribe(NTPS_EVT_MINUTE, onMinuteChange);
+  EVT_subscribe(EVT_BUTTON | EVT_IP_ACQUIRED | EVT_TIME_SYNCED, onEvent);
+
+  /*       name     function        period ms       deadline ms  priority */
+  TASK_add("input", taskInput,      10,             20,          0);
+  TASK_add("ws",    taskWs,         5,              20,          1);
+  TASK_add("http",  taskHttp,       10,             50,          2);
+  TASK_add("anim",  ANIM_process,   10,             25,          3);   // paces its own frames
+  TASK_add("ntp",   NTPS_process,   20,             100,         4);
+  TASK_add("ui",    taskUi,         100,            200,         5);
+  TASK_add("wifi",  WIFIC_process,  100,            500,         6);
+  TASK_add("log",   LOG_process,    50,             1000,        7);
+  TASK_add("stats", taskStats,      60000,          5000,        7);
 }
 
 void loop(void) { 
-  HTTP_SERVER_process();
-  WS_process();
-  NTPS_process();
-
-  if(millis() > 20000){    
-    if(!state_show_clk_wait)
-    {
-      state_show_clk_wait = true;
-      LCD_clear();
-      LCD_write("Waiting for WiFi,\nNTP sync...");            
-    }else {
-      String hh = NTPS_getHH();
-      String mm = NTPS_getMM();
-
-      if(!hh.equals(timeStringHH) || !mm.equals(timeStringMM)){
-        timeStringHH = hh;
-        timeStringMM = mm;
-
-        LCD_clear();
-        LCD_color(C_YELLOW);
-        LCD_textSize(8);        
-        LCD_write(" ");
-        LCD_textSize(14);
-        LCD_write(hh);  
-        LCD_write("\n");
-        LCD_textSize(8);        
-        LCD_write(" ");
-        LCD_textSize(14);
-        LCD_write(mm);
-      }
-    }  
-  }else if(millis() > 7000){
-    if(!state_wifi_creds){
-      state_wifi_creds = true;
-      display_wifi_credentials();
-    }
-    String stationIp = WIFIC_getStationIp();
-    if((stationIp.length() > 1) && !stationIpDisplayed){
-      LCD_color(C_YELLOW);
-      LCD_write("\nConnected IP:\n");
-      LCD_color(C_WHITE);
-      LCD_write(stationIp);
-      stationIpDisplayed = true;      
-    }
-  }
-
-  uint8_t ledState = PINCTRL_btnPressed();
-  if(ledState != 255){
-    String bcmsg = "{\"CURRENT\":" + String(ledState) + "}";
-    WS_ServerBroadcast(bcmsg);
-  }
+  EVT_process();
+  MET_recordLoop(TASK_run());
 }
@@ -1,8 +1,21 @@
+/* 
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *  
+ *  Non-blocking NTP client.
+ *  Every step (DNS lookup, request, reply) is started or polled from NTPS_process() and
+ *  never waits. Servers are tried in turn with exponential backoff once all of them failed.
+ *  Between syncs time runs from millis(), corrected by the measured crystal drift.
+ */
 #include <Arduino.h>
 #include <ESP8266WiFi.h>
 #include <WiFiUdp.h>
-#include <NTPClient.h>
-#include <Timezone.h>
+#include <lwip/dns.h>
+#include "config.h"
+#include "NTPSync.h"
+#include "timezones.h"
+#include "logger.h"
+#include "event_bus.h"
 
 // ---- NTP / WiFi config ----
 static const char* NTP_SERVERS[] = {
@@ -10,46 +23,285 @@ static const char* NTP_SERVERS[] = {
 "time.cloudflare.com",
 "time.google.com"
 };
-static const unsigned long NTP_UPDATE_INTERVAL_MS = 60 * 1000; // 60s
+#define NTP_SERVER_COUNT      (sizeof(NTP_SERVERS) / sizeof(NTP_SERVERS[0]))
+#define NTP_PORT              123
+#define NTP_LOCAL_PORT        2390
+#define NTP_PACKET_SIZE       48
+#define NTP_UNIX_OFFSET       2208988800UL        // seconds from 1900 to 1970
+#define NTP_SYNC_MS           ((uint32_t)NTP_SYNC_H * 3600UL * 1000UL)
+#define NTP_DNS_TIMEOUT_MS    5000
+#define NTP_REPLY_TIMEOUT_MS  2000
+#define NTP_RETRY_MS          2000                // next server after a failure
+#define NTP_BACKOFF_MAX_MS    (30UL * 60 * 1000)  // cap for the backoff after a full round of failures
+#define DRIFT_MIN_SPAN_MS     (10UL * 60 * 1000)  // shorter sync intervals are too noisy for drift estimation
+#define DRIFT_MAX_PPM         500
+#define REBASE_MS             (24UL * 3600 * 1000) // keep millis() deltas far from wrapping
+#define MAX_SUBSCRIBERS       6
 
-// ---- NTPClient + Timezone setup ----
-WiFiUDP ntpUDP;
-NTPClient timeClient(ntpUDP, NTP_SERVERS[0], 0, NTP_UPDATE_INTERVAL_MS);
+typedef struct {
+  uint8_t events;
+  NtpsTimeCallback callback;
+} TimeSubscriber;
 
-// ---- Serbian Timezone rules ----
-TimeChangeRule CEST = {"CEST", Last, Sun, Mar, 2, 120}; // UTC+2 summer
-TimeChangeRule CET = {"CET", Last, Sun, Oct, 3, 60}; // UTC+1 winter
-Timezone serbiaTZ(CEST, CET);
+typedef enum {
+  NTP_IDLE,
+  NTP_RESOLVING,
+  NTP_WAITING
+} NtpState;
+
+static WiFiUDP ntpUDP;
+static NtpState state = NTP_IDLE;
+static uint8_t serverIdx = 0;
+static uint8_t failures = 0;
+static uint32_t nextAttemptMs = 0;
+static bool staUp = false;            // follows EVT_IP_ACQUIRED / EVT_WIFI_DOWN
+static uint32_t stateMs = 0;              /* when the current state was entered */
+static uint32_t requestMs = 0;            /* millis() stamped into the request, echoed back by the server */
+static IPAddress serverIp;
+static volatile uint8_t dnsRequest = 0;   /* lookup generation, late answers to older lookups are ignored */
+static volatile bool dnsDone = false;
+static volatile bool dnsFound = false;
+static ip_addr_t dnsAddr;
+static uint8_t packet[NTP_PACKET_SIZE];
 
 static bool ntpSynced = false;
+static uint64_t syncUtcMs = 0;            /* UTC at syncMillis */
+static uint32_t syncMillis = 0;
+static int32_t driftPpm = 0;              /* how much faster real time runs than millis() */
+
+static time_t cachedUtc = -1;
+static struct tm localTm;                 /* broken down local time of cachedUtc */
+static TimeSubscriber subscribers[MAX_SUBSCRIBERS];
+static uint8_t subscriberCount = 0;
+
+static uint64_t utcMsAt(uint32_t now)
+{
+  uint32_t elapsed = now - syncMillis;
+  return syncUtcMs + elapsed + (int64_t)elapsed * driftPpm / 1000000;
+}
+
+static void dnsCallback(const char* name, const ip_addr_t* ipaddr, void* arg)
+{
+  if((uint8_t)(uintptr_t)arg != dnsRequest){
+    return;
+  }
+  dnsFound = (ipaddr != nullptr);
+  if(dnsFound){
+    dnsAddr = *ipaddr;
+  }
+  dnsDone = true;
+}
+
+static void fail(const char* reason)
+{
+  LOG_W(LOG_MOD_NTP, "%s %s failed", NTP_SERVERS[serverIdx], reason);
+  failures++;
+  serverIdx = (serverIdx + 1) % NTP_SERVER_COUNT;
+
+  uint32_t delayMs = NTP_RETRY_MS;
+  if((failures % NTP_SERVER_COUNT) == 0){
+    /* Every server failed once more, back off exponentially. */
+    uint8_t rounds = min((uint8_t)(failures / NTP_SERVER_COUNT), (uint8_t)10);
+    delayMs = min((uint32_t)NTP_RETRY_MS << rounds, (uint32_t)NTP_BACKOFF_MAX_MS);
+  }
+  nextAttemptMs = millis() + delayMs;
+  state = NTP_IDLE;
+}
+
+static void sendRequest()
+{
+  while(ntpUDP.parsePacket() > 0){
+    ntpUDP.flush();       // drop stale replies
+  }
+
+  memset(packet, 0, sizeof(packet));
+  packet[0] = 0x23;       // LI 0, version 4, mode 3 (client)
+  requestMs = millis();
+  memcpy(&packet[40], &requestMs, sizeof(requestMs));
+
+  if(!ntpUDP.beginPacket(serverIp, NTP_PORT) || (ntpUDP.write(packet, sizeof(packet)) != sizeof(packet)) ||
+     !ntpUDP.endPacket()){
+    fail("send");
+    return;
+  }
+  state = NTP_WAITING;
+  stateMs = requestMs;
+}
+
+static void startLookup()
+{
+  dnsRequest++;
+  dnsDone = false;
+
+  err_t err = dns_gethostbyname(NTP_SERVERS[serverIdx], &dnsAddr, dnsCallback, (void*)(uintptr_t)dnsRequest);
+  if(err == ERR_OK){
+    serverIp = IPAddress(&dnsAddr);
+    sendRequest();
+  }else if(err == ERR_INPROGRESS){
+    state = NTP_RESOLVING;
+    stateMs = millis();
+  }else{
+    fail("DNS");
+  }
+}
+
+static void applySync(uint64_t utcMs, uint32_t now)
+{
+  if(ntpSynced){
+    uint32_t span = now - syncMillis;
+    if(span >= DRIFT_MIN_SPAN_MS){
+      /* The error left after the current drift correction refines the estimate. */
+      int64_t error = (int64_t)(utcMs - utcMsAt(now));
+      driftPpm += (int32_t)(error * 1000000 / span) / 2;
+      driftPpm = constrain(driftPpm, -DRIFT_MAX_PPM, DRIFT_MAX_PPM);
+    }
+  }
+
+  syncUtcMs = utcMs;
+  syncMillis = now;
+  ntpSynced = true;
+  failures = 0;
+  nextAttemptMs = now + NTP_SYNC_MS;
+  state = NTP_IDLE;
+  LOG_I(LOG_MOD_NTP, "time synced from %s, drift %d ppm", NTP_SERVERS[serverIdx], driftPpm);
+  EVT_post(EVT_TIME_SYNCED, (uint32_t)driftPpm);
+}
+
+static void readReply()
+{
+  if(ntpUDP.parsePacket() < NTP_PACKET_SIZE){
+    if(millis() - stateMs > NTP_REPLY_TIMEOUT_MS){
+      fail("reply");
+    }
+    return;
+  }
+
+  uint32_t now = millis();
+  uint32_t origin;
+  ntpUDP.read(packet, sizeof(packet));
+  memcpy(&origin, &packet[24], sizeof(origin));
+
+  /* Must be a server reply to our request, stratum 0 is a kiss-o'-death. */
+  if((ntpUDP.remoteIP() != serverIp) || ((packet[0] & 0x07) != 4) || (packet[1] == 0) || (origin != requestMs)){
+    return;
+  }
+
+  uint32_t seconds = ((uint32_t)packet[40] << 24) | ((uint32_t)packet[41] << 16) | ((uint32_t)packet[42] << 8) | packet[43];
+  uint32_t fraction = ((uint32_t)packet[44] << 24) | ((uint32_t)packet[45] << 16) | ((uint32_t)packet[46] << 8) | packet[47];
+  uint64_t utcMs = (uint64_t)(seconds - NTP_UNIX_OFFSET) * 1000 + (((uint64_t)fraction * 1000) >> 32);
+
+  applySync(utcMs + (now - requestMs) / 2, now);
+}
+
+/* Recomputes the local time only when a new second starts and tells subscribers what changed. */
+static void updateLocalTime()
+{
+  time_t utc = NTPS_getUtcEpoch();
+  if(utc == cachedUtc){
+    return;
+  }
+  cachedUtc = utc;
+
+  struct tm prev = localTm;
+  time_t local = TZ_toLocal(utc);
+  gmtime_r(&local, &localTm);
+
+  uint8_t changed = NTPS_EVT_SECOND;
+  if((localTm.tm_mday != prev.tm_mday) || (localTm.tm_mon != prev.tm_mon) || (localTm.tm_year != prev.tm_year)){
+    changed |= NTPS_EVT_DAY | NTPS_EVT_HOUR | NTPS_EVT_MINUTE;
+  }else if(localTm.tm_hour != prev.tm_hour){
+    changed |= NTPS_EVT_HOUR | NTPS_EVT_MINUTE;
+  }else if(localTm.tm_min != prev.tm_min){
+    changed |= NTPS_EVT_MINUTE;
+  }
+
+  for(uint8_t i = 0; i < subscriberCount; i++){
+    if(subscribers[i].events & changed){
+      subscribers[i].callback(&localTm, changed);
+    }
+  }
+}
+
+static void onNetworkEvent(const Event* evt)
+{
+  switch(evt->type){
+    case EVT_IP_ACQUIRED:
+      staUp = true;
+      if(!ntpSynced){
+        nextAttemptMs = millis();     // no need to wait out a backoff from before the link came up
+      }
+      break;
+    case EVT_WIFI_DOWN:
+      staUp = false;
+      break;
+    case EVT_CONFIG_CHANGED:
+      NTPS_refresh();                 // the time zone may have changed
+      break;
+  }
+}
 
 void NTPS_init() {
+  EVT_subscribe(EVT_IP_ACQUIRED | EVT_WIFI_DOWN | EVT_CONFIG_CHANGED, onNetworkEvent);
   ntpSynced = false;
-  if (WiFi.status() != WL_CONNECTED) {
-      Serial.println("NTPS: WiFi not connected yet, waiting...");
-      return;
-  }
-  Serial.println("NTPS: starting NTP client...");
-  timeClient.begin();
-  timeClient.update();  
+  state = NTP_IDLE;
+  nextAttemptMs = millis();
+  ntpUDP.begin(NTP_LOCAL_PORT);
+  updateLocalTime();
 }
 
 void NTPS_process() {
-  if (WiFi.status() != WL_CONNECTED) return;
+  uint32_t now = millis();
 
-  if (!timeClient.update()) {
-      timeClient.forceUpdate();
+  if(ntpSynced && ((now - syncMillis) > REBASE_MS)){
+    syncUtcMs = utcMsAt(now);
+    syncMillis = now;
   }
 
-  // mark synced if epoch is realistic
-  if (timeClient.getEpochTime() > 100000) {
-    if (!ntpSynced) {
-        Serial.println("NTPS: time synced");
-        ntpSynced = true;
-    }
-  } else {
-      ntpSynced = false;
+  switch(state){
+    case NTP_IDLE:
+      if(staUp && ((int32_t)(now - nextAttemptMs) >= 0)){
+        startLookup();
+      }
+      break;
+
+    case NTP_RESOLVING:
+      if(dnsDone){
+        if(dnsFound){
+          serverIp = IPAddress(&dnsAddr);
+          sendRequest();
+        }else{
+          fail("DNS");
+        }
+      }else if(now - stateMs > NTP_DNS_TIMEOUT_MS){
+        dnsRequest++;     // ignore the answer if it still arrives
+        fail("DNS");
+      }
+      break;
+
+    case NTP_WAITING:
+      readReply();
+      break;
+  }
+
+  updateLocalTime();
+}
+
+bool NTPS_subscribe(uint8_t events, NtpsTimeCallback callback) {
+  if(subscriberCount >= MAX_SUBSCRIBERS){
+    return false;
   }
+  subscribers[subscriberCount].events = events;
+  subscribers[subscriberCount].callback = callback;
+  subscriberCount++;
+  return true;
+}
+
+void NTPS_refresh() {
+  cachedUtc = -1;
+}
+
+const struct tm* NTPS_getLocalTime() {
+  return &localTm;
 }
 
 
@@ -57,46 +309,18 @@ bool NTPS_hasSynced() {
   return ntpSynced;
 }
 
+int32_t NTPS_getDriftPpm() {
+  return driftPpm;
+}
+
+uint32_t NTPS_getSyncAgeS() {
+  return ntpSynced ? (millis() - syncMillis) / 1000 : 0;
+}
+
+time_t NTPS_getUtcEpoch() {
+  return ntpSynced ? (time_t)(utcMsAt(millis()) / 1000) : 0;
+}
+
 time_t NTPS_getLocalEpoch() {
-  time_t utc = timeClient.getEpochTime();
-  return serbiaTZ.toLocal(utc);
-}
-
-// -------------------------
-// GET HH:MM (zero-padded, localtime)
-// -------------------------
-String NTPS_getHHMM() {
-  time_t local = NTPS_getLocalEpoch();
-  struct tm t;
-  localtime_r(&local, &t);
-  char buf[6];
-  snprintf(buf, sizeof(buf), "%02d\n%02d", t.tm_hour, t.tm_min);
-  return String(buf);
-}
-
-String NTPS_getHH() {
-  time_t local = NTPS_getLocalEpoch();
-  struct tm t;
-  localtime_r(&local, &t);
-  char buf[3];
-  snprintf(buf, sizeof(buf), "%02d", t.tm_hour);
-  return String(buf);
-}
-
-String NTPS_getMM() {
-  time_t local = NTPS_getLocalEpoch();
-  struct tm t;
-  localtime_r(&local, &t);
-  char buf[3];
-  snprintf(buf, sizeof(buf), "%02d", t.tm_min);
-  return String(buf);
-}
-
-String NTPS_getDate() {
-  time_t local = NTPS_getLocalEpoch();
-  struct tm t;
-  localtime_r(&local, &t);
-  char buf[6];
-  snprintf(buf, sizeof(buf), "%02d.%02d", t.tm_mday, t.tm_mon + 1); // tm_mon is 0-based
-  return String(buf);
+  return TZ_toLocal(cachedUtc);
 }
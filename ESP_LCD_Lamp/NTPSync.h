@@ -2,13 +2,24 @@
 #define NTPSYNC_H
 
 #include <Arduino.h>
+#include <time.h>
+
+#define NTPS_EVT_SECOND   0x01
+#define NTPS_EVT_MINUTE   0x02
+#define NTPS_EVT_HOUR     0x04
+#define NTPS_EVT_DAY      0x08
+
+typedef void (*NtpsTimeCallback)(const struct tm* local, uint8_t changed);
 
 void NTPS_process(void);              // call often from loop()
 bool NTPS_hasSynced(void);            // true if time is reasonably synced
-String NTPS_getHHMM(void);            // returns "HH:MM" (or "--:--" if unknown)
-String NTPS_getHH(void);
-String NTPS_getMM(void);
-String NTPS_getDate(void);
+time_t NTPS_getUtcEpoch(void);        // 0 until the first sync
+int32_t NTPS_getDriftPpm(void);       // estimated crystal drift applied between syncs
+uint32_t NTPS_getSyncAgeS(void);      // seconds since the last successful sync
+time_t NTPS_getLocalEpoch(void);
+const struct tm* NTPS_getLocalTime(void);                       // cached, refreshed once per second
+void NTPS_refresh(void);                                        // recompute local time, e.g. after a timezone change
+bool NTPS_subscribe(uint8_t events, NtpsTimeCallback callback); // called from NTPS_process() on NTPS_EVT_* changes
 void NTPS_init(void);
 
 #endif
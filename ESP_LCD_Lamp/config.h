@@ -10,19 +10,31 @@
 #define LED_PIN   15
 #define BTN_PIN   3
 
+#define LCD_SPI_HZ              (40000000)        // ST7789 SPI clock, the ESP8266 HSPI can go up to 80 MHz
+#define LCD_RAW_SPI             (1)               // 1: stream pixels through the raw HSPI FIFO transport, 0: through Adafruit_ST7789
+//#define LCD_BENCHMARK                           // Time both LCD backends at boot and print the results
+
+#define LIGHT_PWM_HZ            (1000)            // LED_PIN PWM frequency, the duty cycle has 1023 steps
+#define LIGHT_FADE_MS           (400)             // Fade time of toggles and brightness changes without a fade time of their own
+#define LIGHT_RAMP_MS           (3000)            // Holding the button ramps through the whole brightness range in this time
+#define LIGHT_SAVE_DELAY_MS     (5000)            // The brightness is written to flash once it has not changed for this long
+
+#define ANIM_SNOW               (1)               // Falling snow beside the clock digits
+#define ANIM_FPS                (20)              // Target animation frame rate
+#define ANIM_FRAME_BUDGET_US    (4000)            // Flakes not updated within this time wait for the next frame
+
 #define AP_MODE_TIMEOUT_S       (60)              // After this period since startup, try to connect as wifi client.
 #define AP_NAME_PREFIX          "SecretSantaClk_" // Will be appended by device MAC
 #define AP_PASS                 "hoho1234"
+#define WIFI_FAST_CONNECT_MS    (3000)            // A directed connect to the cached BSSID that takes longer falls back to a full scan and DHCP
+
+#define LOG_LEVEL               LOG_LEVEL_INFO    // Log calls above this level are compiled out
+#define LOG_RECORDS             (160)             // Log ring size, 28 bytes each
+#define LOG_SERIAL              (1)               // Echo the log to Serial whenever the UART has room
+
+#define CFG_TWO_SECTORS         (1)               // 1: the config store also takes the flash sector below EEPROM, which must hold no filesystem or OTA image
 
 #define REGION                  "Europe/Belgrade" // Required to fetch correct timezone with respect to daylight savings
 #define NTP_SYNC_H              (4)               // Sync time every 4 hours
 
-#define WIFI_PASS_EEPROM_ADDR   (0)
-#define WIFI_PASS_SIZE          (32)
-#define SSID_EEPROM_ADDR        (WIFI_PASS_EEPROM_ADDR + WIFI_PASS_SIZE)
-#define SSID_SIZE               (32)
-#define TZ_EEPROM_ADDR          (WIFI_PASS_SIZE + SSID_SIZE) 
-#define TZ_SIZE                 (64)
-#define EEPROM_SIZE             (WIFI_PASS_SIZE + SSID_SIZE + TZ_SIZE)   
-
 #endif
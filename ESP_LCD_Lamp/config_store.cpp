@@ -0,0 +1,286 @@
+/* 
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *  
+ *  Configuration store.
+ *  The settings are one packed record with a magic, layout version, length, sequence number and CRC32.
+ *  Records are appended to consecutive slots of a flash sector, so a save is a single slot write.
+ *  Slots fill in order, which lets the newest record be found with a binary search at boot.
+ *  Two sectors take turns: the one the EEPROM library used to own and the one below it. When the
+ *  active sector is full, the record is written and verified in the other one before the old sector
+ *  is erased, so a power loss at any point leaves at least one valid record. At boot the record with
+ *  the highest sequence number wins.
+ *  The sector below EEPROM is only free when neither the filesystem nor the sketch reaches it, see
+ *  CFG_TWO_SECTORS. CFG_init checks the flash layout and otherwise keeps to the EEPROM sector alone,
+ *  which is then erased before the record is rewritten at its start.
+ */
+#include <Arduino.h>
+#include <spi_flash.h>
+#include "config.h"
+#include "config_store.h"
+#include "logger.h"
+#include "event_bus.h"
+
+#define CFG_MAGIC             (0x4746434CUL)    // "LCFG"
+#define CFG_VERSION           (3)
+#define CFG_SLOT_SIZE         (256)
+#define CFG_SLOT_COUNT        (SPI_FLASH_SEC_SIZE / CFG_SLOT_SIZE)
+#define CFG_ERASED            (0xFFFFFFFFUL)
+#define CFG_SECTORS           (2)
+
+/* Layout used before this store, kept to migrate existing devices. */
+#define LEGACY_PASS_ADDR      (0)
+#define LEGACY_PASS_SIZE      (32)
+#define LEGACY_SSID_ADDR      (32)
+#define LEGACY_SSID_SIZE      (32)
+#define LEGACY_TZ_ADDR        (64)
+
+typedef struct __attribute__((packed)){
+  uint32_t magic;
+  uint16_t version;
+  uint16_t length;      // bytes of data that follow
+  uint32_t seq;         // the highest valid one is the current record
+  uint32_t crc;         // CRC32 of the data
+}CfgHeader;
+
+static_assert(sizeof(CfgHeader) + sizeof(CfgData) <= CFG_SLOT_SIZE, "CfgData does not fit a slot");
+
+extern "C" uint32_t _EEPROM_start;
+extern "C" uint32_t _FS_start;
+extern "C" uint32_t _FS_end;
+
+static CfgData cfg;
+static uint32_t slotBuf[CFG_SLOT_SIZE / 4];     /* flash access must be 4 byte aligned */
+static uint32_t sectorAddr[CFG_SECTORS];        /* the EEPROM sector and the one below it */
+static uint8_t sectorCount = CFG_SECTORS;       /* 1 when the sector below EEPROM is taken */
+static uint8_t activeSector = 0;                /* where the current record is */
+static uint8_t nextSlot = 0;                    /* first erased slot, CFG_SLOT_COUNT when the sector is full */
+static bool haveRecord = false;
+static uint32_t currentSeq = 0;
+static uint32_t savedCrc = 0;
+
+static uint32_t crc32(const uint8_t* data, size_t len)
+{
+  uint32_t crc = 0xFFFFFFFFUL;
+  while(len--){
+    crc ^= *data++;
+    for(uint8_t b = 0; b < 8; b++){
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+static void setDefaults(CfgData* data)
+{
+  memset(data, 0, sizeof(CfgData));
+  strncpy(data->tz, REGION, sizeof(data->tz) - 1);
+  data->brightness = CFG_BRIGHTNESS_MAX;
+}
+
+static uint32_t slotAddr(uint8_t sector, uint8_t slot)
+{
+  return sectorAddr[sector] + (uint32_t)slot * CFG_SLOT_SIZE;
+}
+
+static bool slotUsed(uint8_t sector, uint8_t slot)
+{
+  uint32_t magic;
+  ESP.flashRead(slotAddr(sector, slot), &magic, sizeof(magic));
+  return magic != CFG_ERASED;
+}
+
+/* Number of used slots, they are always a prefix of the sector. */
+static uint8_t usedSlots(uint8_t sector)
+{
+  uint8_t lo = 0;
+  uint8_t hi = CFG_SLOT_COUNT;
+  while(lo < hi){
+    uint8_t mid = (lo + hi) / 2;
+    if(slotUsed(sector, mid)){
+      lo = mid + 1;
+    }else{
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/* Reads a slot into slotBuf and checks it. */
+static bool readSlot(uint8_t sector, uint8_t slot)
+{
+  ESP.flashRead(slotAddr(sector, slot), slotBuf, sizeof(slotBuf));
+  const CfgHeader* hdr = (const CfgHeader*)slotBuf;
+  if((hdr->magic != CFG_MAGIC) || (hdr->version > CFG_VERSION) ||
+     (hdr->length > CFG_SLOT_SIZE - sizeof(CfgHeader))){
+    return false;
+  }
+  return crc32((const uint8_t*)(hdr + 1), hdr->length) == hdr->crc;
+}
+
+/* Strings of the old layout were terminated by the first non printable byte. */
+static void legacyString(const uint8_t* src, size_t srcSize, char* dst, size_t dstSize)
+{
+  size_t i = 0;
+  for(; (i < srcSize) && (i < dstSize - 1) && (src[i] >= 32) && (src[i] <= 126); i++){
+    dst[i] = src[i];
+  }
+  dst[i] = 0;
+}
+
+static void migrateLegacy(void)
+{
+  ESP.flashRead(sectorAddr[0], slotBuf, sizeof(slotBuf));
+  const uint8_t* raw = (const uint8_t*)slotBuf;
+
+  legacyString(raw + LEGACY_SSID_ADDR, LEGACY_SSID_SIZE, cfg.ssid, sizeof(cfg.ssid));
+  legacyString(raw + LEGACY_PASS_ADDR, LEGACY_PASS_SIZE, cfg.pass, sizeof(cfg.pass));
+  char tz[CFG_TZ_SIZE];
+  legacyString(raw + LEGACY_TZ_ADDR, CFG_TZ_SIZE, tz, sizeof(tz));
+  if(tz[0] != 0){
+    strcpy(cfg.tz, tz);
+  }
+}
+
+/* Normally the last used slot is valid, older ones only matter after an interrupted write.
+ * Returns the newest valid slot, or -1. */
+static int8_t newestSlot(uint8_t sector, uint8_t used)
+{
+  for(int8_t slot = (int8_t)used - 1; slot >= 0; slot--){
+    if(readSlot(sector, slot)){
+      return slot;
+    }
+  }
+  return -1;
+}
+
+static uint32_t flashOffset(const void* mapped)
+{
+  return (uint32_t)(uintptr_t)mapped - 0x40200000UL;
+}
+
+/* True when the sector at addr lies above the sketch and outside the filesystem. */
+static bool sectorFree(uint32_t addr)
+{
+  uint32_t sketchEnd = ((ESP.getSketchSize() + SPI_FLASH_SEC_SIZE - 1) / SPI_FLASH_SEC_SIZE) * SPI_FLASH_SEC_SIZE;
+  uint32_t fsStart = flashOffset(&_FS_start);
+  uint32_t fsEnd = flashOffset(&_FS_end);
+  bool inFs = (fsEnd > fsStart) && (addr < fsEnd) && ((addr + SPI_FLASH_SEC_SIZE) > fsStart);
+  return (addr >= sketchEnd) && !inFs;
+}
+
+void CFG_init(void)
+{
+  sectorAddr[0] = (flashOffset(&_EEPROM_start) / SPI_FLASH_SEC_SIZE) * SPI_FLASH_SEC_SIZE;
+  sectorAddr[1] = sectorAddr[0] - SPI_FLASH_SEC_SIZE;
+  sectorCount = CFG_TWO_SECTORS ? CFG_SECTORS : 1;
+  if((sectorCount > 1) && !sectorFree(sectorAddr[1])){
+    sectorCount = 1;
+    LOG_W(LOG_MOD_CFG, "sector below EEPROM is in use, keeping to one sector");
+  }
+  setDefaults(&cfg);
+
+  uint8_t used[CFG_SECTORS];
+  int8_t bestSector = -1;
+  int8_t bestSlot = -1;
+  uint32_t bestSeq = 0;
+  for(uint8_t sector = 0; sector < sectorCount; sector++){
+    used[sector] = usedSlots(sector);
+    int8_t slot = newestSlot(sector, used[sector]);
+    /* Both sectors hold a record if power failed between moving it and erasing the old sector. */
+    if((slot >= 0) && ((bestSector < 0) || (((const CfgHeader*)slotBuf)->seq > bestSeq))){
+      bestSector = sector;
+      bestSlot = slot;
+      bestSeq = ((const CfgHeader*)slotBuf)->seq;
+    }
+  }
+
+  if(bestSector >= 0){
+    readSlot(bestSector, bestSlot);
+    const CfgHeader* hdr = (const CfgHeader*)slotBuf;
+    memcpy(&cfg, hdr + 1, std::min((size_t)hdr->length, sizeof(cfg)));
+    haveRecord = true;
+    currentSeq = hdr->seq;
+    savedCrc = crc32((const uint8_t*)&cfg, sizeof(cfg));
+    activeSector = bestSector;
+    nextSlot = used[bestSector];
+    LOG_I(LOG_MOD_CFG, "record %u from sector %u slot %d", currentSeq, activeSector, bestSlot);
+    return;
+  }
+
+  activeSector = 0;
+  if(used[0] > 0){
+    /* Used slots but no valid record, the sector still holds the old EEPROM layout.
+     * With two sectors the first save goes to the other one, so the old settings stay until it succeeded. */
+    migrateLegacy();
+    LOG_I(LOG_MOD_CFG, "migrating old EEPROM layout");
+    nextSlot = CFG_SLOT_COUNT;
+    CFG_save();
+  }else{
+    nextSlot = 0;
+    LOG_I(LOG_MOD_CFG, "empty, using defaults");
+  }
+}
+
+CfgData* CFG_get(void)
+{
+  return &cfg;
+}
+
+bool CFG_save(void)
+{
+  uint32_t crc = crc32((const uint8_t*)&cfg, sizeof(cfg));
+  if(haveRecord && (crc == savedCrc)){
+    return true;
+  }
+
+  uint32_t startUs = micros();
+  uint8_t sector = activeSector;
+  uint8_t slot = nextSlot;
+  bool move = (slot >= CFG_SLOT_COUNT);
+  if(move){
+    sector = (activeSector + 1) % sectorCount;
+    slot = 0;
+    if(!ESP.flashEraseSector(sectorAddr[sector] / SPI_FLASH_SEC_SIZE)){
+      LOG_E(LOG_MOD_CFG, "erase failed");
+      return false;
+    }
+  }
+
+  memset(slotBuf, 0xFF, sizeof(slotBuf));
+  CfgHeader* hdr = (CfgHeader*)slotBuf;
+  hdr->magic = CFG_MAGIC;
+  hdr->version = CFG_VERSION;
+  hdr->length = sizeof(cfg);
+  hdr->seq = currentSeq + 1;
+  hdr->crc = crc;
+  memcpy(hdr + 1, &cfg, sizeof(cfg));
+
+  size_t len = (sizeof(CfgHeader) + sizeof(cfg) + 3) & ~3;
+  bool ok = ESP.flashWrite(slotAddr(sector, slot), slotBuf, len) && readSlot(sector, slot);
+  if(!ok){
+    /* Even a failed write leaves the slot dirty. A failed move is retried whole by the next save,
+     * with two sectors the old one is untouched. */
+    if(!move){
+      nextSlot = slot + 1;
+    }
+    LOG_E(LOG_MOD_CFG, "write failed");
+    return false;
+  }
+
+  if(move && (sector != activeSector)){
+    /* The new record is verified, only now the old one may go. */
+    if(!ESP.flashEraseSector(sectorAddr[activeSector] / SPI_FLASH_SEC_SIZE)){
+      LOG_W(LOG_MOD_CFG, "old sector not erased");
+    }
+    activeSector = sector;
+  }
+  nextSlot = slot + 1;
+
+  haveRecord = true;
+  currentSeq++;
+  savedCrc = crc;
+  LOG_I(LOG_MOD_CFG, "saved record %u to sector %u slot %u in %u us", currentSeq, sector, slot, micros() - startUs);
+  EVT_post(EVT_CONFIG_CHANGED, currentSeq);
+  return true;
+}
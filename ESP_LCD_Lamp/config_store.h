@@ -0,0 +1,42 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <Arduino.h>
+
+#define CFG_SSID_SIZE         (33)    // 32 bytes max per 802.11, plus the terminator
+#define CFG_PASS_SIZE         (65)    // 63 character passphrase or 64 hex digits, plus the terminator
+#define CFG_TZ_SIZE           (24)    // same as TZ_NAME_SIZE
+#define CFG_BRIGHTNESS_MAX    (1023)
+#define CFG_SCHED_RULES       (8)
+
+/* One light schedule rule, see light_schedule.h. */
+typedef struct __attribute__((packed)){
+  uint8_t days;         // bit 0 is Sunday, 0 means the rule is unused
+  uint8_t hour;         // local time
+  uint8_t minute;
+  uint16_t level;       // brightness to fade to, 0 is off
+  uint16_t fadeS;
+}CfgSchedRule;
+
+/* Every setting lives here. New fields go at the end, older records are loaded
+ * field by field up to their stored length and the rest keeps the defaults. */
+typedef struct __attribute__((packed)){
+  char ssid[CFG_SSID_SIZE];
+  char pass[CFG_PASS_SIZE];
+  char tz[CFG_TZ_SIZE];
+  uint16_t brightness;
+  /* Last station connection, for a directed reconnect. channel 0 means none. */
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t mask;
+  uint32_t dns;
+  CfgSchedRule sched[CFG_SCHED_RULES];
+}CfgData;
+
+extern void CFG_init(void);           // loads the newest valid record, migrates the old EEPROM layout
+extern CfgData* CFG_get(void);        // RAM copy, change it and call CFG_save()
+extern bool CFG_save(void);           // one flash write, nothing is written if the settings did not change
+
+#endif
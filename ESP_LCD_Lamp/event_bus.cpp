@@ -0,0 +1,79 @@
+/* 
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *  
+ *  Event bus.
+ *  Modules post small fixed size events into one queue instead of being polled by their users.
+ *  Posting only copies the event under a short interrupt lock, so it works from ISRs and SDK callbacks.
+ *  Delivery happens in loop() context, to a fixed table of subscribers.
+ */
+#include <Arduino.h>
+#include "event_bus.h"
+
+typedef struct{
+  uint16_t types;
+  EventHandler handler;
+}Subscriber;
+
+static Event queue[EVT_QUEUE_SIZE];
+static volatile uint8_t head = 0;
+static volatile uint8_t tail = 0;
+static volatile uint32_t dropped = 0;
+static Subscriber subscribers[EVT_MAX_SUBSCRIBERS];
+static uint8_t subscriberCount = 0;
+
+bool EVT_post(uint16_t type, uint32_t value)
+{
+  bool ok = false;
+  uint32_t ps = xt_rsil(15);
+  uint8_t next = (head + 1) & (EVT_QUEUE_SIZE - 1);
+  if(next != tail){
+    queue[head].type = type;
+    queue[head].value = value;
+    head = next;
+    ok = true;
+  }else{
+    dropped++;
+  }
+  xt_wsr_ps(ps);
+  return ok;
+}
+
+bool EVT_subscribe(uint16_t types, EventHandler handler)
+{
+  for(uint8_t i = 0; i < subscriberCount; i++){
+    if(subscribers[i].handler == handler){
+      subscribers[i].types |= types;
+      return true;
+    }
+  }
+  if(subscriberCount >= EVT_MAX_SUBSCRIBERS){
+    return false;
+  }
+  subscribers[subscriberCount].types = types;
+  subscribers[subscriberCount].handler = handler;
+  subscriberCount++;
+  return true;
+}
+
+/* Only events queued before the call are delivered, events posted by handlers wait for the next loop. */
+void EVT_process(void)
+{
+  uint8_t end = head;
+
+  while(tail != end){
+    Event evt = queue[tail];
+    tail = (tail + 1) & (EVT_QUEUE_SIZE - 1);
+
+    for(uint8_t i = 0; i < subscriberCount; i++){
+      if(subscribers[i].types & evt.type){
+        subscribers[i].handler(&evt);
+      }
+    }
+  }
+}
+
+uint32_t EVT_getDropped(void)
+{
+  return dropped;
+}
@@ -0,0 +1,31 @@
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <Arduino.h>
+
+/* Event types are bits so a subscriber can take several with one mask. */
+#define EVT_WIFI_UP           (0x0001)    // associated with the AP
+#define EVT_WIFI_DOWN         (0x0002)    // value: disconnect reason
+#define EVT_IP_ACQUIRED       (0x0004)    // value: station IP
+#define EVT_TIME_SYNCED       (0x0008)    // value: drift in ppm
+#define EVT_LIGHT_CHANGED     (0x0010)    // value: light state
+#define EVT_BUTTON            (0x0020)    // value: BTN_* gesture
+#define EVT_CONFIG_CHANGED    (0x0040)    // value: config record sequence number
+#define EVT_LEVEL_CHANGED     (0x0080)    // value: brightness the light is fading to, 0 is off
+
+#define EVT_QUEUE_SIZE        (16)        // power of two
+#define EVT_MAX_SUBSCRIBERS   (12)
+
+typedef struct{
+  uint16_t type;
+  uint32_t value;
+}Event;
+
+typedef void (*EventHandler)(const Event* evt);
+
+extern bool EVT_post(uint16_t type, uint32_t value);           // safe from ISRs and WiFi callbacks, false if the queue is full
+extern bool EVT_subscribe(uint16_t types, EventHandler handler); // handlers run from EVT_process(), never from the poster
+extern void EVT_process(void);                                  // once per loop(), delivers everything queued so far
+extern uint32_t EVT_getDropped(void);
+
+#endif
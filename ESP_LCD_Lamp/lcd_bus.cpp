@@ -0,0 +1,168 @@
+/* 
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *  
+ *  Raw ST7789 transport over the ESP8266 HSPI peripheral.
+ *  Commands and pixels are written straight into the 64 byte SPI FIFO (SPI1W0..SPI1W15)
+ *  and sent as full bursts, without the per call overhead of the SPI library.
+ *  Adafruit_ST7789 still initializes the panel, this module only streams into its RAM.
+ */
+#include <Arduino.h>
+#include <SPI.h>
+#include "config.h"
+#include "lcd_bus.h"
+
+#define ST_CASET          0x2A
+#define ST_RASET          0x2B
+#define ST_RAMWR          0x2C
+#define FIFO_BYTES        64
+#define FIFO_WORDS        (FIFO_BYTES / 4)
+
+static int16_t panelX = 0;
+static int16_t panelY = 0;
+static uint16_t burstBytes = 0;   /* Burst length currently programmed into SPI1U1 */
+static uint32_t savedUser = 0;    /* SPI1U of the SPI library, put back by LCDBUS_end() */
+
+static inline void waitIdle()
+{
+  while(SPI1CMD & SPIBUSY) {}
+}
+
+static inline void setBurstLength(uint16_t bytes)
+{
+  if(bytes != burstBytes){
+    const uint32_t mask = ~(SPIMMOSI << SPILMOSI);
+    uint32_t bits = bytes * 8 - 1;
+    SPI1U1 = (SPI1U1 & mask) | (bits << SPILMOSI);
+    burstBytes = bytes;
+  }
+}
+
+/* FIFO must be filled while idle, so callers wait before writing SPI1Wx. */
+static inline void startBurst(uint16_t bytes)
+{
+  setBurstLength(bytes);
+  SPI1CMD |= SPIBUSY;
+}
+
+static inline void setDataMode(bool data)
+{
+  waitIdle();
+  if(data){
+    GPOS = (1 << TFT_DC);
+  }else{
+    GPOC = (1 << TFT_DC);
+  }
+}
+
+static inline uint16_t swap16(uint16_t c)
+{
+  return (c >> 8) | (c << 8);
+}
+
+static void writeCommand(uint8_t cmd, const uint8_t* data, uint8_t len)
+{
+  volatile uint32_t* fifo = &SPI1W0;
+
+  setDataMode(false);
+  fifo[0] = cmd;
+  startBurst(1);
+
+  setDataMode(true);
+  if(len == 0){
+    return;
+  }
+  for(uint8_t i = 0; i < len; i++){
+    if((i & 3) == 0){
+      fifo[i / 4] = 0;
+    }
+    fifo[i / 4] |= (uint32_t)data[i] << ((i & 3) * 8);
+  }
+  startBurst(len);
+}
+
+void LCDBUS_init(int16_t xOffset, int16_t yOffset)
+{
+  panelX = xOffset;
+  panelY = yOffset;
+  burstBytes = 0;
+}
+
+/* SPI.begin() leaves the bus in full duplex, where the bytes read from MISO during a burst
+ * overwrite the FIFO. LCDBUS_fill() sends the same FIFO content many times, so MISO is turned
+ * off while the panel has the bus, as the core's own writePattern() does. */
+void LCDBUS_begin()
+{
+  SPI.beginTransaction(SPISettings(LCD_SPI_HZ, MSBFIRST, SPI_MODE3));
+  burstBytes = 0;     /* The SPI library may have changed the burst length since our last write. */
+  savedUser = SPI1U;
+  SPI1U = (savedUser & ~(SPIUMISO | SPIUDUPLEX)) | SPIUMOSI;
+#if TFT_CS >= 0
+  digitalWrite(TFT_CS, LOW);
+#endif
+}
+
+void LCDBUS_end()
+{
+  waitIdle();
+  SPI1U = savedUser;
+#if TFT_CS >= 0
+  digitalWrite(TFT_CS, HIGH);
+#endif
+  SPI.endTransaction();
+}
+
+void LCDBUS_setWindow(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+  uint16_t x0 = x + panelX;
+  uint16_t x1 = x0 + w - 1;
+  uint16_t y0 = y + panelY;
+  uint16_t y1 = y0 + h - 1;
+  const uint8_t cols[4] = {(uint8_t)(x0 >> 8), (uint8_t)x0, (uint8_t)(x1 >> 8), (uint8_t)x1};
+  const uint8_t rows[4] = {(uint8_t)(y0 >> 8), (uint8_t)y0, (uint8_t)(y1 >> 8), (uint8_t)y1};
+
+  writeCommand(ST_CASET, cols, sizeof(cols));
+  writeCommand(ST_RASET, rows, sizeof(rows));
+  writeCommand(ST_RAMWR, nullptr, 0);
+}
+
+void LCDBUS_fill(uint16_t color, uint32_t count)
+{
+  volatile uint32_t* fifo = &SPI1W0;
+  uint32_t word = swap16(color) | ((uint32_t)swap16(color) << 16);
+  uint32_t bytes = count * 2;
+
+  /* With MISO off the FIFO keeps its content between bursts, so it is only filled once. */
+  setDataMode(true);
+  for(uint8_t i = 0; i < FIFO_WORDS; i++){
+    fifo[i] = word;
+  }
+
+  while(bytes > 0){
+    uint16_t n = (bytes > FIFO_BYTES) ? FIFO_BYTES : bytes;
+    waitIdle();
+    startBurst(n);
+    bytes -= n;
+  }
+}
+
+void LCDBUS_push(const uint16_t* pixels, uint32_t count)
+{
+  volatile uint32_t* fifo = &SPI1W0;
+
+  setDataMode(true);
+  while(count > 0){
+    uint16_t n = (count > FIFO_BYTES / 2) ? FIFO_BYTES / 2 : count;
+    uint16_t i = 0;
+    waitIdle();
+    for(; i + 1 < n; i += 2){
+      fifo[i / 2] = swap16(pixels[i]) | ((uint32_t)swap16(pixels[i + 1]) << 16);
+    }
+    if(i < n){
+      fifo[i / 2] = swap16(pixels[i]);
+    }
+    startBurst(n * 2);
+    pixels += n;
+    count -= n;
+  }
+}
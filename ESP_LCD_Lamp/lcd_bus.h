@@ -0,0 +1,11 @@
+#ifndef LCDBUS_H
+#define LCDBUS_H
+
+extern void LCDBUS_init(int16_t xOffset, int16_t yOffset);
+extern void LCDBUS_begin(void);                                       // claim the bus, call before a sequence of writes
+extern void LCDBUS_end(void);                                         // wait for the last burst and release the bus
+extern void LCDBUS_setWindow(int16_t x, int16_t y, int16_t w, int16_t h);
+extern void LCDBUS_fill(uint16_t color, uint32_t count);              // stream one color into the current window
+extern void LCDBUS_push(const uint16_t* pixels, uint32_t count);      // stream a pixel buffer into the current window
+
+#endif
@@ -3,10 +3,203 @@
 #include <Adafruit_ST7789.h>
 #include "config.h"
 #include "lcd_display.h"
+#include "logger.h"
+#include "clock_glyphs.h"
+#include "lcd_bus.h"
+#include "sprite.h"
 
-Adafruit_ST7789 tft = Adafruit_ST7789(TFT_CS, TFT_DC, TFT_RST);
+#define ADDR_WINDOW_BYTES 11    // CASET + 4, RASET + 4, RAMWR
 
-void drawSnowflake(int x, int y, int r, uint16_t color) {
+// ---- Clock face layout ----
+#define CLK_LEFT_MARGIN   ((LCD_W - 2 * CLK_GLYPH_W) / 2)
+#define CLK_TOP_MARGIN    ((LCD_H - 2 * CLK_GLYPH_H) / 2)
+#define CLK_CELLS         4     // HH and MM
+#define CLK_BG            C_BLACK
+#define CLK_FG            C_YELLOW
+
+// ---- Splash screen ----
+#define SPLASH_FLAKES     4
+#define SPLASH_FLAKE_R    25
+
+static const int16_t SPLASH_FLAKE_POS[SPLASH_FLAKES][2] = {{40, 180}, {90, 140}, {140, 170}, {190, 130}};
+
+/* Exposes the panel RAM offsets so the raw transport can address the same window. */
+class LcdPanel : public Adafruit_ST7789 {
+  public:
+    LcdPanel(int8_t cs, int8_t dc, int8_t rst) : Adafruit_ST7789(cs, dc, rst) {}
+    int16_t xOffset() const { return _xstart; }
+    int16_t yOffset() const { return _ystart; }
+};
+
+LcdPanel tft = LcdPanel(TFT_CS, TFT_DC, TFT_RST);
+static bool rawBus = LCD_RAW_SPI;
+
+typedef struct {
+  int16_t x;
+  int16_t y;
+  char glyph;     /* Glyph currently on screen, 0 if the cell is blank. */
+} ClockCell;
+
+static ClockCell clockCells[CLK_CELLS] = {
+  {CLK_LEFT_MARGIN,               CLK_TOP_MARGIN,               0},
+  {CLK_LEFT_MARGIN + CLK_GLYPH_W, CLK_TOP_MARGIN,               0},
+  {CLK_LEFT_MARGIN,               CLK_TOP_MARGIN + CLK_GLYPH_H, 0},
+  {CLK_LEFT_MARGIN + CLK_GLYPH_W, CLK_TOP_MARGIN + CLK_GLYPH_H, 0}
+};
+static bool clockOnScreen = false;   /* false when something else was drawn over the clock face */
+static uint16_t screenId = 0;        /* changes whenever the whole screen content is replaced */
+static uint32_t spiBytesTotal = 0;
+static uint32_t spiBytesFrame = 0;   /* sent by the last LCD_drawClock(), 0 before the first */
+static uint16_t lineBuf[LCD_W];
+
+static void countSpi(uint32_t pixels)
+{
+  uint32_t bytes = ADDR_WINDOW_BYTES + pixels * 2;
+  spiBytesTotal += bytes;
+}
+
+static void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+  if(rawBus){
+    LCDBUS_begin();
+    LCDBUS_setWindow(x, y, w, h);
+    LCDBUS_fill(color, (uint32_t)w * h);
+    LCDBUS_end();
+  }else{
+    tft.fillRect(x, y, w, h, color);
+  }
+  countSpi((uint32_t)w * h);
+}
+
+/* Pushes the (srcX, srcY, w, h) part of a 1bpp PROGMEM bitmap to the panel at (x + srcX, y + srcY)
+ * as one address window followed by one continuous pixel stream. */
+static void pushBitmap(int16_t x, int16_t y, const uint8_t* bits, uint16_t stride,
+                       int16_t srcX, int16_t srcY, int16_t w, int16_t h, uint16_t fg, uint16_t bg)
+{
+  if(rawBus){
+    LCDBUS_begin();
+    LCDBUS_setWindow(x + srcX, y + srcY, w, h);
+  }else{
+    tft.startWrite();
+    tft.setAddrWindow(x + srcX, y + srcY, w, h);
+  }
+  for(int16_t r = 0; r < h; r++){
+    const uint8_t* row = bits + (srcY + r) * stride;
+    for(int16_t c = 0; c < w; c++){
+      uint16_t bit = srcX + c;
+      lineBuf[c] = (pgm_read_byte(row + (bit >> 3)) & (0x80 >> (bit & 7))) ? fg : bg;
+    }
+    if(rawBus){
+      LCDBUS_push(lineBuf, w);
+    }else{
+      tft.writePixels(lineBuf, w);
+    }
+  }
+  if(rawBus){
+    LCDBUS_end();
+  }else{
+    tft.endWrite();
+  }
+  countSpi((uint32_t)w * h);
+}
+
+static const uint8_t* glyphBits(char glyph)
+{
+  const char* pos = glyph ? strchr(CLK_GLYPH_CHARS, glyph) : nullptr;
+  return pos ? CLK_GLYPHS[pos - CLK_GLYPH_CHARS] : nullptr;
+}
+
+/* Repaints the bounding box of the pixels that differ between the old and the new glyph. */
+static void drawCell(ClockCell* cell, char glyph)
+{
+  const uint8_t* oldBits = glyphBits(cell->glyph);
+  const uint8_t* newBits = glyphBits(glyph);
+  int16_t top = CLK_GLYPH_H, bottom = -1, left = CLK_GLYPH_STRIDE, right = -1;
+
+  cell->glyph = glyph;
+  if(newBits == nullptr){
+    return;
+  }
+
+  for(int16_t r = 0; r < CLK_GLYPH_H; r++){
+    for(int16_t b = 0; b < CLK_GLYPH_STRIDE; b++){
+      uint16_t i = r * CLK_GLYPH_STRIDE + b;
+      uint8_t oldByte = oldBits ? pgm_read_byte(oldBits + i) : 0;
+      if(oldByte != pgm_read_byte(newBits + i)){
+        if(r < top) top = r;
+        bottom = r;
+        if(b < left) left = b;
+        if(b > right) right = b;
+      }
+    }
+  }
+
+  if(bottom < 0){
+    return;
+  }
+
+  int16_t x0 = left * 8;
+  int16_t x1 = min((right + 1) * 8, CLK_GLYPH_W);
+  pushBitmap(cell->x, cell->y, newBits, CLK_GLYPH_STRIDE, x0, top, x1 - x0, bottom - top + 1, CLK_FG, CLK_BG);
+}
+
+/* Fills a rectangle clipped to the screen. */
+void LCD_fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+  int16_t x1 = min((int16_t)(x + w), (int16_t)LCD_W);
+  int16_t y1 = min((int16_t)(y + h), (int16_t)LCD_H);
+  x = max((int16_t)0, x);
+  y = max((int16_t)0, y);
+
+  if((x1 > x) && (y1 > y)){
+    fillRect(x, y, x1 - x, y1 - y, color);
+  }
+}
+
+/* Draws a sprite centred at (x, y) on a black background, clipped to the screen. */
+void LCD_drawSprite(int16_t x, int16_t y, const Sprite* sprite, uint16_t color)
+{
+  int16_t left = x - sprite->extent;
+  int16_t top = y - sprite->extent;
+  int16_t srcX = max(0, -left);
+  int16_t srcY = max(0, -top);
+  int16_t w = min((int16_t)sprite->size, (int16_t)(LCD_W - left)) - srcX;
+  int16_t h = min((int16_t)sprite->size, (int16_t)(LCD_H - top)) - srcY;
+
+  if((w > 0) && (h > 0)){
+    pushBitmap(left, top, sprite->bits, sprite->stride, srcX, srcY, w, h, color, C_BLACK);
+  }
+}
+
+/* Draws only the set pixels of a sprite centred at (x, y), one fill per horizontal run,
+ * so whatever is already on the screen around and under the shape stays. */
+void LCD_drawSpriteOver(int16_t x, int16_t y, const Sprite* sprite, uint16_t color)
+{
+  int16_t left = x - sprite->extent;
+  int16_t top = y - sprite->extent;
+  int16_t c0 = max(0, -left);
+  int16_t c1 = min((int16_t)sprite->size, (int16_t)(LCD_W - left));
+  int16_t r0 = max(0, -top);
+  int16_t r1 = min((int16_t)sprite->size, (int16_t)(LCD_H - top));
+
+  for(int16_t r = r0; r < r1; r++){
+    const uint8_t* row = sprite->bits + r * sprite->stride;
+    int16_t run = -1;
+    for(int16_t c = c0; c <= c1; c++){
+      bool set = (c < c1) && (pgm_read_byte(row + (c >> 3)) & (0x80 >> (c & 7)));
+      if(set && (run < 0)){
+        run = c;
+      }else if(!set && (run >= 0)){
+        fillRect(left + run, top + r, c - run, 1, color);
+        run = -1;
+      }
+    }
+  }
+}
+
+#ifdef LCD_BENCHMARK
+/* Float trigonometry snowflake the splash screen used before vector sprites, kept for comparison. */
+static void drawSnowflake(int x, int y, int r, uint16_t color) {
   const float branchLen = 0.4;      // how long the side branches are (0.4 * r)
   const float branchOffset1 = 0.55; // location along arm (55%)
   const float branchOffset2 = 0.8;  // second location (80%)
@@ -40,12 +233,82 @@ void drawSnowflake(int x, int y, int r, uint16_t color) {
   }
 }
 
+/* Times a full screen fill and a 240 line push through both backends,
+ * then the splash snowflakes drawn with float math and as cached sprites. */
+static void benchmark()
+{
+  bool savedBus = rawBus;
+
+  for(uint16_t c = 0; c < LCD_W; c++){
+    lineBuf[c] = (c & 0x1F) << 11 | (c & 0x3F) << 5;
+  }
+
+  for(uint8_t pass = 0; pass < 2; pass++){
+    rawBus = (pass == 1);
+
+    uint32_t start = micros();
+    fillRect(0, 0, LCD_W, LCD_H, C_BLUE);
+    uint32_t fillUs = micros() - start;
+
+    start = micros();
+    if(rawBus){
+      LCDBUS_begin();
+      LCDBUS_setWindow(0, 0, LCD_W, LCD_H);
+      for(uint16_t r = 0; r < LCD_H; r++){
+        LCDBUS_push(lineBuf, LCD_W);
+      }
+      LCDBUS_end();
+    }else{
+      tft.startWrite();
+      tft.setAddrWindow(0, 0, LCD_W, LCD_H);
+      for(uint16_t r = 0; r < LCD_H; r++){
+        tft.writePixels(lineBuf, LCD_W);
+      }
+      tft.endWrite();
+    }
+    uint32_t pushUs = micros() - start;
+
+    LOG_I(LOG_MOD_LCD, "bench [%s @ %u Hz]: fillScreen %u us, 240 line push %u us",
+          rawBus ? "raw FIFO" : "Adafruit", (unsigned)LCD_SPI_HZ, fillUs, pushUs);
+  }
+
+  rawBus = savedBus;
+
+  uint32_t start = micros();
+  for(uint8_t i = 0; i < SPLASH_FLAKES; i++){
+    drawSnowflake(SPLASH_FLAKE_POS[i][0], SPLASH_FLAKE_POS[i][1], SPLASH_FLAKE_R, C_WHITE);
+  }
+  uint32_t floatUs = micros() - start;
+
+  start = micros();
+  for(uint8_t i = 0; i < SPLASH_FLAKES; i++){
+    LCD_drawSpriteOver(SPLASH_FLAKE_POS[i][0], SPLASH_FLAKE_POS[i][1], SPRITE_snowflake(SPLASH_FLAKE_R, 0), C_WHITE);
+  }
+  uint32_t spriteUs = micros() - start;
+
+  LOG_I(LOG_MOD_LCD, "bench: 4 snowflakes float %u us, sprite %u us", floatUs, spriteUs);
+}
+#endif
+
 void LCD_init() 
 {
   SPI.begin(); // default hardware SPI pins, no need to pass pins
   tft.init(240, 240, SPI_MODE3);
+  tft.setSPISpeed(LCD_SPI_HZ);
+  LCDBUS_init(tft.xOffset(), tft.yOffset());
+
+#ifdef LCD_BENCHMARK
+  benchmark();
+#endif
+
+  uint32_t start = micros();
+  fillRect(0, 0, LCD_W, LCD_H, C_BLACK);
+
+  /* The flakes overlap, so only their set pixels are drawn. The text goes over them. */
+  for(uint8_t i = 0; i < SPLASH_FLAKES; i++){
+    LCD_drawSpriteOver(SPLASH_FLAKE_POS[i][0], SPLASH_FLAKE_POS[i][1], SPRITE_snowflake(SPLASH_FLAKE_R, 0), C_WHITE);
+  }
 
-  tft.fillScreen(C_BLACK);
   tft.setCursor(0, 0);
   tft.setTextColor(C_BLUE);
   tft.setTextSize(3);
@@ -53,16 +316,14 @@ void LCD_init()
   tft.setTextColor(C_GREEN);
   tft.setTextSize(8);
   tft.println("Clock");
-
-  drawSnowflake(40, 180, 25, C_WHITE);
-  drawSnowflake(90, 140, 25, C_WHITE);
-  drawSnowflake(140, 170, 25, C_WHITE);
-  drawSnowflake(190, 130, 25, C_WHITE);
+  LOG_I(LOG_MOD_LCD, "splash rendered in %u us", micros() - start);
 }
 
 void LCD_clear()
 {
-  tft.fillScreen(C_BLACK);
+  fillRect(0, 0, LCD_W, LCD_H, C_BLACK);
+  clockOnScreen = false;
+  screenId++;
   tft.setCursor(0, 0);
   tft.setTextColor(C_WHITE);
   tft.setTextSize(2);
@@ -78,7 +339,61 @@ void LCD_color(uint16 c)
   tft.setTextColor(c);
 }
 
-void LCD_write(String msg)
+void LCD_write(const char* msg)
 {
   tft.print(msg);
+  if(clockOnScreen){
+    clockOnScreen = false;
+    screenId++;
+  }
+}
+
+void LCD_drawClock(uint8_t hour, uint8_t minute)
+{
+  uint32_t startBytes = spiBytesTotal;
+
+  if(!clockOnScreen){
+    LCD_clear();
+    for(uint8_t i = 0; i < CLK_CELLS; i++){
+      clockCells[i].glyph = 0;
+    }
+    clockOnScreen = true;
+  }
+
+  const char glyphs[CLK_CELLS] = {(char)('0' + hour / 10), (char)('0' + hour % 10),
+                                  (char)('0' + minute / 10), (char)('0' + minute % 10)};
+  for(uint8_t i = 0; i < CLK_CELLS; i++){
+    if(clockCells[i].glyph != glyphs[i]){
+      drawCell(&clockCells[i], glyphs[i]);
+    }
+  }
+  spiBytesFrame = spiBytesTotal - startBytes;
+}
+
+uint32_t LCD_getFrameSpiBytes()
+{
+  return spiBytesFrame;
+}
+
+bool LCD_isClockShown()
+{
+  return clockOnScreen;
+}
+
+uint16_t LCD_getScreenId()
+{
+  return screenId;
+}
+
+void LCD_getClockBounds(int16_t* x, int16_t* y, int16_t* w, int16_t* h)
+{
+  *x = clockCells[0].x;
+  *y = clockCells[0].y;
+  *w = 2 * CLK_GLYPH_W;
+  *h = 2 * CLK_GLYPH_H;
+}
+
+uint32_t LCD_getSpiBytes()
+{
+  return spiBytesTotal;
 }
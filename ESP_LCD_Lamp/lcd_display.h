@@ -1,6 +1,11 @@
 #ifndef LCDDISPLAY_H
 #define LCDDISPLAY_H
 
+#include "sprite.h"
+
+#define LCD_W 240
+#define LCD_H 240
+
 #define C_BLACK 0x0000
 #define C_WHITE 0xFFFF
 #define C_RED 0xF800
@@ -15,6 +20,15 @@ extern void LCD_init(void);
 extern void LCD_clear(void);
 extern void LCD_textSize(int txtSize);
 extern void LCD_color(uint16 c);
-extern void LCD_write(String msg);
+extern void LCD_write(const char* msg);
+extern void LCD_drawClock(uint8_t hour, uint8_t minute);    // repaints only the digits that changed
+extern uint32_t LCD_getFrameSpiBytes(void);                 // bytes sent by the last LCD_drawClock(), 0 before the first
+extern uint32_t LCD_getSpiBytes(void);                      // bytes sent since boot
+extern void LCD_fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+extern void LCD_drawSprite(int16_t x, int16_t y, const Sprite* sprite, uint16_t color);      // opaque square, black background
+extern void LCD_drawSpriteOver(int16_t x, int16_t y, const Sprite* sprite, uint16_t color);  // set pixels only
+extern bool LCD_isClockShown(void);
+extern uint16_t LCD_getScreenId(void);                      // changes whenever the screen is cleared or overwritten
+extern void LCD_getClockBounds(int16_t* x, int16_t* y, int16_t* w, int16_t* h);
 
 #endif
@@ -0,0 +1,141 @@
+/* 
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *  
+ *  Light schedule
+ *  Rules from the config store switch or fade the light at a local time on chosen weekdays.
+ *  Only the UTC epoch of the next event is kept. It is computed again when the rules, the time
+ *  zone or the clock change and after an event fires, the minute tick only compares against it.
+ *  Local times are converted with TZ_toUtc(), so a time repeated when DST ends fires once and
+ *  a time skipped when DST starts fires at the change.
+ */
+#include <Arduino.h>
+#include "config.h"
+#include "light_schedule.h"
+#include "config_store.h"
+#include "timezones.h"
+#include "NTPSync.h"
+#include "pinctrl.h"
+#include "event_bus.h"
+#include "logger.h"
+
+#define DAY_S         86400L
+
+static time_t nextUtc = 0;
+static uint8_t nextIndex = 0;
+static time_t lastFiredUtc = 0;     /* a clock set back after a sync must not repeat an event */
+
+/* A rule fires at most once a day, so eight days always reach its next event. */
+static time_t ruleNextAfter(const CfgSchedRule* rule, time_t utc)
+{
+  if((rule->days & SCHED_DAYS_ALL) == 0){
+    return 0;
+  }
+
+  int32_t today = (int32_t)(TZ_toLocal(utc) / DAY_S);
+  for(uint8_t d = 0; d <= 7; d++){
+    int32_t day = today + d;
+    uint8_t dow = (uint8_t)((day + 4) % 7);     // 1970-01-01 was a Thursday, 0 = Sunday
+    if(!(rule->days & (1 << dow))){
+      continue;
+    }
+    time_t at = TZ_toUtc((time_t)day * DAY_S + rule->hour * 3600L + rule->minute * 60L);
+    if(at > utc){
+      return at;
+    }
+  }
+  return 0;
+}
+
+time_t SCHED_nextAfter(time_t utc, uint8_t* index)
+{
+  const CfgData* cfg = CFG_get();
+  time_t best = 0;
+
+  for(uint8_t i = 0; i < CFG_SCHED_RULES; i++){
+    time_t at = ruleNextAfter(&cfg->sched[i], utc);
+    if((at != 0) && ((best == 0) || (at < best))){
+      best = at;
+      *index = i;
+    }
+  }
+  return best;
+}
+
+static void plan(void)
+{
+  if(!NTPS_hasSynced()){
+    nextUtc = 0;
+    return;
+  }
+  time_t now = NTPS_getUtcEpoch();
+  nextUtc = SCHED_nextAfter(max(now, lastFiredUtc), &nextIndex);
+  if(nextUtc != 0){
+    LOG_I(LOG_MOD_SCHED, "next: rule %u in %u s", nextIndex, (uint32_t)(nextUtc - now));
+  }
+}
+
+/* Every rule due at the same time fires, in table order. */
+static void fireDue(time_t now)
+{
+  const CfgData* cfg = CFG_get();
+  time_t due = nextUtc;
+
+  if((now - due) <= SCHED_LATE_S){
+    for(uint8_t i = 0; i < CFG_SCHED_RULES; i++){
+      const CfgSchedRule* rule = &cfg->sched[i];
+      if(ruleNextAfter(rule, due - 1) == due){
+        LOG_I(LOG_MOD_SCHED, "rule %u: level %u in %u s", i, rule->level, rule->fadeS);
+        PINCTRL_fade(rule->level, rule->fadeS * 1000UL, EASE_LINEAR);
+      }
+    }
+  }else{
+    LOG_W(LOG_MOD_SCHED, "skipped rule %u, the clock jumped %u s past it", nextIndex, (uint32_t)(now - due));
+  }
+  lastFiredUtc = due;
+  plan();
+}
+
+static void onMinuteChange(const struct tm* local, uint8_t changed)
+{
+  time_t now = NTPS_getUtcEpoch();
+  if((nextUtc != 0) && (now >= nextUtc)){
+    fireDue(now);
+  }
+}
+
+/* A sync may move the clock, a config change may be new rules or a new time zone. */
+static void onEvent(const Event* evt)
+{
+  plan();
+}
+
+bool SCHED_setRule(uint8_t index, const CfgSchedRule* rule)
+{
+  if((index >= CFG_SCHED_RULES) || (rule->hour > 23) || (rule->minute > 59) || (rule->level > CFG_BRIGHTNESS_MAX)){
+    return false;
+  }
+  CfgSchedRule* dst = &CFG_get()->sched[index];
+  *dst = *rule;
+  dst->days &= SCHED_DAYS_ALL;
+  CFG_save();
+  plan();       /* now rather than on the config event, so a reply can show the new next event */
+  return true;
+}
+
+const CfgSchedRule* SCHED_getRule(uint8_t index)
+{
+  return &CFG_get()->sched[(index < CFG_SCHED_RULES) ? index : 0];
+}
+
+time_t SCHED_getNextUtc(void)
+{
+  return nextUtc;
+}
+
+void SCHED_init(void)
+{
+  EVT_subscribe(EVT_TIME_SYNCED | EVT_CONFIG_CHANGED, onEvent);
+  NTPS_subscribe(NTPS_EVT_MINUTE, onMinuteChange);
+  plan();
+}
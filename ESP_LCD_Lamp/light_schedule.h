@@ -0,0 +1,17 @@
+#ifndef LIGHT_SCHEDULE_H
+#define LIGHT_SCHEDULE_H
+
+#include <Arduino.h>
+#include <time.h>
+#include "config_store.h"
+
+#define SCHED_DAYS_ALL    (0x7F)    // bit 0 is Sunday
+#define SCHED_LATE_S      (300)     // an event overrun by a clock correction still fires if it is at most this late
+
+extern void SCHED_init(void);       // after CFG_init(), TZ_init() and NTPS_init()
+extern bool SCHED_setRule(uint8_t index, const CfgSchedRule* rule);   // saves the config, false if the rule is invalid
+extern const CfgSchedRule* SCHED_getRule(uint8_t index);
+extern time_t SCHED_getNextUtc(void);                   // 0 when nothing is due or the time is not synced yet
+extern time_t SCHED_nextAfter(time_t utc, uint8_t* index);   // first rule event after utc, 0 if there is none
+
+#endif
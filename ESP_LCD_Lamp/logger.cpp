@@ -0,0 +1,158 @@
+/* 
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *  
+ *  Logger.
+ *  Records are fixed size binary entries in a RAM ring: timestamp, module, level, format pointer and
+ *  arguments. Writing one is a copy of a few words, the text is only produced when someone reads
+ *  the log over HTTP or WebSocket, or when LOG_process() echoes it to Serial without blocking.
+ */
+#include <Arduino.h>
+#include "logger.h"
+
+typedef struct{
+  uint32_t ms;
+  PGM_P fmt;
+  uint8_t module;
+  uint8_t level;
+  uint8_t argc;
+  uint32_t args[LOG_MAX_ARGS];
+}LogRecord;
+
+static const char* const moduleNames[LOG_MOD_COUNT] = { "MAIN", "WIFI", "NTP", "HTTP", "WS", "LCD", "CFG", "TZ", "TASK", "SCHED" };
+static const char levelChars[] = "?EWID";
+
+static LogRecord ring[LOG_RECORDS];
+static volatile uint32_t nextSeq = 0;
+static uint32_t serialSeq = 0;
+
+void LOG_write(uint8_t module, uint8_t level, PGM_P fmt, const uint32_t* args, uint8_t argc)
+{
+  uint32_t ps = xt_rsil(15);
+  LogRecord* r = &ring[nextSeq % LOG_RECORDS];
+  r->ms = millis();
+  r->fmt = fmt;
+  r->module = module;
+  r->level = level;
+  r->argc = argc;
+  memcpy(r->args, args, argc * sizeof(uint32_t));
+  nextSeq++;
+  xt_wsr_ps(ps);
+}
+
+uint32_t LOG_firstSeq(void)
+{
+  return (nextSeq > LOG_RECORDS) ? (nextSeq - LOG_RECORDS) : 0;
+}
+
+uint32_t LOG_nextSeq(void)
+{
+  return nextSeq;
+}
+
+/* Formats one conversion of spec (e.g. "%-8" plus conv) into out. */
+static size_t formatArg(char* out, size_t size, char* spec, size_t specLen, char conv, uint32_t arg)
+{
+  if(conv == 'I'){
+    return snprintf(out, size, "%u.%u.%u.%u", arg & 0xFF, (arg >> 8) & 0xFF, (arg >> 16) & 0xFF, arg >> 24);
+  }
+  if(conv == 's'){
+    char text[48];
+    PGM_P src = (PGM_P)(uintptr_t)arg;
+    size_t n = 0;
+    if(src != nullptr){
+      for(char c = pgm_read_byte(src); (c != 0) && (n < sizeof(text) - 1); c = pgm_read_byte(++src)){
+        text[n++] = c;
+      }
+    }
+    text[n] = 0;
+    spec[specLen] = 's';
+    spec[specLen + 1] = 0;
+    return snprintf(out, size, spec, text);
+  }
+  spec[specLen] = conv;
+  spec[specLen + 1] = 0;
+  if(conv == 'd'){
+    return snprintf(out, size, spec, (int32_t)arg);
+  }
+  return snprintf(out, size, spec, arg);
+}
+
+size_t LOG_format(uint32_t seq, char* buf, size_t size)
+{
+  if((seq < LOG_firstSeq()) || (seq >= nextSeq) || (size == 0)){
+    return 0;
+  }
+
+  /* Copy first, a record may be overwritten from an interrupt while it is being formatted. */
+  LogRecord r;
+  uint32_t ps = xt_rsil(15);
+  r = ring[seq % LOG_RECORDS];
+  bool overwritten = (seq < LOG_firstSeq());
+  xt_wsr_ps(ps);
+  if(overwritten){
+    return 0;
+  }
+
+  size_t len = snprintf(buf, size, "%6u.%03u %c %-4s ", r.ms / 1000, r.ms % 1000,
+                        levelChars[r.level < sizeof(levelChars) - 1 ? r.level : 0],
+                        (r.module < LOG_MOD_COUNT) ? moduleNames[r.module] : "?");
+  uint8_t argIdx = 0;
+  PGM_P p = r.fmt;
+
+  for(char c = pgm_read_byte(p); (c != 0) && (len < size - 1); c = pgm_read_byte(++p)){
+    if(c != '%'){
+      buf[len++] = c;
+      continue;
+    }
+
+    char spec[8] = "%";
+    size_t specLen = 1;
+    for(c = pgm_read_byte(++p); ((c == '-') || ((c >= '0') && (c <= '9'))) && (specLen < sizeof(spec) - 2); c = pgm_read_byte(++p)){
+      spec[specLen++] = c;
+    }
+    if(c == 0){
+      break;
+    }
+    if(c == '%'){
+      buf[len++] = '%';
+      continue;
+    }
+    uint32_t arg = (argIdx < r.argc) ? r.args[argIdx] : 0;
+    argIdx++;
+    len += formatArg(buf + len, size - len, spec, specLen, c, arg);
+    if(len >= size){
+      len = size - 1;
+    }
+  }
+  buf[len] = 0;
+  return len;
+}
+
+void LOG_process(void)
+{
+#if LOG_SERIAL
+  char line[LOG_LINE_SIZE];
+
+  /* A line is formatted first and only written if the UART takes all of it, else it waits here. */
+  if(serialSeq < LOG_firstSeq()){
+    size_t len = snprintf(line, sizeof(line), "... %u log records lost\n", LOG_firstSeq() - serialSeq);
+    if((size_t)Serial.availableForWrite() < len){
+      return;
+    }
+    Serial.write(line, len);
+    serialSeq = LOG_firstSeq();
+  }
+  while(serialSeq < nextSeq){
+    size_t len = LOG_format(serialSeq, line, sizeof(line) - 1);
+    if(len > 0){
+      line[len++] = '\n';
+      if((size_t)Serial.availableForWrite() < len){
+        return;
+      }
+      Serial.write(line, len);
+    }
+    serialSeq++;
+  }
+#endif
+}
@@ -0,0 +1,53 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <Arduino.h>
+#include <pgmspace.h>
+#include "config.h"
+
+#define LOG_LEVEL_ERROR   1
+#define LOG_LEVEL_WARN    2
+#define LOG_LEVEL_INFO    3
+#define LOG_LEVEL_DEBUG   4
+
+#define LOG_MAX_ARGS      4
+#define LOG_LINE_SIZE     (128)     // enough for one formatted record
+
+enum{ LOG_MOD_MAIN, LOG_MOD_WIFI, LOG_MOD_NTP, LOG_MOD_HTTP, LOG_MOD_WS, LOG_MOD_LCD,
+      LOG_MOD_CFG, LOG_MOD_TZ, LOG_MOD_TASK, LOG_MOD_SCHED, LOG_MOD_COUNT };
+
+/* Log calls store the PROGMEM format pointer and up to LOG_MAX_ARGS 32 bit arguments,
+ * formatting happens only when the log is read. Conversions: %d %u %x %c %s %I (IPv4 as uint32)
+ * with optional '-', '0' and width. %s is read at that later time, so it must point at text
+ * that stays put: literals, PROGMEM or static buffers. Levels above LOG_LEVEL compile to nothing. */
+#define LOG_AT(lvl, mod, fmt, ...) do{ \
+    if(LOG_LEVEL >= (lvl)){ \
+      static const char logFmt_[] PROGMEM = fmt; \
+      LOG_record((mod), (lvl), logFmt_, ##__VA_ARGS__); \
+    } \
+  }while(0)
+
+#define LOG_E(mod, fmt, ...)  LOG_AT(LOG_LEVEL_ERROR, mod, fmt, ##__VA_ARGS__)
+#define LOG_W(mod, fmt, ...)  LOG_AT(LOG_LEVEL_WARN, mod, fmt, ##__VA_ARGS__)
+#define LOG_I(mod, fmt, ...)  LOG_AT(LOG_LEVEL_INFO, mod, fmt, ##__VA_ARGS__)
+#define LOG_D(mod, fmt, ...)  LOG_AT(LOG_LEVEL_DEBUG, mod, fmt, ##__VA_ARGS__)
+
+extern void LOG_write(uint8_t module, uint8_t level, PGM_P fmt, const uint32_t* args, uint8_t argc);  // safe from ISRs and callbacks
+extern uint32_t LOG_firstSeq(void);       // oldest record still in the ring
+extern uint32_t LOG_nextSeq(void);        // sequence number the next record will get
+extern size_t LOG_format(uint32_t seq, char* buf, size_t size);   // one record as a text line, 0 if it is gone
+extern void LOG_process(void);            // echoes new records to Serial as far as the UART has room
+
+inline uint32_t LOG_arg(const char* s) { return (uint32_t)(uintptr_t)s; }
+inline uint32_t LOG_arg(char* s) { return (uint32_t)(uintptr_t)s; }
+template<typename T> inline uint32_t LOG_arg(T v) { return (uint32_t)v; }
+
+template<typename... Args>
+inline void LOG_record(uint8_t module, uint8_t level, PGM_P fmt, Args... args)
+{
+  static_assert(sizeof...(args) <= LOG_MAX_ARGS, "too many log arguments");
+  const uint32_t argv[] = { LOG_arg(args)..., 0 };
+  LOG_write(module, level, fmt, argv, sizeof...(args));
+}
+
+#endif
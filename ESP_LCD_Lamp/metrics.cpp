@@ -0,0 +1,164 @@
+/* 
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *  
+ *  Runtime metrics.
+ *  Only the loop histogram and the heap low watermark are collected here, on every loop() pass.
+ *  Everything else is a counter the owning module keeps anyway and is read when metrics are requested.
+ */
+#include <Arduino.h>
+#include "metrics.h"
+#include "scheduler.h"
+#include "web_socket.h"
+#include "lcd_display.h"
+#include "NTPSync.h"
+#include "wifi_connection.h"
+#include "event_bus.h"
+#include "pinctrl.h"
+
+#define LINE_SIZE         (128)
+
+/* Upper bounds of the loop histogram buckets in us, the last bucket is +Inf. */
+static const uint32_t loopBounds[] = { 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000 };
+#define LOOP_BUCKETS      (sizeof(loopBounds) / sizeof(loopBounds[0]) + 1)
+
+static uint32_t loopCounts[LOOP_BUCKETS];
+static uint64_t loopSumUs = 0;
+static uint32_t loopCount = 0;
+static uint32_t loopMaxUs = 0;
+static uint32_t heapMin = 0xFFFFFFFFUL;
+
+void MET_recordLoop(uint32_t busyUs)
+{
+  uint8_t i = 0;
+  while((i < LOOP_BUCKETS - 1) && (busyUs > loopBounds[i])){
+    i++;
+  }
+  loopCounts[i]++;
+  loopSumUs += busyUs;
+  loopCount++;
+  if(busyUs > loopMaxUs){
+    loopMaxUs = busyUs;
+  }
+
+  uint32_t heap = ESP.getFreeHeap();
+  if(heap < heapMin){
+    heapMin = heap;
+  }
+}
+
+uint32_t MET_getLoopMaxUs(void)
+{
+  return loopMaxUs;
+}
+
+uint32_t MET_getHeapMin(void)
+{
+  return heapMin;
+}
+
+// --- Prometheus text format ---
+static MetricsWriter out;
+static char line[LINE_SIZE];
+
+static void emit(const char* fmt, ...)
+{
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(line, sizeof(line), fmt, args);
+  va_end(args);
+  out(line);
+}
+
+static void header(const char* name, const char* type, const char* help)
+{
+  emit("# HELP %s %s\n", name, help);
+  emit("# TYPE %s %s\n", name, type);
+}
+
+static void gauge(const char* name, const char* help, uint32_t value)
+{
+  header(name, "gauge", help);
+  emit("%s %u\n", name, value);
+}
+
+static void counter(const char* name, const char* help, uint32_t value)
+{
+  header(name, "counter", help);
+  emit("%s %u\n", name, value);
+}
+
+/* Microseconds as decimal seconds, without 64 bit printf support. */
+static void emitSeconds(const char* prefix, uint64_t us)
+{
+  emit("%s %u.%06u\n", prefix, (uint32_t)(us / 1000000), (uint32_t)(us % 1000000));
+}
+
+void MET_writePrometheus(MetricsWriter write)
+{
+  out = write;
+
+  header("lamp_loop_busy_seconds", "histogram", "Time spent running tasks per loop() pass.");
+  uint32_t cumulative = 0;
+  for(uint8_t i = 0; i < LOOP_BUCKETS - 1; i++){
+    cumulative += loopCounts[i];
+    emit("lamp_loop_busy_seconds_bucket{le=\"%u.%06u\"} %u\n",
+         loopBounds[i] / 1000000, loopBounds[i] % 1000000, cumulative);
+  }
+  emit("lamp_loop_busy_seconds_bucket{le=\"+Inf\"} %u\n", loopCount);
+  emitSeconds("lamp_loop_busy_seconds_sum", loopSumUs);
+  emit("lamp_loop_busy_seconds_count %u\n", loopCount);
+  gauge("lamp_loop_busy_max_microseconds", "Longest loop() pass since boot.", loopMaxUs);
+  gauge("lamp_cpu_load_percent", "Time spent in tasks during the last second.", TASK_getLoadPercent());
+
+  /* Per module time, every service runs as its own task. */
+  header("lamp_task_seconds_total", "counter", "Time spent in each task.");
+  for(uint8_t i = 0; i < TASK_count(); i++){
+    TaskStats s;
+    TASK_getStats(i, &s);
+    char prefix[48];
+    snprintf(prefix, sizeof(prefix), "lamp_task_seconds_total{task=\"%s\"}", s.name);
+    emitSeconds(prefix, s.totalUs);
+  }
+  header("lamp_task_runs_total", "counter", "Runs of each task.");
+  for(uint8_t i = 0; i < TASK_count(); i++){
+    TaskStats s;
+    TASK_getStats(i, &s);
+    emit("lamp_task_runs_total{task=\"%s\"} %u\n", s.name, s.runs);
+  }
+  header("lamp_task_max_microseconds", "gauge", "Longest run of each task.");
+  for(uint8_t i = 0; i < TASK_count(); i++){
+    TaskStats s;
+    TASK_getStats(i, &s);
+    emit("lamp_task_max_microseconds{task=\"%s\"} %u\n", s.name, s.maxUs);
+  }
+  header("lamp_task_deadline_misses_total", "counter", "Runs of each task that started after their deadline.");
+  for(uint8_t i = 0; i < TASK_count(); i++){
+    TaskStats s;
+    TASK_getStats(i, &s);
+    emit("lamp_task_deadline_misses_total{task=\"%s\"} %u\n", s.name, s.misses);
+  }
+
+  gauge("lamp_heap_free_bytes", "Free heap.", ESP.getFreeHeap());
+  gauge("lamp_heap_free_min_bytes", "Lowest free heap seen since boot.", heapMin);
+  gauge("lamp_heap_max_block_bytes", "Largest free heap block.", ESP.getMaxFreeBlockSize());
+  gauge("lamp_heap_fragmentation_percent", "Heap fragmentation.", ESP.getHeapFragmentation());
+
+  gauge("lamp_light_on", "1 while the light is on or fading in.", PINCTRL_getCurrent());
+  gauge("lamp_light_level", "Perceptual brightness on the LED pin, 0 to 1023.", PINCTRL_getLevel());
+
+  gauge("lamp_ws_clients", "Connected WebSocket clients.", WS_getClientCount());
+  counter("lamp_ws_messages_in_total", "WebSocket commands received.", WS_getMsgCount());
+  counter("lamp_ws_messages_out_total", "WebSocket frames sent.", WS_getMsgOutCount());
+
+  counter("lamp_lcd_spi_bytes_total", "Bytes written to the LCD over SPI.", LCD_getSpiBytes());
+
+  gauge("lamp_ntp_synced", "1 once the time has been synced.", NTPS_hasSynced() ? 1 : 0);
+  gauge("lamp_ntp_sync_age_seconds", "Seconds since the last NTP sync.", NTPS_getSyncAgeS());
+  header("lamp_ntp_drift_ppm", "gauge", "Estimated crystal drift.");
+  emit("lamp_ntp_drift_ppm %d\n", NTPS_getDriftPpm());
+
+  gauge("lamp_wifi_gotip_milliseconds", "Time from boot to the first station IP, 0 until then.", WIFIC_getGotIpMs());
+  counter("lamp_events_dropped_total", "Events lost to a full event queue.", EVT_getDropped());
+  gauge("lamp_uptime_seconds", "Seconds since boot.", millis() / 1000);
+}
@@ -0,0 +1,13 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+
+typedef void (*MetricsWriter)(const char* text);
+
+extern void MET_recordLoop(uint32_t busyUs);            // once per loop(), a few compares and adds
+extern uint32_t MET_getLoopMaxUs(void);
+extern uint32_t MET_getHeapMin(void);                   // lowest free heap seen since boot
+extern void MET_writePrometheus(MetricsWriter write);   // every metric in the Prometheus text format, line by line
+
+#endif
@@ -3,19 +3,248 @@
  *  email: ujagaga@gmail.com
  *  
  *  GPIO management module
+ *  The button is sampled by an edge interrupt into a lock-free ring of timestamped edges.
+ *  PINCTRL_btnProcess() debounces those edges and posts click, double click and long press
+ *  gestures as EVT_BUTTON without ever waiting for the button to be released.
+ *  The light is dimmed by PWM on LED_PIN. Brightness levels are perceptual and pass through
+ *  a CIE 1931 lightness table on the way to the duty cycle, so equal steps look equal.
+ *  Fades are stepped by a Ticker and computed from the time since they started, so their
+ *  duration does not depend on how often loop() runs and the PWM itself is kept by the core.
  */
 #include <Arduino.h>
+#include <Ticker.h>
 #include "config.h"
+#include "pinctrl.h"
+#include "event_bus.h"
+#include "config_store.h"
 
-#define DEBOUNCE_MS 50
+#define DEBOUNCE_MS       50
+#define DOUBLE_CLICK_MS   300     // max gap between two clicks of a double click
+#define LONG_PRESS_MS     700
+#define HOLD_REPEAT_MS    100     // BTN_HOLD repeats while a long press is held
+#define EDGE_QUEUE_SIZE   16      // power of two
+
+#define DUTY_MAX          (1023)  // analogWriteRange
+#define CIE_STEPS         (64)    // table intervals, levels in between are interpolated
+#define FADE_TICK_MS      (10)
+#define RAMP_STEP         ((CFG_BRIGHTNESS_MAX * HOLD_REPEAT_MS) / LIGHT_RAMP_MS)
+#define RAMP_MIN_LEVEL    (16)    // ramping down stops here rather than switching off
+
+typedef struct {
+  uint32_t ms;
+  uint8_t level;
+} BtnEdge;
+
+/* CIE 1931 lightness to relative luminance, lightness 0 to 100. */
+static constexpr double cieLuminance(double lightness)
+{
+  return (lightness <= 8.0) ? (lightness / 903.3)
+                            : (((lightness + 16.0) / 116.0) * ((lightness + 16.0) / 116.0) * ((lightness + 16.0) / 116.0));
+}
+
+/* Built by the compiler, only the table ends up in flash. */
+struct CieTable{
+  uint16_t duty[CIE_STEPS + 1];
+  constexpr CieTable() : duty() {
+    for(uint8_t i = 0; i <= CIE_STEPS; i++){
+      duty[i] = (uint16_t)(cieLuminance(100.0 * i / CIE_STEPS) * DUTY_MAX + 0.5);
+    }
+  }
+};
+
+static const CieTable cie PROGMEM;
 
 static long lightOnTimestamp = 0;
 static uint8_t lightState = 0;
-static int lastReading = HIGH;
+
+/* Fade state. Ticker callbacks run from the SDK between loop() slices, never in the middle
+ * of loop code, so it is shared with the public functions without locking. */
+static Ticker fadeTicker;
+static uint16_t level = 0;          /* on the pin now */
+static uint16_t fadeFrom = 0;
+static uint16_t fadeTo = 0;         /* also the brightness reported to clients */
+static uint32_t fadeStartMs = 0;
+static uint32_t fadeMs = 0;
+static uint8_t fadeEasing = EASE_LINEAR;
+static uint16_t duty = 0;
+static uint16_t onLevel = CFG_BRIGHTNESS_MAX;   /* what toggle turns on to, saved to flash */
+static bool rampUp = false;
+static bool savePending = false;
+static uint32_t lastChangeMs = 0;
+
+/* Single producer (ISR) single consumer (loop) rings, only the owner advances its index. */
+static volatile BtnEdge edges[EDGE_QUEUE_SIZE];
+static volatile uint8_t edgeHead = 0;
+static volatile uint8_t edgeTail = 0;
+static volatile uint32_t edgeOverflows = 0;
+
+static uint8_t rawLevel = HIGH;
+static uint32_t rawSinceMs = 0;
+static uint8_t stableLevel = HIGH;
+static uint32_t pressedMs = 0;
+static uint32_t releasedMs = 0;
+static uint32_t lastHoldMs = 0;
+static uint8_t clicks = 0;
+static bool longPress = false;
+
+static void IRAM_ATTR btnIsr()
+{
+  uint8_t next = (edgeHead + 1) & (EDGE_QUEUE_SIZE - 1);
+  if(next == edgeTail){
+    edgeOverflows++;
+    return;
+  }
+  edges[edgeHead].ms = millis();
+  edges[edgeHead].level = digitalRead(BTN_PIN);
+  edgeHead = next;
+}
+
+static void pushEvent(uint8_t evt)
+{
+  EVT_post(EVT_BUTTON, evt);
+}
+
+static void onPress(uint32_t ms)
+{
+  pressedMs = ms;
+  longPress = false;
+}
+
+static void onRelease(uint32_t ms)
+{
+  if(longPress){
+    clicks = 0;
+    return;
+  }
+  clicks++;
+  releasedMs = ms;
+  if(clicks == 2){
+    pushEvent(BTN_DOUBLE_CLICK);
+    clicks = 0;
+  }
+}
 
 void PINCTRL_init(){
   pinMode(LED_PIN, OUTPUT);
+  digitalWrite(LED_PIN, LOW);
+  analogWriteRange(DUTY_MAX);
+  analogWriteFreq(LIGHT_PWM_HZ);
+  onLevel = CFG_get()->brightness;
+  if((onLevel == 0) || (onLevel > CFG_BRIGHTNESS_MAX)){
+    onLevel = CFG_BRIGHTNESS_MAX;
+  }
   pinMode(BTN_PIN, INPUT_PULLUP);
+  rawLevel = stableLevel = digitalRead(BTN_PIN);
+  attachInterrupt(digitalPinToInterrupt(BTN_PIN), btnIsr, CHANGE);
+}
+
+// --- Light ---
+static uint16_t levelToDuty(uint16_t lvl)
+{
+  uint32_t pos = ((uint32_t)lvl * CIE_STEPS * 256) / CFG_BRIGHTNESS_MAX;
+  uint8_t i = pos >> 8;
+  if(i >= CIE_STEPS){
+    return pgm_read_word(&cie.duty[CIE_STEPS]);
+  }
+  uint16_t a = pgm_read_word(&cie.duty[i]);
+  uint16_t b = pgm_read_word(&cie.duty[i + 1]);
+  uint16_t d = a + (((uint32_t)(b - a) * (pos & 0xFF)) >> 8);
+  /* The darkest levels round to zero, keep them visibly on. */
+  return ((d == 0) && (lvl > 0)) ? 1 : d;
+}
+
+/* Progress t and the result are 16 bit fractions. */
+static uint32_t ease(uint32_t t, uint8_t easing)
+{
+  switch(easing){
+    case EASE_IN_OUT:
+      return (uint32_t)(((uint64_t)t * t * (3 * 65536ULL - 2 * t)) >> 32);
+    case EASE_OUT:
+      return (uint32_t)(((uint64_t)t * (2 * 65536ULL - t)) >> 16);
+  }
+  return t;
+}
+
+static void writeLevel(uint16_t lvl)
+{
+  level = lvl;
+  uint16_t d = levelToDuty(lvl);
+  if(d != duty){
+    duty = d;
+    analogWrite(LED_PIN, duty);
+  }
+}
+
+static void fadeStep(void)
+{
+  uint32_t elapsed = millis() - fadeStartMs;
+  if(elapsed >= fadeMs){
+    fadeTicker.detach();
+    writeLevel(fadeTo);
+    return;
+  }
+  uint32_t t = (uint32_t)(((uint64_t)elapsed << 16) / fadeMs);
+  int32_t span = (int32_t)fadeTo - fadeFrom;
+  writeLevel(fadeFrom + (int32_t)(((int64_t)span * ease(t, fadeEasing)) >> 16));
+}
+
+/* Starts from wherever a running fade has got to. */
+void PINCTRL_fade(uint16_t target, uint32_t durationMs, uint8_t easing)
+{
+  uint8_t prevState = lightState;
+  uint16_t prevTarget = fadeTo;
+
+  fadeFrom = level;
+  fadeTo = min(target, (uint16_t)CFG_BRIGHTNESS_MAX);
+  fadeStartMs = millis();
+  fadeMs = min(durationMs, (uint32_t)LIGHT_FADE_MAX_MS);
+  fadeEasing = (easing < EASE_COUNT) ? easing : EASE_LINEAR;
+
+  if((fadeMs == 0) || (fadeFrom == fadeTo)){
+    fadeTicker.detach();
+    writeLevel(fadeTo);
+  }else if(!fadeTicker.active()){
+    fadeTicker.attach_ms(FADE_TICK_MS, fadeStep);
+  }
+
+  lightState = (fadeTo > 0) ? 1 : 0;
+  if(fadeTo > 0){
+    onLevel = fadeTo;
+  }
+  if(lightState != prevState){
+    EVT_post(EVT_LIGHT_CHANGED, lightState);
+  }
+  if(fadeTo != prevTarget){
+    EVT_post(EVT_LEVEL_CHANGED, fadeTo);
+    savePending = true;
+    lastChangeMs = fadeStartMs;
+  }
+}
+
+void PINCTRL_setBrightness(uint16_t target)
+{
+  PINCTRL_fade(target, LIGHT_FADE_MS, EASE_IN_OUT);
+}
+
+/* Each long press reverses the direction, except that from off or the ends there is only one way. */
+void PINCTRL_rampStart()
+{
+  if((lightState == 0) || (fadeTo <= RAMP_MIN_LEVEL)){
+    rampUp = true;
+  }else if(fadeTo >= CFG_BRIGHTNESS_MAX){
+    rampUp = false;
+  }else{
+    rampUp = !rampUp;
+  }
+  PINCTRL_rampStep();
+}
+
+/* Every step fades linearly over one hold period, so the steps join into one smooth ramp. */
+void PINCTRL_rampStep()
+{
+  int32_t next = (int32_t)fadeTo + (rampUp ? RAMP_STEP : -RAMP_STEP);
+  next = constrain(next, (int32_t)RAMP_MIN_LEVEL, (int32_t)CFG_BRIGHTNESS_MAX);
+  PINCTRL_fade(next, HOLD_REPEAT_MS, EASE_LINEAR);
 }
 
 uint8_t PINCTRL_toggle()
@@ -24,33 +253,90 @@ uint8_t PINCTRL_toggle()
     return lightState;
   }  
 
-  if(lightState == 0){
-    lightState = 1;
-    digitalWrite(LED_PIN, HIGH);
-  }else{
-    lightState = 0;
-    digitalWrite(LED_PIN, LOW);
-  }
-  
+  PINCTRL_setBrightness(lightState ? 0 : onLevel);
   lightOnTimestamp = millis();
   return lightState;
 }
 
+/* Unlike toggle, setting a state is idempotent, so repeated requests need no lockout. */
+uint8_t PINCTRL_set(uint8_t state)
+{
+  if((state != 0) != (lightState != 0)){
+    PINCTRL_setBrightness(state ? onLevel : 0);
+  }
+  return lightState;
+}
+
 uint8_t PINCTRL_getCurrent()
 {    
   return lightState; 
 }
 
-uint8_t PINCTRL_btnPressed() { 
+uint16_t PINCTRL_getBrightness()
+{
+  return fadeTo;
+}
 
-  int retVal = 255;
-  if (digitalRead(BTN_PIN) == LOW) {      
-    retVal = PINCTRL_toggle();        
-  }
+uint16_t PINCTRL_getLevel()
+{
+  return level;
+}
 
-  while(digitalRead(BTN_PIN) == LOW){
-    delay(10);
+/* Flash is only written once the level has settled, not on every step of a ramp. */
+void PINCTRL_lightProcess()
+{
+  if(savePending && ((millis() - lastChangeMs) >= LIGHT_SAVE_DELAY_MS)){
+    savePending = false;
+    CfgData* cfg = CFG_get();
+    if(cfg->brightness != onLevel){
+      cfg->brightness = onLevel;
+      CFG_save();
+    }
   }
-  return retVal;
 }
 
+void PINCTRL_btnProcess()
+{
+  uint32_t now = millis();
+
+  while(edgeTail != edgeHead){
+    rawLevel = edges[edgeTail].level;
+    rawSinceMs = edges[edgeTail].ms;
+    edgeTail = (edgeTail + 1) & (EDGE_QUEUE_SIZE - 1);
+  }
+
+  /* Resync if edges were lost to a full queue. */
+  if(edgeOverflows > 0){
+    edgeOverflows = 0;
+    uint8_t pinLevel = digitalRead(BTN_PIN);
+    if(pinLevel != rawLevel){
+      rawLevel = pinLevel;
+      rawSinceMs = now;
+    }
+  }
+
+  /* A level counts once it has been stable for DEBOUNCE_MS, bounces in between are ignored. */
+  if((rawLevel != stableLevel) && ((now - rawSinceMs) >= DEBOUNCE_MS)){
+    stableLevel = rawLevel;
+    if(stableLevel == LOW){
+      onPress(rawSinceMs);
+    }else{
+      onRelease(rawSinceMs);
+    }
+  }
+
+  if(stableLevel == LOW){
+    if(!longPress && ((now - pressedMs) >= LONG_PRESS_MS)){
+      longPress = true;
+      clicks = 0;
+      lastHoldMs = now;
+      pushEvent(BTN_LONG_PRESS);
+    }else if(longPress && ((now - lastHoldMs) >= HOLD_REPEAT_MS)){
+      lastHoldMs = now;
+      pushEvent(BTN_HOLD);
+    }
+  }else if((clicks == 1) && ((now - releasedMs) >= DOUBLE_CLICK_MS)){
+    clicks = 0;
+    pushEvent(BTN_CLICK);
+  }
+}
@@ -1,9 +1,31 @@
 #ifndef PINCTRL_H
 #define PINCTRL_H
 
+#define BTN_NONE          0
+#define BTN_CLICK         1
+#define BTN_DOUBLE_CLICK  2
+#define BTN_LONG_PRESS    3     // button held past the long press time
+#define BTN_HOLD          4     // repeats while a long press is held, e.g. for ramping
+
+#define EASE_LINEAR       0
+#define EASE_IN_OUT       1     // starts and ends slowly
+#define EASE_OUT          2     // starts fast and slows down towards the target
+#define EASE_COUNT        3
+
+#define LIGHT_FADE_MAX_MS (3600000UL)   // an hour, long enough for a wake-up ramp
+
+/* Brightness levels are perceptual, 0 (off) to CFG_BRIGHTNESS_MAX, and fade in the background. */
 extern uint8_t PINCTRL_toggle(void);
+extern uint8_t PINCTRL_set(uint8_t state);
+extern void PINCTRL_setBrightness(uint16_t level);                                 // fades in LIGHT_FADE_MS
+extern void PINCTRL_fade(uint16_t level, uint32_t durationMs, uint8_t easing);
+extern void PINCTRL_rampStart(void);      // long press: picks the ramp direction and takes the first step
+extern void PINCTRL_rampStep(void);       // each BTN_HOLD of that press
 extern void PINCTRL_init(void);
 extern uint8_t PINCTRL_getCurrent(void);
-extern uint8_t PINCTRL_btnPressed(void);
+extern uint16_t PINCTRL_getBrightness(void);  // level being faded to, 0 when off
+extern uint16_t PINCTRL_getLevel(void);       // level on the pin right now
+extern void PINCTRL_btnProcess(void);     // call often from loop(), never blocks, gestures are posted as EVT_BUTTON
+extern void PINCTRL_lightProcess(void);   // saves the brightness once it has settled
 
 #endif
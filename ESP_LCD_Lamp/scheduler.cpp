@@ -0,0 +1,164 @@
+/* 
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *  
+ *  Cooperative task scheduler.
+ *  Every service is a task with its own period, start deadline and priority. TASK_run() runs each
+ *  due task once, most urgent first, and sleeps in delay() until the next one is due, which lets
+ *  the SDK service WiFi and use its automatic modem sleep instead of spinning in loop().
+ */
+#include <Arduino.h>
+#include "scheduler.h"
+#include "logger.h"
+
+#define TASK_MAX_IDLE_MS    (10)
+#define LOAD_WINDOW_MS      (1000)
+
+typedef struct{
+  const char* name;
+  TaskFn fn;
+  uint32_t periodMs;
+  uint32_t deadlineMs;
+  uint8_t priority;
+  uint32_t dueMs;
+  uint32_t runs;
+  uint64_t totalUs;
+  uint32_t maxUs;
+  uint32_t misses;
+}Task;
+
+static Task tasks[TASK_MAX];
+static uint8_t taskCount = 0;
+static uint32_t busyUs = 0;
+static uint32_t loadWindowMs = 0;
+static uint8_t loadPercent = 0;
+
+int8_t TASK_add(const char* name, TaskFn fn, uint32_t periodMs, uint32_t deadlineMs, uint8_t priority)
+{
+  if(taskCount >= TASK_MAX){
+    return -1;
+  }
+  Task* t = &tasks[taskCount];
+  memset(t, 0, sizeof(Task));
+  t->name = name;
+  t->fn = fn;
+  t->periodMs = (periodMs > 0) ? periodMs : 1;
+  t->deadlineMs = deadlineMs;
+  t->priority = priority;
+  t->dueMs = millis();
+  return taskCount++;
+}
+
+void TASK_setPeriod(int8_t id, uint32_t periodMs)
+{
+  if((id >= 0) && (id < taskCount)){
+    tasks[id].periodMs = (periodMs > 0) ? periodMs : 1;
+  }
+}
+
+/* The due task with the lowest priority value, earliest due time on a tie. */
+static Task* nextDue(uint32_t now, uint32_t ranMask)
+{
+  Task* best = nullptr;
+  for(uint8_t i = 0; i < taskCount; i++){
+    Task* t = &tasks[i];
+    if((ranMask & (1UL << i)) || ((int32_t)(now - t->dueMs) < 0)){
+      continue;
+    }
+    if((best == nullptr) || (t->priority < best->priority) ||
+       ((t->priority == best->priority) && ((int32_t)(t->dueMs - best->dueMs) < 0))){
+      best = t;
+    }
+  }
+  return best;
+}
+
+static void runTask(Task* t, uint32_t now)
+{
+  if((now - t->dueMs) > t->deadlineMs){
+    t->misses++;
+  }
+
+  uint32_t start = micros();
+  t->fn();
+  uint32_t elapsed = micros() - start;
+
+  t->runs++;
+  t->totalUs += elapsed;
+  if(elapsed > t->maxUs){
+    t->maxUs = elapsed;
+  }
+  busyUs += elapsed;
+
+  /* Keep the phase, but never try to catch up on periods that were missed entirely. */
+  t->dueMs += t->periodMs;
+  now = millis();
+  if((int32_t)(now - t->dueMs) >= 0){
+    t->dueMs = now + t->periodMs;
+  }
+}
+
+uint32_t TASK_run(void)
+{
+  uint32_t ranMask = 0;
+  uint32_t passStart = micros();
+  Task* t;
+
+  while((t = nextDue(millis(), ranMask)) != nullptr){
+    ranMask |= 1UL << (t - tasks);
+    runTask(t, millis());
+  }
+  uint32_t passUs = micros() - passStart;
+
+  uint32_t now = millis();
+  if((now - loadWindowMs) >= LOAD_WINDOW_MS){
+    loadPercent = std::min((uint32_t)100, busyUs / ((now - loadWindowMs) * 10));
+    busyUs = 0;
+    loadWindowMs = now;
+  }
+
+  /* Nothing is due, give the time to the SDK until the next task is. */
+  int32_t idleMs = TASK_MAX_IDLE_MS;
+  for(uint8_t i = 0; i < taskCount; i++){
+    int32_t wait = (int32_t)(tasks[i].dueMs - now);
+    if(wait < idleMs){
+      idleMs = wait;
+    }
+  }
+  if(idleMs > 0){
+    delay(idleMs);
+  }else{
+    yield();
+  }
+  return passUs;
+}
+
+uint8_t TASK_count(void)
+{
+  return taskCount;
+}
+
+void TASK_getStats(uint8_t id, TaskStats* stats)
+{
+  const Task* t = &tasks[id];
+  stats->name = t->name;
+  stats->runs = t->runs;
+  stats->avgUs = t->runs ? (uint32_t)(t->totalUs / t->runs) : 0;
+  stats->totalUs = t->totalUs;
+  stats->maxUs = t->maxUs;
+  stats->misses = t->misses;
+}
+
+uint8_t TASK_getLoadPercent(void)
+{
+  return loadPercent;
+}
+
+void TASK_printStats(void)
+{
+  LOG_I(LOG_MOD_TASK, "load %u%%", loadPercent);
+  for(uint8_t i = 0; i < taskCount; i++){
+    LOG_I(LOG_MOD_TASK, "%-6s avg %u us, max %u us, %u missed", tasks[i].name,
+          tasks[i].runs ? (uint32_t)(tasks[i].totalUs / tasks[i].runs) : 0, tasks[i].maxUs, tasks[i].misses);
+  }
+}
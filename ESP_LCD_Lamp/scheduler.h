@@ -0,0 +1,30 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+#define TASK_MAX          (12)
+
+typedef void (*TaskFn)(void);
+
+typedef struct{
+  const char* name;
+  uint32_t runs;
+  uint32_t avgUs;
+  uint64_t totalUs;
+  uint32_t maxUs;
+  uint32_t misses;        // runs that started later than the deadline after their due time
+}TaskStats;
+
+/* Lower priority value runs first when several tasks are due. The deadline is how late
+ * after its due time a task may start before the run counts as a miss. Returns the task id or -1. */
+extern int8_t TASK_add(const char* name, TaskFn fn, uint32_t periodMs, uint32_t deadlineMs, uint8_t priority);
+extern void TASK_setPeriod(int8_t id, uint32_t periodMs);
+extern uint32_t TASK_run(void);                        // call from loop(), runs every due task once, idles if none is due.
+                                                       // Returns the time spent in tasks, not counting the idle wait.
+extern uint8_t TASK_count(void);
+extern void TASK_getStats(uint8_t id, TaskStats* stats);
+extern uint8_t TASK_getLoadPercent(void);              // time spent in tasks during the last second
+extern void TASK_printStats(void);                     // to the log
+
+#endif
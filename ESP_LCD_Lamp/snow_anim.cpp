@@ -0,0 +1,228 @@
+/* 
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *  
+ *  Falling snow around the clock digits.
+ *  Flakes fall in the gutters left and right of the clock face, so they never touch the digits.
+ *  Each frame has a time budget. A moving flake erases only the strip of its old box that the
+ *  new box does not cover. Frames are dropped, not queued, when the network is busy or the
+ *  loop falls behind.
+ */
+#include <Arduino.h>
+#include "config.h"
+#include "lcd_display.h"
+#include "snow_anim.h"
+
+#define LANES             2
+#define FLAKES_PER_LANE   3
+#define FLAKES            (LANES * FLAKES_PER_LANE)
+#define FLAKE_R           10
+#define ROTATION_STEP     15          // degrees, sprites are cached per step
+#define SPAWN_GAP_MIN     10          // pixels between flakes in a lane
+#define SPAWN_GAP_MAX     60
+#define NET_BUSY_US       1000        // a network pass longer than this counts as load
+#define NET_BACKOFF_MS    200         // frames dropped for this long after network load
+#define FRAME_MS          (1000 / ANIM_FPS)
+
+typedef struct {
+  int16_t x;            // lane centre
+  uint16_t speed;       // pixels per second
+} Lane;
+
+typedef struct {
+  uint8_t lane;
+  bool falling;         // false while parked above the screen waiting for room in the lane
+  uint8_t gap;          // distance to keep from the previous flake before starting to fall
+  int32_t yQ8;          // centre, 1/256 pixel
+  uint16_t angle;       // degrees * 16
+  int16_t spin;         // degrees per second
+  int16_t drawnY;       // top of the box on screen
+  uint8_t drawnRot;
+  bool drawn;
+  uint32_t lastMs;
+} Flake;
+
+static Lane lanes[LANES];
+static Flake flakes[FLAKES];
+static uint8_t extent = 0;
+static uint8_t size = 0;
+static bool lanesValid = false;
+static uint16_t screenId = 0;
+static uint8_t cursor = 0;            /* first flake to update next frame, so an over budget frame does not starve the rest */
+static uint32_t nextFrameMs = 0;
+static uint32_t netBusyUntilMs = 0;
+static uint32_t fpsWindowMs = 0;
+static uint8_t framesInWindow = 0;
+static uint8_t fps = 0;
+static uint32_t worstFrameUs = 0;
+static uint32_t droppedFrames = 0;
+
+static void setupLanes()
+{
+  int16_t cx, cy, cw, ch;
+  LCD_getClockBounds(&cx, &cy, &cw, &ch);
+
+  const Sprite* sprite = SPRITE_snowflake(FLAKE_R, 0);
+  extent = sprite->extent;
+  size = sprite->size;
+
+  lanes[0].x = cx / 2;
+  lanes[0].speed = 25;
+  lanes[1].x = (cx + cw + LCD_W) / 2;
+  lanes[1].speed = 35;
+
+  /* Both gutters have to be wide enough for a whole flake. */
+  lanesValid = (lanes[0].x - extent >= 0) && (lanes[0].x + extent < cx) &&
+               (lanes[1].x - extent >= cx + cw) && (lanes[1].x + extent < LCD_W);
+}
+
+static void resetFlakes()
+{
+  for(uint8_t i = 0; i < FLAKES; i++){
+    flakes[i].lane = i % LANES;
+    flakes[i].falling = false;
+    flakes[i].gap = random(SPAWN_GAP_MIN, SPAWN_GAP_MAX);
+    flakes[i].drawn = false;
+    flakes[i].spin = random(-90, 90);
+    flakes[i].angle = random(0, 60) * 16;
+  }
+}
+
+/* A parked flake starts falling once the previous flake in its lane is far enough down. */
+static bool laneHasRoom(uint8_t lane, uint16_t gap)
+{
+  for(uint8_t i = 0; i < FLAKES; i++){
+    if((flakes[i].lane == lane) && flakes[i].falling && ((flakes[i].yQ8 >> 8) - extent < size + gap)){
+      return false;
+    }
+  }
+  return true;
+}
+
+static void stepFlake(Flake* f, uint32_t now)
+{
+  const Lane* lane = &lanes[f->lane];
+  uint32_t dt = now - f->lastMs;
+  f->lastMs = now;
+
+  if(!f->falling){
+    if(!laneHasRoom(f->lane, f->gap)){
+      return;
+    }
+    f->falling = true;
+    f->yQ8 = -(int32_t)extent << 8;
+    return;
+  }
+
+  f->yQ8 += ((int32_t)lane->speed * dt << 8) / 1000;
+  int32_t turn = (f->spin * 16 * (int32_t)dt / 1000) % (60 * 16);
+  f->angle = (f->angle + 60 * 16 + turn) % (60 * 16);
+
+  int16_t top = (f->yQ8 >> 8) - extent;
+  uint8_t rot = (f->angle / 16 / ROTATION_STEP) * ROTATION_STEP;
+
+  if(top >= LCD_H){
+    if(f->drawn){
+      LCD_fillRect(lane->x - extent, f->drawnY, size, size, C_BLACK);
+    }
+    f->drawn = false;
+    f->falling = false;
+    f->gap = random(SPAWN_GAP_MIN, SPAWN_GAP_MAX);
+    return;
+  }
+
+  if(f->drawn && (top == f->drawnY) && (rot == f->drawnRot)){
+    return;
+  }
+
+  if(f->drawn && (top > f->drawnY)){
+    LCD_fillRect(lane->x - extent, f->drawnY, size, min((int16_t)(top - f->drawnY), (int16_t)size), C_BLACK);
+  }
+  LCD_drawSprite(lane->x, top + extent, SPRITE_snowflake(FLAKE_R, rot), C_WHITE);
+  f->drawnY = top;
+  f->drawnRot = rot;
+  f->drawn = true;
+}
+
+void ANIM_init()
+{
+  resetFlakes();
+  fpsWindowMs = millis();
+}
+
+void ANIM_networkLoad(uint32_t busyUs)
+{
+  if(busyUs > NET_BUSY_US){
+    netBusyUntilMs = millis() + NET_BACKOFF_MS;
+  }
+}
+
+void ANIM_process()
+{
+#if ANIM_SNOW
+  uint32_t now = millis();
+
+  if(!LCD_isClockShown()){
+    return;
+  }
+
+  if(LCD_getScreenId() != screenId){
+    /* The clock face was redrawn from scratch, nothing of ours is on screen any more. */
+    screenId = LCD_getScreenId();
+    setupLanes();
+    resetFlakes();
+    for(uint8_t i = 0; i < FLAKES; i++){
+      flakes[i].lastMs = now;
+    }
+    nextFrameMs = now;
+  }
+
+  if(!lanesValid || ((int32_t)(now - nextFrameMs) < 0)){
+    return;
+  }
+
+  if(now - fpsWindowMs >= 1000){
+    fps = framesInWindow;
+    framesInWindow = 0;
+    fpsWindowMs = now;
+  }
+
+  bool late = (now - nextFrameMs) > FRAME_MS;
+  nextFrameMs = late ? now + FRAME_MS : nextFrameMs + FRAME_MS;
+  if(late || ((int32_t)(now - netBusyUntilMs) < 0)){
+    droppedFrames++;
+    return;
+  }
+
+  uint32_t start = micros();
+  for(uint8_t i = 0; i < FLAKES; i++){
+    uint8_t idx = (cursor + i) % FLAKES;
+    if((i > 0) && (micros() - start > ANIM_FRAME_BUDGET_US)){
+      cursor = idx;
+      break;
+    }
+    stepFlake(&flakes[idx], now);
+  }
+
+  uint32_t frameUs = micros() - start;
+  if(frameUs > worstFrameUs){
+    worstFrameUs = frameUs;
+  }
+  framesInWindow++;
+#endif
+}
+
+uint8_t ANIM_getFps()
+{
+  return fps;
+}
+
+uint32_t ANIM_getWorstFrameUs()
+{
+  return worstFrameUs;
+}
+
+uint32_t ANIM_getDroppedFrames()
+{
+  return droppedFrames;
+}
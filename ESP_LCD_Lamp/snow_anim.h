@@ -0,0 +1,11 @@
+#ifndef SNOW_ANIM_H
+#define SNOW_ANIM_H
+
+extern void ANIM_init(void);
+extern void ANIM_process(void);                       // call often from loop(), draws at most one frame
+extern void ANIM_networkLoad(uint32_t busyUs);        // time the last network service pass took
+extern uint8_t ANIM_getFps(void);                     // frames drawn during the last second
+extern uint32_t ANIM_getWorstFrameUs(void);
+extern uint32_t ANIM_getDroppedFrames(void);
+
+#endif
@@ -0,0 +1,180 @@
+/* 
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *  
+ *  Vector sprites in fixed point.
+ *  Shapes are described as line lists built from a compile time sine table, rasterized once
+ *  per radius and rotation into a 1bpp bitmap and kept in a small cache, so the display
+ *  can push each sprite as a single address window.
+ */
+#include <Arduino.h>
+#include "sprite.h"
+
+#define Q14               14
+#define Q14_ONE           (1 << Q14)
+#define CACHE_SLOTS       6
+#define FLAKE_ARMS        6
+#define FLAKE_LINES       (FLAKE_ARMS * 5)    // main arm and two pairs of side branches
+#define FLAKE_BRANCH_LEN  102                 // 0.4 of radius, Q8
+#define FLAKE_BRANCH_1    141                 // first branch at 0.55 of radius, Q8
+#define FLAKE_BRANCH_2    205                 // second branch at 0.8 of radius, Q8
+
+typedef struct {
+  int8_t x0;
+  int8_t y0;
+  int8_t x1;
+  int8_t y1;
+} SpriteLine;
+
+/* sin(0..90 degrees) in Q14, evaluated by the compiler with a Taylor series. */
+struct SineTable {
+  int16_t q14[91];
+
+  constexpr SineTable() : q14() {
+    for(int deg = 0; deg <= 90; deg++){
+      double x = deg * 3.14159265358979323846 / 180.0;
+      double term = x;
+      double sum = x;
+      for(int n = 1; n < 10; n++){
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+      }
+      q14[deg] = (int16_t)(sum * Q14_ONE + 0.5);
+    }
+  }
+};
+
+static constexpr SineTable SINE = SineTable();
+static Sprite cache[CACHE_SLOTS];
+static uint32_t useCounter = 0;
+
+int16_t SPRITE_sin(int16_t deg)
+{
+  deg %= 360;
+  if(deg < 0){
+    deg += 360;
+  }
+  if(deg <= 90){
+    return SINE.q14[deg];
+  }
+  if(deg <= 180){
+    return SINE.q14[180 - deg];
+  }
+  if(deg <= 270){
+    return -SINE.q14[deg - 180];
+  }
+  return -SINE.q14[360 - deg];
+}
+
+int16_t SPRITE_cos(int16_t deg)
+{
+  return SPRITE_sin(deg + 90);
+}
+
+/* Point at distance len (Q8 of radius r) and angle deg from (x, y), rounded to the nearest pixel. */
+static void polar(int16_t x, int16_t y, int16_t r, int16_t len, int16_t deg, int8_t* px, int8_t* py)
+{
+  int32_t d = (int32_t)r * len;   // Q8
+  *px = x + (int16_t)((d * SPRITE_cos(deg) + (1L << (Q14 + 7))) >> (Q14 + 8));
+  *py = y + (int16_t)((d * SPRITE_sin(deg) + (1L << (Q14 + 7))) >> (Q14 + 8));
+}
+
+static uint8_t snowflakeLines(uint8_t r, uint8_t rotation, SpriteLine* lines)
+{
+  const int16_t branches[2] = {FLAKE_BRANCH_1, FLAKE_BRANCH_2};
+  uint8_t n = 0;
+
+  for(uint8_t i = 0; i < FLAKE_ARMS; i++){
+    int16_t ang = i * 60 + rotation;
+
+    lines[n].x0 = 0;
+    lines[n].y0 = 0;
+    polar(0, 0, r, 256, ang, &lines[n].x1, &lines[n].y1);
+    n++;
+
+    for(uint8_t b = 0; b < 2; b++){
+      int8_t bx, by;
+      polar(0, 0, r, branches[b], ang, &bx, &by);
+      for(int8_t side = -1; side <= 1; side += 2){
+        lines[n].x0 = bx;
+        lines[n].y0 = by;
+        polar(bx, by, r, FLAKE_BRANCH_LEN, ang + side * 30, &lines[n].x1, &lines[n].y1);
+        n++;
+      }
+    }
+  }
+  return n;
+}
+
+static inline void setPixel(Sprite* s, int16_t x, int16_t y)
+{
+  if((x >= 0) && (y >= 0) && (x < s->size) && (y < s->size)){
+    s->bits[y * s->stride + (x >> 3)] |= 0x80 >> (x & 7);
+  }
+}
+
+/* Integer Bresenham, coordinates relative to the sprite centre. */
+static void rasterizeLine(Sprite* s, const SpriteLine* l)
+{
+  int16_t x = l->x0 + s->extent;
+  int16_t y = l->y0 + s->extent;
+  int16_t x1 = l->x1 + s->extent;
+  int16_t y1 = l->y1 + s->extent;
+  int16_t dx = abs(x1 - x);
+  int16_t dy = -abs(y1 - y);
+  int8_t sx = (x < x1) ? 1 : -1;
+  int8_t sy = (y < y1) ? 1 : -1;
+  int16_t err = dx + dy;
+
+  while(true){
+    setPixel(s, x, y);
+    if((x == x1) && (y == y1)){
+      break;
+    }
+    int16_t e2 = 2 * err;
+    if(e2 >= dy){
+      err += dy;
+      x += sx;
+    }
+    if(e2 <= dx){
+      err += dx;
+      y += sy;
+    }
+  }
+}
+
+const Sprite* SPRITE_snowflake(uint8_t radius, uint8_t rotation)
+{
+  Sprite* slot = &cache[0];
+
+  if(radius > SPRITE_MAX_R){
+    radius = SPRITE_MAX_R;
+  }
+  rotation %= 60;
+  useCounter++;
+
+  for(uint8_t i = 0; i < CACHE_SLOTS; i++){
+    if((cache[i].size != 0) && (cache[i].radius == radius) && (cache[i].rotation == rotation)){
+      cache[i].lastUse = useCounter;
+      return &cache[i];
+    }
+    if(cache[i].lastUse < slot->lastUse){
+      slot = &cache[i];
+    }
+  }
+
+  SpriteLine lines[FLAKE_LINES];
+  uint8_t n = snowflakeLines(radius, rotation, lines);
+
+  slot->radius = radius;
+  slot->rotation = rotation;
+  slot->extent = SPRITE_EXTENT(radius);
+  slot->size = 2 * slot->extent + 1;
+  slot->stride = (slot->size + 7) / 8;
+  slot->lastUse = useCounter;
+  memset(slot->bits, 0, sizeof(slot->bits));
+  for(uint8_t i = 0; i < n; i++){
+    rasterizeLine(slot, &lines[i]);
+  }
+  return slot;
+}
@@ -0,0 +1,24 @@
+#ifndef SPRITE_H
+#define SPRITE_H
+
+#define SPRITE_MAX_R      25                        // largest cached sprite radius
+#define SPRITE_EXTENT(r)  (((r) * 300 + 255) >> 8)  // side branches reach about 1.16 r from the centre
+#define SPRITE_MAX_SIZE   (2 * SPRITE_EXTENT(SPRITE_MAX_R) + 1)
+#define SPRITE_MAX_STRIDE ((SPRITE_MAX_SIZE + 7) / 8)
+
+/* 1bpp square bitmap, rows packed MSB first. The sprite centre is at (extent, extent). */
+typedef struct {
+  uint8_t radius;
+  uint8_t extent;       // distance from the centre to the bitmap edge
+  uint8_t rotation;     // degrees, 0-59 since the shapes have 60 degree symmetry
+  uint8_t size;         // width and height in pixels
+  uint8_t stride;       // bytes per row
+  uint32_t lastUse;
+  uint8_t bits[SPRITE_MAX_SIZE * SPRITE_MAX_STRIDE];
+} Sprite;
+
+extern int16_t SPRITE_sin(int16_t deg);                                  // Q14 fixed point
+extern int16_t SPRITE_cos(int16_t deg);                                  // Q14 fixed point
+extern const Sprite* SPRITE_snowflake(uint8_t radius, uint8_t rotation); // rasterized on first use, then cached
+
+#endif
@@ -0,0 +1,244 @@
+/* 
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *  
+ *  Compiled table of common IANA time zones.
+ *  The selected zone is kept in the config store. Conversion caches the UTC epochs of
+ *  the DST transitions of the current year, so UTC to local is a range check and an add.
+ */
+#include <Arduino.h>
+#include "config.h"
+#include "config_store.h"
+#include "logger.h"
+#include "timezones.h"
+
+#define LAST          0       // week value for "last <dow> of the month"
+#define NO_DST        {0, 0, 0, 0}
+#define SUN           1
+#define DAY_S         86400L
+
+/* Same meaning as the Timezone library TimeChangeRule: the change happens at `hour`
+ * local time, counted in the offset that is in effect before the change. */
+typedef struct {
+  uint8_t week;         // 1-4, or LAST
+  uint8_t dow;          // 1 = Sunday
+  uint8_t month;        // 1-12, 0 = zone has no DST
+  uint8_t hour;
+} TzRule;
+
+typedef struct {
+  char name[TZ_NAME_SIZE];
+  int16_t stdOffset;    // minutes east of UTC
+  int16_t dstOffset;
+  TzRule dstStart;
+  TzRule dstEnd;
+} TzZone;
+
+#define EU_WESTERN    0, 60, {LAST, SUN, 3, 1}, {LAST, SUN, 10, 2}
+#define EU_CENTRAL    60, 120, {LAST, SUN, 3, 2}, {LAST, SUN, 10, 3}
+#define EU_EASTERN    120, 180, {LAST, SUN, 3, 3}, {LAST, SUN, 10, 4}
+#define US_RULES      {2, SUN, 3, 2}, {1, SUN, 11, 2}
+#define AU_RULES      {1, SUN, 10, 2}, {1, SUN, 4, 3}
+
+static const TzZone ZONES[] PROGMEM = {
+  {"UTC",                    0,    0,    NO_DST, NO_DST},
+  {"Europe/London",          EU_WESTERN},
+  {"Europe/Dublin",          EU_WESTERN},
+  {"Europe/Lisbon",          EU_WESTERN},
+  {"Europe/Belgrade",        EU_CENTRAL},
+  {"Europe/Zagreb",          EU_CENTRAL},
+  {"Europe/Budapest",        EU_CENTRAL},
+  {"Europe/Vienna",          EU_CENTRAL},
+  {"Europe/Berlin",          EU_CENTRAL},
+  {"Europe/Paris",           EU_CENTRAL},
+  {"Europe/Rome",            EU_CENTRAL},
+  {"Europe/Madrid",          EU_CENTRAL},
+  {"Europe/Amsterdam",       EU_CENTRAL},
+  {"Europe/Prague",          EU_CENTRAL},
+  {"Europe/Warsaw",          EU_CENTRAL},
+  {"Europe/Stockholm",       EU_CENTRAL},
+  {"Europe/Athens",          EU_EASTERN},
+  {"Europe/Bucharest",       EU_EASTERN},
+  {"Europe/Sofia",           EU_EASTERN},
+  {"Europe/Helsinki",        EU_EASTERN},
+  {"Europe/Kyiv",            EU_EASTERN},
+  {"Europe/Istanbul",        180,  180,  NO_DST, NO_DST},
+  {"Europe/Moscow",          180,  180,  NO_DST, NO_DST},
+  {"America/New_York",       -300, -240, US_RULES},
+  {"America/Toronto",        -300, -240, US_RULES},
+  {"America/Chicago",        -360, -300, US_RULES},
+  {"America/Denver",         -420, -360, US_RULES},
+  {"America/Phoenix",        -420, -420, NO_DST, NO_DST},
+  {"America/Los_Angeles",    -480, -420, US_RULES},
+  {"America/Vancouver",      -480, -420, US_RULES},
+  {"America/Anchorage",      -540, -480, US_RULES},
+  {"Pacific/Honolulu",       -600, -600, NO_DST, NO_DST},
+  {"America/Sao_Paulo",      -180, -180, NO_DST, NO_DST},
+  {"Asia/Dubai",             240,  240,  NO_DST, NO_DST},
+  {"Asia/Kolkata",           330,  330,  NO_DST, NO_DST},
+  {"Asia/Singapore",         480,  480,  NO_DST, NO_DST},
+  {"Asia/Shanghai",          480,  480,  NO_DST, NO_DST},
+  {"Asia/Tokyo",             540,  540,  NO_DST, NO_DST},
+  {"Australia/Perth",        480,  480,  NO_DST, NO_DST},
+  {"Australia/Brisbane",     600,  600,  NO_DST, NO_DST},
+  {"Australia/Adelaide",     570,  630,  AU_RULES},
+  {"Australia/Sydney",       600,  660,  AU_RULES},
+  {"Australia/Melbourne",    600,  660,  AU_RULES},
+  {"Pacific/Auckland",       720,  780,  {LAST, SUN, 9, 2}, {1, SUN, 4, 3}}
+};
+
+#define ZONE_COUNT    (sizeof(ZONES) / sizeof(ZONES[0]))
+
+static TzZone zone;
+static PGM_P zoneNameP = nullptr;       /* the table entry name, stays valid for deferred log formatting */
+static time_t cacheFrom = 1;      /* UTC range the cached transitions are valid for, empty until first use */
+static time_t cacheTo = 0;
+static time_t dstFrom = 0;        /* dstOffset applies in [dstFrom, dstTo), stdOffset elsewhere in the cached range */
+static time_t dstTo = 0;
+static int32_t stdOffsetS = 0;
+static int32_t dstOffsetS = 0;
+static bool invertedDst = false;  /* southern hemisphere, DST spans the new year */
+
+/* Days since 1970-01-01 of a proleptic Gregorian date. */
+static int32_t daysFromCivil(int32_t y, uint8_t m, uint8_t d)
+{
+  y -= (m <= 2);
+  int32_t era = (y >= 0 ? y : y - 399) / 400;
+  uint32_t yoe = (uint32_t)(y - era * 400);
+  uint32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int32_t)doe - 719468;
+}
+
+/* Local time (as seconds since epoch) at which a rule fires in the given year. */
+static time_t ruleLocalTime(const TzRule* rule, int32_t year)
+{
+  uint8_t month = rule->month;
+  int32_t y = year;
+
+  /* "Last" is the first occurrence in the next month minus a week. */
+  if(rule->week == LAST){
+    if(++month > 12){
+      month = 1;
+      y++;
+    }
+  }
+
+  int32_t first = daysFromCivil(y, month, 1);
+  uint8_t firstDow = (uint8_t)((first % 7 + 11) % 7);   // 1970-01-01 was a Thursday, 0 = Sunday
+  int32_t day = first + (7 + (rule->dow - 1) - firstDow) % 7;
+  day += (rule->week == LAST) ? -7 : (rule->week - 1) * 7;
+  return (time_t)day * DAY_S + rule->hour * 3600L;
+}
+
+static void cacheYear(time_t utc)
+{
+  int32_t year = 1970 + (int32_t)(utc / DAY_S / 365);
+
+  /* The estimate can be a year off around new year. */
+  while((time_t)daysFromCivil(year, 1, 1) * DAY_S > utc){
+    year--;
+  }
+  while((time_t)daysFromCivil(year + 1, 1, 1) * DAY_S <= utc){
+    year++;
+  }
+
+  cacheFrom = (time_t)daysFromCivil(year, 1, 1) * DAY_S;
+  cacheTo = (time_t)daysFromCivil(year + 1, 1, 1) * DAY_S;
+
+  if(zone.dstStart.month == 0){
+    dstFrom = dstTo = cacheFrom;
+    invertedDst = false;
+    return;
+  }
+
+  time_t start = ruleLocalTime(&zone.dstStart, year) - stdOffsetS;
+  time_t end = ruleLocalTime(&zone.dstEnd, year) - dstOffsetS;
+  invertedDst = (end < start);
+  dstFrom = invertedDst ? end : start;
+  dstTo = invertedDst ? start : end;
+}
+
+static bool loadZone(const char* name)
+{
+  for(uint8_t i = 0; i < ZONE_COUNT; i++){
+    if(strncmp_P(name, ZONES[i].name, TZ_NAME_SIZE) == 0){
+      memcpy_P(&zone, &ZONES[i], sizeof(zone));
+      zoneNameP = ZONES[i].name;
+      stdOffsetS = zone.stdOffset * 60L;
+      dstOffsetS = zone.dstOffset * 60L;
+      cacheFrom = 1;
+      cacheTo = 0;
+      return true;
+    }
+  }
+  return false;
+}
+
+void TZ_init()
+{
+  if(!loadZone(CFG_get()->tz)){
+    loadZone(REGION);
+  }
+  LOG_I(LOG_MOD_TZ, "%s", zoneNameP);
+}
+
+bool TZ_set(const char* name)
+{
+  if(!loadZone(name)){
+    return false;
+  }
+
+  strcpy(CFG_get()->tz, zone.name);
+  CFG_save();
+  LOG_I(LOG_MOD_TZ, "set to %s", zoneNameP);
+  return true;
+}
+
+const char* TZ_getName()
+{
+  return zone.name;
+}
+
+time_t TZ_toLocal(time_t utc)
+{
+  if((utc < cacheFrom) || (utc >= cacheTo)){
+    cacheYear(utc);
+  }
+
+  bool inRange = (utc >= dstFrom) && (utc < dstTo);
+  return utc + ((inRange != invertedDst) ? dstOffsetS : stdOffsetS);
+}
+
+/* A wall clock time repeated when DST ends gives the earlier instant. One skipped when DST
+ * starts gives the moment of the change, the first instant the clock shows a later time. */
+time_t TZ_toUtc(time_t local)
+{
+  time_t early = local - max(stdOffsetS, dstOffsetS);
+  time_t late = local - min(stdOffsetS, dstOffsetS);
+
+  if(TZ_toLocal(early) == local){
+    return early;
+  }
+  if(TZ_toLocal(late) == local){
+    return late;
+  }
+  /* Skipped, so a change lies between the two. TZ_toLocal(late) left its year cached. */
+  if((dstFrom > early) && (dstFrom <= late)){
+    return dstFrom;
+  }
+  return dstTo;
+}
+
+uint8_t TZ_count()
+{
+  return ZONE_COUNT;
+}
+
+void TZ_getNameAt(uint8_t index, char* buf)
+{
+  buf[0] = 0;
+  if(index < ZONE_COUNT){
+    strncpy_P(buf, ZONES[index].name, TZ_NAME_SIZE);
+  }
+}
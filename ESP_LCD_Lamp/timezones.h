@@ -0,0 +1,16 @@
+#ifndef TIMEZONES_H
+#define TIMEZONES_H
+
+#include <time.h>
+
+#define TZ_NAME_SIZE  24
+
+extern void TZ_init(void);                          // loads the saved zone, falls back to REGION
+extern bool TZ_set(const char* name);               // selects and saves a zone from the table
+extern const char* TZ_getName(void);
+extern time_t TZ_toLocal(time_t utc);
+extern time_t TZ_toUtc(time_t local);              // wall clock time, see the DST notes in timezones.cpp
+extern uint8_t TZ_count(void);
+extern void TZ_getNameAt(uint8_t index, char* buf); // buf must hold TZ_NAME_SIZE bytes
+
+#endif
@@ -0,0 +1,201 @@
+/* Generated by tools/build_web.py from web/, do not edit. */
+
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+#include <pgmspace.h>
+
+typedef struct{
+  const char* path;
+  const char* contentType;
+  const uint8_t* data;     /* gzip compressed */
+  uint16_t size;
+  const char* etag;
+}WebAsset;
+
+// --- Page templates, {{NAME}} placeholders are filled while streaming ---
+/* index.html: 951 bytes */
+static const char INDEX_HTML[] PROGMEM =
+  "<!DOCTYPE HTML><html><head><meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0, maximum-scale=1.0, user-scalable=0\"><title>Secret Santa Clock</title><link rel=\"stylesheet\" href=\"/style.css?v=ded236cd\"><link rel=\"stylesheet\" href=\"/index.css?v=f6cc6844\"></head><body><div class=\"contain\"><div class=\"center_div\"><div class=\"row\"><div class=\"lightBtnOn\" id=\"tgl\" onclick=\"toggleLight();\"><span></span></div></div><input class=\"lvl\" type=\"range\" id=\"lvl\" min=\"1\" max=\"1023\" value=\"1023\" onchange=\"setLevel(this.value);\"></div><hr><a href=\"https://github.com/ujagaga/ESP_OLED_Lamp\" target=\"_blank\" rel=\"noopener noreferrer\">Source code</a><p>Station IP: {{STATION_IP}}</p><br><button class=\"btn_cfg\" type=\"button\" onclick=\"location.href='/selectap';\">Configure WiFi</button><br/><label for=\"tz\">Time zone:</label><select id=\"tz\" onchange=\"setTimezone(this.value);\"></select></div><script src=\"/index.js?v=97d30d6b\"></script></body></html>";
+
+/* redirect.html: 274 bytes */
+static const char REDIRECT_HTML[] PROGMEM =
+  "<p id=\"tmr\"></p><script>var c = 6;\n"
+  "function count() {\n"
+  "var tmr = document.getElementById('tmr');\n"
+  "if (c > 0) {\n"
+  "c--;\n"
+  "tmr.innerHTML = \"You will be redirected to home page in \" + c + \" seconds.\";\n"
+  "setTimeout(count, 1000);\n"
+  "} else {\n"
+  "window.location.href = \"/\";\n"
+  "}\n"
+  "}\n"
+  "count();</script>";
+
+/* selectap.html: 773 bytes */
+static const char SELECTAP_HTML[] PROGMEM =
+  "<!DOCTYPE HTML><html><head><meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0, maximum-scale=1.0, user-scalable=0\"><title>Secret Santa Clock</title><link rel=\"stylesheet\" href=\"/style.css?v=ded236cd\"><link rel=\"stylesheet\" href=\"/selectap.css?v=f77e43c0\"></head><body><div class=\"contain\"><div class=\"center_div\"><h1 id=\"ttl\">Networks found:</h1><div id=\"vm\">Please wait...</div><form method=\"get\" action=\"wifisave\"><button type=\"button\" onclick=\"refresh();\">Rescan</button><br/><br/><input id=\"s\" name=\"s\" maxlength=\"32\" placeholder=\"SSID (Leave blank for AP mode)\"><br><input id=\"p\" name=\"p\" maxlength=\"64\" placeholder=\"Password\"><br><br><button type=\"submit\">Save</button></form></div></div><script src=\"/selectap.js?v=5e95c4c3\"></script></body></html>";
+
+/* status.html: 302 bytes */
+static const char STATUS_HTML[] PROGMEM =
+  "<!DOCTYPE HTML><html><head><meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0, maximum-scale=1.0, user-scalable=0\"><title>Secret Santa Clock</title><link rel=\"stylesheet\" href=\"/style.css?v=ded236cd\"></head><body><h1>Connection Status</h1><p>{{STATUS}}</p>\n"
+  "{{REDIRECT}}\n"
+  "</body></html>";
+
+// --- Static assets ---
+/* index.css: 1357 bytes, 499 gzipped */
+static const uint8_t INDEX_CSS_GZ[] PROGMEM = {
+  0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x9D, 0x94, 0xDD, 0x6E, 0xA3, 0x30,
+  0x10, 0x85, 0x5F, 0x05, 0xB5, 0xEA, 0x5D, 0x41, 0x06, 0x52, 0x1A, 0xD9, 0x57, 0xE9, 0x3E, 0xC0,
+  0x3E, 0xC2, 0xCA, 0xC0, 0x18, 0xBC, 0x75, 0x6C, 0x64, 0x4C, 0x49, 0x1B, 0xF1, 0xEE, 0x6B, 0xF3,
+  0x13, 0x48, 0x60, 0xDB, 0xAA, 0x57, 0x19, 0xDB, 0x33, 0x9E, 0xEF, 0x1C, 0x4F, 0x08, 0x52, 0x23,
+  0xFF, 0xA4, 0xE7, 0x54, 0xE9, 0x1C, 0x34, 0x46, 0x64, 0x08, 0x7C, 0x4D, 0x73, 0xDE, 0xD4, 0x18,
+  0x05, 0xB1, 0x86, 0x23, 0xC9, 0x94, 0x50, 0x1A, 0xDF, 0x33, 0xC6, 0x88, 0xE0, 0x12, 0xFC, 0x12,
+  0x78, 0x51, 0x1A, 0xBC, 0x73, 0x67, 0x4C, 0x49, 0xE3, 0xD7, 0xFC, 0x03, 0x70, 0x9F, 0x7A, 0xA4,
+  0xBA, 0xE0, 0x12, 0x87, 0x0F, 0x64, 0x99, 0xD4, 0xF2, 0xDC, 0x94, 0x43, 0x98, 0xD2, 0xEC, 0xB5,
+  0xD0, 0xAA, 0x91, 0xB9, 0x3F, 0x5E, 0x1B, 0x32, 0x1A, 0x43, 0x46, 0x98, 0x80, 0x13, 0x0E, 0xBB,
+  0xC0, 0x01, 0x65, 0xAC, 0xF8, 0x19, 0x52, 0x18, 0xDC, 0x40, 0xA1, 0x60, 0xBF, 0xC4, 0xCA, 0xCA,
+  0x89, 0x2B, 0x9A, 0xB9, 0x42, 0xB4, 0x0D, 0xC6, 0x58, 0x1C, 0x23, 0xD4, 0x05, 0x5A, 0xB5, 0xE7,
+  0x9C, 0xD7, 0x95, 0xA0, 0xEF, 0xD8, 0x51, 0x92, 0xBF, 0x4D, 0x6D, 0x38, 0x7B, 0xB7, 0x79, 0xD2,
+  0x80, 0x34, 0xB8, 0xAE, 0x68, 0x06, 0x7E, 0x0A, 0xA6, 0x05, 0x90, 0x84, 0x0A, 0x5E, 0x48, 0x9F,
+  0x1B, 0x38, 0xD6, 0x38, 0xB3, 0xC7, 0xA0, 0xBB, 0x40, 0xB8, 0x9E, 0x2F, 0x46, 0xFE, 0x66, 0xEC,
+  0x71, 0x5E, 0xC8, 0xF3, 0x08, 0xB0, 0x43, 0xD5, 0x69, 0x02, 0x1B, 0x16, 0x95, 0xAA, 0xB9, 0xE1,
+  0x4A, 0x62, 0x0D, 0x82, 0x1A, 0xFE, 0x06, 0xA3, 0x04, 0x5F, 0x00, 0x33, 0x98, 0x36, 0x46, 0x4D,
+  0x1B, 0xBA, 0xAF, 0x5A, 0xEE, 0x18, 0x55, 0xE1, 0x67, 0x77, 0xC9, 0x87, 0xCF, 0x65, 0xEE, 0x5C,
+  0x45, 0xB7, 0x2E, 0x3E, 0xA1, 0x87, 0x2B, 0x28, 0x8C, 0x53, 0x60, 0x4A, 0xC3, 0xE3, 0xF5, 0x26,
+  0x65, 0x96, 0xFE, 0x6A, 0xCF, 0xB3, 0x5A, 0xE5, 0x52, 0xC2, 0x46, 0xA5, 0x5C, 0x17, 0xCA, 0xBE,
+  0xEE, 0xE2, 0x62, 0x2A, 0x54, 0xF6, 0x4A, 0x26, 0xFB, 0xEE, 0xEE, 0x66, 0xB9, 0x34, 0xAD, 0x95,
+  0x68, 0x0C, 0x7C, 0x45, 0x77, 0xE9, 0x3B, 0x59, 0x18, 0x2D, 0x2D, 0xEC, 0x17, 0xF3, 0x83, 0xDA,
+  0x7E, 0x36, 0x5E, 0x5B, 0x40, 0x9C, 0x53, 0xA1, 0xCB, 0xED, 0x5D, 0x75, 0xD1, 0x66, 0xDF, 0x69,
+  0x16, 0xA3, 0xEA, 0xE4, 0x59, 0x3C, 0x9E, 0x7B, 0xF7, 0x87, 0x5F, 0x87, 0x97, 0xC3, 0xAE, 0xDB,
+  0x02, 0x5A, 0x25, 0xB7, 0xA5, 0x1D, 0x06, 0xDB, 0xFD, 0xE4, 0xD7, 0x25, 0xCD, 0x55, 0x8B, 0x91,
+  0x87, 0x3C, 0x87, 0x38, 0x9C, 0x74, 0x9F, 0x7B, 0x3E, 0xB9, 0x39, 0x0A, 0x7D, 0x5E, 0xE8, 0xEC,
+  0x63, 0xA7, 0x21, 0x0E, 0x27, 0x0D, 0x7D, 0xF4, 0xD5, 0x5B, 0x0F, 0xF7, 0xFD, 0xC7, 0x1F, 0x9C,
+  0xCC, 0x2A, 0xF7, 0x74, 0x4F, 0x9F, 0xB2, 0x6E, 0x03, 0xE6, 0x1B, 0xC5, 0x49, 0xC2, 0x58, 0x92,
+  0x74, 0x9F, 0x4E, 0xCF, 0x30, 0x16, 0x83, 0xB2, 0xFD, 0x2C, 0x6C, 0x78, 0xBF, 0xDB, 0x1B, 0x87,
+  0x46, 0x4E, 0x6F, 0x14, 0x4D, 0x7A, 0x93, 0x68, 0x31, 0xE7, 0xBB, 0x75, 0xB3, 0x25, 0xE8, 0x86,
+  0x9C, 0x75, 0xCE, 0x85, 0xFA, 0x4D, 0xDC, 0x8C, 0xEB, 0x48, 0x69, 0xC7, 0x66, 0xFC, 0x9A, 0xB8,
+  0x4F, 0x88, 0xE7, 0xFE, 0x78, 0xF6, 0x39, 0xDD, 0x4F, 0xF7, 0x0F, 0xDB, 0x35, 0x16, 0xCC, 0x4D,
+  0x05, 0x00, 0x00,
+};
+
+/* index.js: 1215 bytes, 549 gzipped */
+static const uint8_t INDEX_JS_GZ[] PROGMEM = {
+  0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x85, 0x94, 0x4D, 0x8F, 0xDA, 0x30,
+  0x10, 0x86, 0xEF, 0xFC, 0x0A, 0x37, 0x87, 0x8D, 0x51, 0x91, 0x61, 0x7B, 0xAA, 0x82, 0xB6, 0xD2,
+  0xB2, 0x8A, 0x28, 0x15, 0x82, 0x15, 0x09, 0x5B, 0x95, 0x9B, 0xD7, 0x4C, 0x42, 0x54, 0x63, 0xA3,
+  0xD8, 0x04, 0xED, 0xA2, 0xFC, 0xF7, 0x8E, 0x93, 0xC0, 0x02, 0x55, 0xD3, 0x4B, 0x3E, 0x26, 0x7E,
+  0x5E, 0xBF, 0x33, 0x9E, 0x49, 0xC1, 0x73, 0x52, 0x40, 0x4E, 0x1E, 0xC8, 0x60, 0xD8, 0x29, 0xF0,
+  0x45, 0xA8, 0x61, 0x27, 0xD9, 0x2B, 0x61, 0x33, 0xAD, 0x88, 0xD0, 0x4A, 0x81, 0xB0, 0xB4, 0x4B,
+  0x8E, 0x1D, 0xA1, 0x70, 0x91, 0x82, 0x03, 0xF9, 0x09, 0xAF, 0x91, 0x16, 0xBF, 0xC1, 0x52, 0xFF,
+  0x60, 0x82, 0x7E, 0xDF, 0x27, 0x9F, 0x89, 0xD4, 0x82, 0x3B, 0x82, 0x6D, 0xB4, 0xB1, 0x8A, 0x6F,
+  0x01, 0x63, 0x7E, 0xF0, 0xF5, 0xBE, 0xEF, 0x77, 0x87, 0x48, 0x32, 0xAD, 0xF4, 0x0E, 0x9C, 0xC0,
+  0x49, 0xBA, 0x92, 0xCC, 0x12, 0x42, 0x71, 0xF3, 0x5A, 0x9D, 0x19, 0x50, 0x6B, 0xFA, 0x23, 0x9A,
+  0xCF, 0x98, 0xB1, 0x79, 0xA6, 0xD2, 0x2C, 0x79, 0xA3, 0xC7, 0x68, 0x39, 0x0A, 0x88, 0x2F, 0xB3,
+  0x74, 0x63, 0x7B, 0x36, 0xDB, 0x82, 0xDF, 0x23, 0xD1, 0xAF, 0xD9, 0x53, 0xE0, 0x4C, 0x97, 0x5D,
+  0x14, 0x2F, 0x09, 0x48, 0x03, 0x17, 0x0A, 0xFE, 0xD1, 0x43, 0xC8, 0x0B, 0xBC, 0x0F, 0xC8, 0xEB,
+  0x79, 0x51, 0xFC, 0x18, 0x2F, 0x23, 0x8C, 0x7A, 0x65, 0x63, 0xE9, 0xB4, 0x38, 0x5E, 0x4D, 0x27,
+  0x51, 0x7C, 0xFE, 0x52, 0x76, 0xCA, 0xC6, 0xB1, 0x90, 0x1A, 0x85, 0x6F, 0x2C, 0x1B, 0xB0, 0x31,
+  0x2A, 0xEA, 0xBD, 0xA5, 0x4D, 0x71, 0x7A, 0xE4, 0xCB, 0x60, 0x30, 0x70, 0x64, 0xC3, 0x6D, 0xC1,
+  0x18, 0x9E, 0x5E, 0x91, 0xE0, 0x50, 0x57, 0xDD, 0x35, 0xB7, 0x1C, 0x3F, 0x54, 0x59, 0xEE, 0x78,
+  0x6E, 0x80, 0x02, 0x73, 0x31, 0xC4, 0x5D, 0x31, 0xDC, 0x23, 0xDB, 0x70, 0x33, 0x3F, 0xA8, 0xE7,
+  0x1C, 0x2B, 0x96, 0xDB, 0x37, 0xEA, 0xBF, 0xF8, 0xDD, 0x0A, 0xAF, 0x4E, 0xA9, 0x5A, 0xF1, 0xE2,
+  0x6C, 0xFE, 0x73, 0x7D, 0x9D, 0x50, 0x03, 0xE1, 0x9E, 0x06, 0xA4, 0x03, 0xB5, 0xD8, 0x6F, 0x41,
+  0x59, 0x96, 0x82, 0x0D, 0x25, 0xB8, 0xC7, 0xD1, 0xDB, 0x04, 0x2B, 0x60, 0xDF, 0x5D, 0xDA, 0x95,
+  0x52, 0x4D, 0xB2, 0x44, 0xE7, 0x21, 0x17, 0x1B, 0x7A, 0xB6, 0xAF, 0x50, 0xCA, 0xC9, 0x30, 0xBE,
+  0x5E, 0x53, 0xD7, 0x02, 0xF3, 0x5D, 0x1D, 0xEF, 0x11, 0x85, 0x67, 0x40, 0xCA, 0xDB, 0x8A, 0x5E,
+  0x54, 0xB3, 0xC5, 0x66, 0x6D, 0xB1, 0xD5, 0x18, 0x2B, 0xB8, 0xDC, 0xC3, 0x29, 0xEF, 0x78, 0xD5,
+  0xAA, 0xF8, 0xB4, 0x5C, 0x2C, 0xC2, 0xD9, 0x45, 0xE6, 0x36, 0x6D, 0xCF, 0x3C, 0x95, 0xCE, 0x23,
+  0xDE, 0x98, 0x90, 0xDC, 0x98, 0x69, 0x66, 0x2C, 0xB3, 0x3A, 0x4D, 0x25, 0xD0, 0xBA, 0xE5, 0x46,
+  0x56, 0xCD, 0x93, 0x04, 0x7B, 0xAE, 0xDA, 0xAF, 0xD1, 0x27, 0x0F, 0x38, 0x2C, 0xFF, 0xE7, 0xD4,
+  0x2D, 0xF6, 0xA9, 0xC6, 0xDA, 0x4A, 0xF2, 0xB8, 0x18, 0x87, 0xE8, 0x9F, 0xDC, 0xDD, 0x35, 0x09,
+  0x57, 0x01, 0xF2, 0x0D, 0xC1, 0xB6, 0x4A, 0xC9, 0x42, 0xFE, 0x55, 0xAA, 0x8A, 0x6C, 0xDA, 0xB9,
+  0xFC, 0x98, 0xE8, 0xDA, 0xE6, 0xD4, 0x99, 0xA4, 0xDD, 0xEB, 0xA9, 0x89, 0xE7, 0xE3, 0xF1, 0x34,
+  0xF4, 0x02, 0xE2, 0xDD, 0x9F, 0x0E, 0xEF, 0x8C, 0x61, 0xDB, 0x4F, 0xA1, 0x00, 0x49, 0xA5, 0xBB,
+  0xB6, 0x0D, 0xEC, 0x68, 0x31, 0x19, 0x7F, 0x8F, 0x67, 0x61, 0x14, 0x05, 0x64, 0xB6, 0xDF, 0xBE,
+  0x42, 0xDE, 0x30, 0xF5, 0xB4, 0x5E, 0x49, 0xBA, 0x49, 0x7A, 0xD7, 0x0A, 0xA8, 0xFB, 0x63, 0xB4,
+  0x89, 0xC6, 0xAB, 0x80, 0xB8, 0x35, 0x8D, 0xC6, 0xF9, 0xB7, 0x34, 0xFC, 0x03, 0x0D, 0x36, 0x81,
+  0xEF, 0xBF, 0x04, 0x00, 0x00,
+};
+
+/* selectap.css: 347 bytes, 234 gzipped */
+static const uint8_t SELECTAP_CSS_GZ[] PROGMEM = {
+  0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x4D, 0x90, 0xDD, 0x92, 0x83, 0x20,
+  0x0C, 0x85, 0x1F, 0xA6, 0xD3, 0xBB, 0x85, 0x41, 0xAB, 0x3B, 0xB3, 0xF0, 0x34, 0x08, 0x01, 0x99,
+  0x2A, 0x71, 0x69, 0xB4, 0x3F, 0x0E, 0xEF, 0x5E, 0x6D, 0xB9, 0xF0, 0x2E, 0x93, 0x73, 0x72, 0xF2,
+  0x25, 0xDC, 0xAC, 0x04, 0x0F, 0x62, 0x7A, 0x08, 0x3E, 0x4A, 0x03, 0x91, 0x20, 0x65, 0x1B, 0x96,
+  0x9F, 0x10, 0xA7, 0x99, 0xD6, 0x49, 0x5B, 0x1B, 0xA2, 0x97, 0xED, 0xF4, 0x50, 0x0E, 0x23, 0xB1,
+  0x5B, 0x78, 0x81, 0xAC, 0x60, 0xCC, 0x5F, 0xFD, 0x1E, 0x2C, 0xF5, 0xF2, 0xAF, 0x3D, 0xE7, 0x0E,
+  0xED, 0xF3, 0x18, 0x35, 0x80, 0xA3, 0xDC, 0xCD, 0x44, 0x18, 0x8B, 0xAB, 0x12, 0xE2, 0xAC, 0x3A,
+  0x4C, 0x16, 0x92, 0x14, 0xA5, 0x60, 0x49, 0xDB, 0x30, 0xDF, 0xA4, 0xE0, 0x97, 0x04, 0xA3, 0x32,
+  0x38, 0x60, 0x92, 0x27, 0xE7, 0x9C, 0x1A, 0x42, 0x04, 0xD6, 0x43, 0xF0, 0x3D, 0xC9, 0x9A, 0x37,
+  0xBB, 0x7A, 0x00, 0xE0, 0xF5, 0xDE, 0x28, 0x72, 0x23, 0x36, 0xBA, 0x4E, 0x9B, 0xAB, 0x4F, 0x38,
+  0x47, 0xCB, 0x4A, 0x4A, 0xE5, 0xF4, 0x05, 0x4C, 0xE6, 0xFF, 0xAB, 0x1B, 0x50, 0x93, 0x4C, 0xBB,
+  0x59, 0x7D, 0x59, 0x7E, 0x9B, 0x6D, 0xE4, 0x40, 0xFB, 0xD1, 0x32, 0xDF, 0x69, 0xB0, 0xE0, 0xD6,
+  0xDB, 0x91, 0xA7, 0x65, 0x3C, 0xC2, 0x97, 0x7D, 0xAD, 0x58, 0x7A, 0x85, 0x0B, 0xA4, 0x2D, 0xF7,
+  0xCE, 0x9E, 0x52, 0xCF, 0x84, 0x6A, 0xD4, 0xC9, 0x87, 0xC8, 0x3A, 0xDC, 0x2E, 0x1E, 0x3F, 0x1F,
+  0x7A, 0x03, 0x20, 0x10, 0x64, 0xBD, 0x5B, 0x01, 0x00, 0x00,
+};
+
+/* selectap.js: 978 bytes, 494 gzipped */
+static const uint8_t SELECTAP_JS_GZ[] PROGMEM = {
+  0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x7D, 0x53, 0x5D, 0x6F, 0xDB, 0x30,
+  0x0C, 0x7C, 0xCF, 0xAF, 0x20, 0xB2, 0x07, 0xC9, 0x68, 0xA0, 0xA0, 0x6F, 0x83, 0x83, 0x62, 0x58,
+  0x87, 0x02, 0xEB, 0xD0, 0xA5, 0x01, 0x12, 0xA0, 0xCF, 0xAC, 0x4C, 0xC7, 0x46, 0x6C, 0xC9, 0x91,
+  0x94, 0x64, 0x45, 0x9B, 0xFF, 0x3E, 0x32, 0x1F, 0x83, 0xB7, 0x21, 0x79, 0x93, 0x29, 0xF2, 0x8E,
+  0xBA, 0x3B, 0x97, 0x1B, 0x67, 0x53, 0xED, 0x1D, 0x58, 0xDD, 0x64, 0xF0, 0x3E, 0x28, 0xBC, 0xDD,
+  0xB4, 0xE4, 0x92, 0x59, 0x52, 0x7A, 0x68, 0x48, 0x8E, 0xF7, 0x6F, 0x8F, 0x85, 0x56, 0x51, 0x65,
+  0x66, 0x8B, 0xCD, 0x86, 0xE0, 0x0E, 0x1A, 0x53, 0x3B, 0x47, 0x61, 0x41, 0xBF, 0x12, 0x7C, 0x7C,
+  0xF0, 0x67, 0xE2, 0xD3, 0x37, 0xEF, 0x12, 0x77, 0x4F, 0x2E, 0x43, 0x74, 0x0C, 0x51, 0xF2, 0x65,
+  0xD4, 0xD9, 0x64, 0xB0, 0x1F, 0x6C, 0x31, 0x80, 0x75, 0x0C, 0xE7, 0x68, 0x07, 0x2F, 0xF4, 0x3A,
+  0xF7, 0x76, 0x45, 0x49, 0xAB, 0x5D, 0xCC, 0xC7, 0x63, 0x05, 0x37, 0xD0, 0x78, 0x8B, 0xB2, 0x9B,
+  0xA9, 0x7C, 0x4C, 0x0E, 0x5B, 0xE2, 0x9A, 0xCA, 0x3F, 0xDF, 0x8E, 0x15, 0xCF, 0x5B, 0x67, 0xBC,
+  0xF3, 0x1D, 0x09, 0x40, 0x79, 0x7A, 0x84, 0x96, 0x17, 0xF0, 0x45, 0x24, 0xC7, 0x74, 0xEF, 0xC3,
+  0xAF, 0xB3, 0xA7, 0xC7, 0xF9, 0x62, 0x98, 0x0F, 0x87, 0x7B, 0x19, 0xD9, 0x9F, 0xA6, 0x5A, 0x8A,
+  0x11, 0x97, 0xD4, 0x1F, 0x24, 0x99, 0x94, 0x85, 0x0A, 0x4C, 0xC8, 0x17, 0x3F, 0xE6, 0xCF, 0x53,
+  0xD3, 0x61, 0x88, 0xA4, 0xC9, 0x48, 0x8D, 0xC7, 0xEB, 0x12, 0xB4, 0x1C, 0x4D, 0x85, 0xF1, 0x79,
+  0xE7, 0x66, 0x81, 0xD9, 0x43, 0x7A, 0xD3, 0xEA, 0x48, 0xA3, 0xB2, 0x33, 0xC6, 0xB6, 0x65, 0x84,
+  0x8B, 0x2A, 0x6C, 0x5B, 0xD9, 0x65, 0xDB, 0x1E, 0x35, 0xFC, 0xBE, 0xF8, 0xF9, 0xC4, 0xDD, 0x4A,
+  0xB1, 0x6E, 0x82, 0x7D, 0xC4, 0x62, 0x99, 0xC2, 0x03, 0xDA, 0x4A, 0xFF, 0x59, 0x10, 0xBB, 0x11,
+  0xD4, 0x67, 0x02, 0xEC, 0xE3, 0xDB, 0x40, 0x98, 0xE8, 0x44, 0xA1, 0x15, 0x0A, 0x3A, 0xEF, 0x18,
+  0xA8, 0x14, 0xDC, 0x4F, 0x9D, 0x92, 0x4F, 0xEF, 0x6C, 0x53, 0xDB, 0xD5, 0x3F, 0x5A, 0xB1, 0xE9,
+  0xFC, 0x30, 0xD8, 0x4B, 0x47, 0xCF, 0x42, 0xEE, 0xC2, 0xCE, 0xC4, 0x58, 0x17, 0x93, 0x03, 0xDD,
+  0xFA, 0x0A, 0x5D, 0xEC, 0xD0, 0x09, 0xE3, 0xDA, 0xD8, 0x06, 0x63, 0x9C, 0x8A, 0x4B, 0x4C, 0xBB,
+  0x56, 0x52, 0xFA, 0x0F, 0x33, 0x30, 0xA8, 0x98, 0x08, 0xC5, 0x7D, 0x3B, 0x02, 0x5B, 0x81, 0xD8,
+  0xCC, 0x75, 0x3E, 0xDD, 0x00, 0xBF, 0xD1, 0x90, 0xB3, 0x70, 0xC7, 0xF3, 0x62, 0xAC, 0x82, 0x2F,
+  0xAC, 0x0B, 0xE4, 0xA0, 0x46, 0xE7, 0x3E, 0xBE, 0x3E, 0x6A, 0x87, 0x5D, 0x27, 0x1E, 0x6B, 0x41,
+  0xBB, 0xCD, 0x0E, 0xB9, 0x90, 0x36, 0x1C, 0xC1, 0x7A, 0x74, 0x71, 0xD7, 0xD7, 0xC0, 0x1E, 0x71,
+  0x0C, 0xB2, 0x2B, 0x19, 0x4D, 0xA9, 0xE1, 0x94, 0xF6, 0xAD, 0xE9, 0xDB, 0xD2, 0x90, 0x5B, 0xA6,
+  0x4A, 0xF6, 0x9A, 0x52, 0xDA, 0xF9, 0xB0, 0x8A, 0x50, 0xFA, 0x8D, 0x2B, 0xF2, 0xC3, 0x9A, 0x53,
+  0xCF, 0x51, 0xEE, 0x97, 0x8D, 0x92, 0x9C, 0xB3, 0xBC, 0x67, 0xD1, 0x81, 0x5D, 0x09, 0x14, 0x2B,
+  0x7D, 0xF5, 0x57, 0x93, 0x84, 0xFC, 0x9D, 0x8E, 0x59, 0x43, 0x18, 0x09, 0x76, 0x58, 0x27, 0x63,
+  0x04, 0xF5, 0x4A, 0xC8, 0x7F, 0x03, 0xBE, 0xFA, 0xA5, 0x51, 0xD2, 0x03, 0x00, 0x00,
+};
+
+/* style.css: 161 bytes, 151 gzipped */
+static const uint8_t STYLE_CSS_GZ[] PROGMEM = {
+  0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x25, 0x8B, 0xCB, 0x0A, 0x83, 0x30,
+  0x10, 0x00, 0x7F, 0xA5, 0x50, 0x7A, 0x33, 0x25, 0x85, 0x9E, 0x92, 0x53, 0x6F, 0xBD, 0xFB, 0x01,
+  0x65, 0x4D, 0x56, 0x5D, 0x1A, 0xB3, 0xB2, 0xAE, 0x2F, 0xC4, 0x7F, 0xAF, 0xD4, 0x39, 0x0E, 0x33,
+  0x15, 0xC7, 0x75, 0xAB, 0x20, 0x7C, 0x1B, 0xE1, 0x31, 0x47, 0x13, 0x38, 0xB1, 0xB8, 0xB9, 0x25,
+  0x45, 0x5F, 0x73, 0x56, 0x53, 0x43, 0x47, 0x69, 0x75, 0x2F, 0x21, 0x48, 0xC5, 0x1B, 0xD3, 0x84,
+  0x4A, 0x01, 0x8A, 0x12, 0xF2, 0x60, 0x4A, 0x14, 0xAA, 0xFD, 0xB9, 0x5C, 0xED, 0x9F, 0xFD, 0x1E,
+  0x8E, 0x0B, 0x28, 0x6F, 0x33, 0x45, 0x6D, 0xDD, 0xC3, 0xDA, 0xDB, 0xE1, 0x30, 0x2B, 0xCA, 0x27,
+  0xD2, 0xB4, 0x75, 0x20, 0x0D, 0x65, 0x67, 0x2F, 0x30, 0x2A, 0xFB, 0x0E, 0x16, 0x73, 0x86, 0x4F,
+  0x6B, 0xFB, 0xC5, 0xF7, 0x3C, 0x90, 0x12, 0x67, 0x27, 0x98, 0x40, 0x69, 0xC2, 0xFD, 0x07, 0x14,
+  0x41, 0x3A, 0x71, 0xA1, 0x00, 0x00, 0x00,
+};
+
+static const WebAsset WEB_ASSETS[] = {
+  { "/index.css", "text/css", INDEX_CSS_GZ, sizeof(INDEX_CSS_GZ), "\"f6cc68440a6926e1\"" },
+  { "/index.js", "application/javascript", INDEX_JS_GZ, sizeof(INDEX_JS_GZ), "\"97d30d6bf39e627a\"" },
+  { "/selectap.css", "text/css", SELECTAP_CSS_GZ, sizeof(SELECTAP_CSS_GZ), "\"f77e43c02c71d2dd\"" },
+  { "/selectap.js", "application/javascript", SELECTAP_JS_GZ, sizeof(SELECTAP_JS_GZ), "\"5e95c4c36f7138ce\"" },
+  { "/style.css", "text/css", STYLE_CSS_GZ, sizeof(STYLE_CSS_GZ), "\"ded236cd40c8417c\"" },
+};
+
+#define WEB_ASSET_COUNT     (sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]))
+
+#endif
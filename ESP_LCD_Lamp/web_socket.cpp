@@ -2,54 +2,638 @@
 #include <WebSocketsServer.h>
 #include "wifi_connection.h"
 #include "pinctrl.h"
+#include "timezones.h"
+#include "NTPSync.h"
+#include "web_socket.h"
+#include "scheduler.h"
+#include "metrics.h"
+#include "logger.h"
+#include "event_bus.h"
+#include "config_store.h"
+#include "config.h"
+#include "light_schedule.h"
+
+#define TX_BUF_SIZE       (1280)
+#define RX_DOC_SIZE       (256)     /* only the object tree, strings stay in the payload */
+#define BIN_ARG_SIZE      (32)
+#define RATE_WINDOW_MS    (1000)
+
+typedef struct{
+  const char* str;        /* "" when the command has no text argument */
+  int32_t value;
+}WsArg;
+
+typedef void (*WsHandler)(uint8_t num, const WsArg* arg, bool binary);
+
+typedef struct{
+  const char* key;        /* JSON object key */
+  uint8_t opcode;         /* binary frame opcode */
+  WsHandler handler;
+}WsCommand;
+
+/* State model: every field remembers the version at which it last changed.
+ * A client subscribes to topics and is sent, once per WS_process() tick, one delta frame
+ * with the fields of its topics that changed since the version it has already seen. */
+#define TOPIC_LIGHT       (0x01)
+#define TOPIC_TIME        (0x02)
+#define TOPIC_WIFI        (0x04)
+#define TOPIC_METRICS     (0x08)
+#define TOPIC_ALL         (0x0F)    /* every topic with state fields */
+#define TOPIC_LOG         (0x10)    /* new log records, streamed rather than versioned */
+#define TOPIC_MASK        (TOPIC_ALL | TOPIC_LOG)
+#define FIELD_VALUE_SIZE  (24)
+#define METRICS_REFRESH_MS (5000)
+#define LEVEL_REFRESH_MS  (100)     /* LEVEL follows a fade at most this often, then settles on the end value */
+
+typedef struct{
+  const char* key;
+  uint8_t topic;
+  bool quoted;
+  uint32_t version;
+  char value[FIELD_VALUE_SIZE];   /* already formatted as JSON, without quotes */
+}WsField;
+
+enum{ F_CURRENT, F_LEVEL, F_TARGET, F_TIME, F_TZ, F_SYNCED, F_IP, F_MSGS, F_HEAP, F_UPTIME,
+      F_LOAD, F_FRAG, F_LOOP_MAX, F_CLIENTS, F_NTP_AGE, FIELD_COUNT };
+
+static WsField fields[FIELD_COUNT] = {
+  { "CURRENT", TOPIC_LIGHT,   false },
+  { "LEVEL",   TOPIC_LIGHT,   false },
+  { "TARGET",  TOPIC_LIGHT,   false },
+  { "TIME",    TOPIC_TIME,    true  },
+  { "TZ",      TOPIC_TIME,    true  },
+  { "SYNCED",  TOPIC_TIME,    false },
+  { "IP",      TOPIC_WIFI,    true  },
+  { "MSGS",    TOPIC_METRICS, false },
+  { "HEAP",    TOPIC_METRICS, false },
+  { "UPTIME",  TOPIC_METRICS, false },
+  { "LOAD",    TOPIC_METRICS, false },
+  { "FRAG",    TOPIC_METRICS, false },
+  { "LOOPMAX", TOPIC_METRICS, false },
+  { "CLIENTS", TOPIC_METRICS, false },
+  { "NTPAGE",  TOPIC_METRICS, false },
+};
+
+static const char* const topicNames[] = { "light", "time", "wifi", "metrics", "log" };
+
+typedef struct{
+  uint8_t topics;
+  uint8_t pendingFull;    /* topics to send in full with the next delta */
+  uint32_t sentVersion;
+  uint32_t logSeq;        /* next log record to stream */
+}WsClient;
 
 WebSocketsServer wsServer = WebSocketsServer(81);
+static WsClient clients[WEBSOCKETS_SERVER_CLIENT_MAX];
+static uint32_t versionBase = 0;      /* random per boot, so versions from before a reboot force a full resync */
+static uint32_t stateVersion = 0;
+static uint32_t metricsRefreshMs = 0;
+static uint32_t levelRefreshMs = 0;
+static uint16_t levelSent = 0;
+static uint32_t apListWaiting = 0;     /* Clients waiting for the running AP scan, one bit each */
+static char txBuf[TX_BUF_SIZE];        /* Large replies are built here */
+static uint32_t msgCount = 0;
+static uint32_t msgWindowCount = 0;
+static uint32_t msgWindowStartMs = 0;
+static uint32_t msgRate = 0;
+static uint32_t msgOutCount = 0;
 
-void WS_process(){
-  wsServer.loop();   
+/* Every text reply goes out of txBuf through here, so outgoing frames are counted in one place. */
+static void sendText(uint8_t num, size_t len)
+{
+  wsServer.sendTXT(num, (uint8_t*)txBuf, len);
+  msgOutCount++;
 }
 
-void WS_ServerBroadcast(String msg){
-  wsServer.broadcastTXT(msg);
+static void sendApList(uint8_t num)
+{
+  int len = snprintf(txBuf, sizeof(txBuf), "{\"APLIST\":");
+  size_t listLen = WIFIC_getApListJson(txBuf + len, sizeof(txBuf) - len - 1);
+  if(listLen == 0){
+    listLen = snprintf(txBuf + len, sizeof(txBuf) - len - 1, "[]");
+  }
+  len += listLen;
+  txBuf[len++] = '}';
+  sendText(num, len);
 }
 
-static void serverEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length)
-{ 
-  if(type == WStype_TEXT){
-    //Serial.printf("[%u] get Text: %s\r\n", num, payload);
-    char textMsg[length];
-    for(int i = 0; i < length; i++){
-      textMsg[i] = payload[i];          
+static void sendTzList(uint8_t num)
+{
+  char name[TZ_NAME_SIZE];
+  size_t len = snprintf(txBuf, sizeof(txBuf), "{\"TZLIST\":[");
+  for(uint8_t i = 0; (i < TZ_count()) && (len + TZ_NAME_SIZE + 4 < sizeof(txBuf)); i++){
+    TZ_getNameAt(i, name);
+    len += snprintf(txBuf + len, sizeof(txBuf) - len, "%s\"%s\"", (i > 0) ? "," : "", name);
+  }
+  len += snprintf(txBuf + len, sizeof(txBuf) - len, "]}");
+  sendText(num, len);
+}
+
+/* {"ERROR":"<what>"} for a rejected JSON command. */
+static void sendError(uint8_t num, const char* what)
+{
+  int len = snprintf(txBuf, sizeof(txBuf), "{\"ERROR\":\"%s\"}", what);
+  sendText(num, len);
+}
+
+static void sendBinReply(uint8_t num, uint8_t opcode, const void* data, size_t len)
+{
+  txBuf[0] = opcode | WS_OP_REPLY;
+  if(len > 0){
+    memcpy(txBuf + 1, data, len);
+  }
+  wsServer.sendBIN(num, (uint8_t*)txBuf, len + 1);
+  msgOutCount++;
+}
+
+// --- State model ---
+static void setField(uint8_t id, const char* fmt, ...)
+{
+  char value[FIELD_VALUE_SIZE];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(value, sizeof(value), fmt, args);
+  va_end(args);
+
+  if(strcmp(value, fields[id].value) != 0){
+    strcpy(fields[id].value, value);
+    fields[id].version = ++stateVersion;
+  }
+}
+
+static void refreshTimeFields(void)
+{
+  const struct tm* now = NTPS_getLocalTime();
+  setField(F_TIME, "%02u:%02u", now->tm_hour, now->tm_min);
+  setField(F_TZ, "%s", TZ_getName());
+  setField(F_SYNCED, "%u", NTPS_hasSynced() ? 1 : 0);
+}
+
+static void onMinuteChange(const struct tm* local, uint8_t changed)
+{
+  refreshTimeFields();
+}
+
+/* Network, time, on/off and target fields change only on events, the live level and metrics are sampled. */
+static void onStateEvent(const Event* evt)
+{
+  char ip[16];
+
+  switch(evt->type){
+    case EVT_LIGHT_CHANGED:
+      setField(F_CURRENT, "%u", evt->value);
+      break;
+    case EVT_LEVEL_CHANGED:
+      setField(F_TARGET, "%u", evt->value);
+      break;
+    case EVT_IP_ACQUIRED:
+    case EVT_WIFI_DOWN:
+      WIFIC_formatStationIp(ip, sizeof(ip));
+      setField(F_IP, "%s", ip);
+      break;
+    case EVT_TIME_SYNCED:
+    case EVT_CONFIG_CHANGED:
+      refreshTimeFields();
+      break;
+  }
+}
+
+static void refreshFields(void)
+{
+  uint32_t now = millis();
+  uint16_t level = PINCTRL_getLevel();
+
+  if((level != levelSent) && ((now - levelRefreshMs) >= LEVEL_REFRESH_MS)){
+    levelRefreshMs = now;
+    levelSent = level;
+    setField(F_LEVEL, "%u", level);
+  }
+  if((now - metricsRefreshMs) >= METRICS_REFRESH_MS){
+    metricsRefreshMs = now;
+    setField(F_MSGS, "%u", msgRate);
+    setField(F_HEAP, "%u", ESP.getFreeHeap());
+    setField(F_UPTIME, "%u", now / 1000);
+    setField(F_LOAD, "%u", TASK_getLoadPercent());
+    setField(F_FRAG, "%u", ESP.getHeapFragmentation());
+    setField(F_LOOP_MAX, "%u", MET_getLoopMaxUs());
+    setField(F_CLIENTS, "%u", wsServer.connectedClients());
+    setField(F_NTP_AGE, "%u", NTPS_getSyncAgeS());
+  }
+}
+
+/* Builds {"V":version,...} with the fields of the given topics changed after sinceVersion,
+ * plus every field of the fullTopics. Fields not set yet, like the metrics in the first seconds
+ * after boot, are left out. Returns 0 if there is nothing to send. */
+static size_t buildDelta(uint8_t topics, uint8_t fullTopics, uint32_t sinceVersion)
+{
+  size_t len = snprintf(txBuf, sizeof(txBuf), "{\"V\":%u", stateVersion);
+  bool any = false;
+
+  for(uint8_t i = 0; i < FIELD_COUNT; i++){
+    const WsField* f = &fields[i];
+    if(!(f->topic & topics) || ((f->version <= sinceVersion) && !(f->topic & fullTopics)) || (f->value[0] == 0)){
+      continue;
     }
-        
-    DynamicJsonDocument doc(128);
-    DeserializationError error = deserializeJson(doc, textMsg);    
+    const char* q = f->quoted ? "\"" : "";
+    len += snprintf(txBuf + len, sizeof(txBuf) - len, ",\"%s\":%s%s%s", f->key, q, f->value, q);
+    any = true;
+  }
+  len += snprintf(txBuf + len, sizeof(txBuf) - len, "}");
+  return any ? len : 0;
+}
+
+/* {"LOG":["line",...],"SEQ":next}, as many records as fit in one frame. */
+static void sendLog(uint8_t num, WsClient* c)
+{
+  char line[LOG_LINE_SIZE];
+  size_t len = snprintf(txBuf, sizeof(txBuf), "{\"LOG\":[");
 
-    // Test if parsing succeeds.
-    if (!error) {
-      JsonObject root = doc.as<JsonObject>();
-      
-      if(root.containsKey("APLIST")){  
-        String APList = "{\"APLIST\":\"" + WIFIC_getApList() + "\"}";
-        wsServer.sendTXT(num, APList);   
+  if(c->logSeq < LOG_firstSeq()){
+    c->logSeq = LOG_firstSeq();
+  }
+  for(uint32_t first = c->logSeq; c->logSeq < LOG_nextSeq(); c->logSeq++){
+    size_t lineLen = LOG_format(c->logSeq, line, sizeof(line));
+    /* Escaping can at most double a line, keep room for that and the closing. */
+    if(len + 2 * lineLen + 24 > sizeof(txBuf)){
+      break;
+    }
+    if(c->logSeq != first){
+      txBuf[len++] = ',';
+    }
+    txBuf[len++] = '"';
+    for(size_t i = 0; i < lineLen; i++){
+      char ch = line[i];
+      if((ch == '"') || (ch == '\\')){
+        txBuf[len++] = '\\';
+      }else if((uint8_t)ch < 0x20){
+        ch = ' ';
       }
+      txBuf[len++] = ch;
+    }
+    txBuf[len++] = '"';
+  }
+  len += snprintf(txBuf + len, sizeof(txBuf) - len, "],\"SEQ\":%u}", c->logSeq);
+  sendText(num, len);
+}
+
+/* One frame per client per tick, however many fields changed since its last frame. */
+static void sendDeltas(void)
+{
+  for(uint8_t num = 0; num < WEBSOCKETS_SERVER_CLIENT_MAX; num++){
+    WsClient* c = &clients[num];
+    if((c->topics & TOPIC_LOG) && (c->logSeq != LOG_nextSeq())){
+      sendLog(num, c);
+    }
+    if(!(c->topics & TOPIC_ALL) || ((c->sentVersion == stateVersion) && (c->pendingFull == 0))){
+      continue;
+    }
+    size_t len = buildDelta(c->topics, c->pendingFull, c->sentVersion);
+    if(len > 0){
+      sendText(num, len);
+    }
+    c->sentVersion = stateVersion;
+    c->pendingFull = 0;
+  }
+}
+
+// --- Command handlers ---
+static void cmdApList(uint8_t num, const WsArg* arg, bool binary)
+{
+  if(WIFIC_scanAps()){
+    sendApList(num);
+  }else{
+    apListWaiting |= (1UL << num);
+  }
+}
+
+static void cmdToggle(uint8_t num, const WsArg* arg, bool binary)
+{
+  PINCTRL_toggle();
+}
+
+/* Answered to the asking client only: a snapshot of its topics, or of everything
+ * if it has not subscribed. The snapshot brings it up to the current version. */
+static void cmdStatus(uint8_t num, const WsArg* arg, bool binary)
+{
+  if(binary){
+    uint16_t level = PINCTRL_getLevel();
+    uint16_t target = PINCTRL_getBrightness();
+    uint8_t state[5] = { PINCTRL_getCurrent(), (uint8_t)level, (uint8_t)(level >> 8), (uint8_t)target, (uint8_t)(target >> 8) };
+    sendBinReply(num, WS_OP_STATUS, state, sizeof(state));
+    return;
+  }
+  refreshFields();
+  WsClient* c = &clients[num];
+  uint8_t topics = (c->topics & TOPIC_ALL) ? (c->topics & TOPIC_ALL) : TOPIC_ALL;
+  size_t len = buildDelta(topics, topics, 0);
+  sendText(num, len);
+  c->sentVersion = stateVersion;
+  c->pendingFull = 0;
+}
+
+static void cmdBrightness(uint8_t num, const WsArg* arg, bool binary)
+{
+  PINCTRL_setBrightness(constrain(arg->value, 0, CFG_BRIGHTNESS_MAX));
+}
+
+/* Binary arguments are packed, the JSON one is "level,ms,easing" with the last two optional. */
+static void cmdFade(uint8_t num, const WsArg* arg, bool binary)
+{
+  int32_t level;
+  uint32_t durationMs = LIGHT_FADE_MS;
+  uint8_t easing = EASE_IN_OUT;
 
-      if(root.containsKey("TOGGLE")){
-        uint8_t ledState = PINCTRL_toggle(); 
-        String bcmsg = "{\"CURRENT\":" + String(ledState) + "}";
-        WS_ServerBroadcast(bcmsg);
+  if(binary){
+    level = arg->value & 0xFFFF;
+    durationMs = (uint32_t)arg->value >> 16;
+    easing = arg->str[4];
+  }else{
+    char* end;
+    level = strtol(arg->str, &end, 10);
+    if(*end == ','){
+      durationMs = strtoul(end + 1, &end, 10);
+      if(*end == ','){
+        easing = strtoul(end + 1, &end, 10);
       }
+    }
+  }
+  PINCTRL_fade(constrain(level, 0, CFG_BRIGHTNESS_MAX), durationMs, easing);
+}
+
+/* Replies with every rule, so a client always sees what was actually stored. */
+static void cmdSched(uint8_t num, const WsArg* arg, bool binary)
+{
+  CfgSchedRule rule;
 
-      if(root.containsKey("STATUS")){
-        uint8_t ledState = PINCTRL_getCurrent(); 
-        String bcmsg = "{\"CURRENT\":" + String(ledState) + "}";
-        WS_ServerBroadcast(bcmsg);
-      }      
-    }      
-  }   
+  if(binary){
+    if(arg->str[0] != 0){
+      memcpy(&rule, arg->str + 1, sizeof(rule));
+      if(!SCHED_setRule((uint8_t)arg->str[0] - 1, &rule)){
+        sendBinReply(num, WS_OP_SCHED, nullptr, 0);
+        return;
+      }
+    }
+    uint32_t next = (uint32_t)SCHED_getNextUtc();
+    char data[sizeof(next) + CFG_SCHED_RULES * sizeof(CfgSchedRule)];
+    memcpy(data, &next, sizeof(next));
+    for(uint8_t i = 0; i < CFG_SCHED_RULES; i++){
+      memcpy(data + sizeof(next) + i * sizeof(CfgSchedRule), SCHED_getRule(i), sizeof(CfgSchedRule));
+    }
+    sendBinReply(num, WS_OP_SCHED, data, sizeof(data));
+    return;
+  }
+
+  if(arg->str[0] != 0){
+    uint32_t v[6] = { 0 };
+    const char* p = arg->str;
+    uint8_t n = 0;
+    for(; n < 6; n++){
+      char* end;
+      v[n] = strtoul(p, &end, 10);
+      if(end == p){
+        break;
+      }
+      p = (*end == ',') ? end + 1 : end;
+    }
+    /* Checked before narrowing to the rule's fields, so "256,..." cannot land in slot 0. */
+    if(n < 6){
+      sendError(num, "SCHED rule");
+      return;
+    }
+    if(v[0] >= CFG_SCHED_RULES){
+      sendError(num, "SCHED slot");
+      return;
+    }
+    rule.days = v[1] & SCHED_DAYS_ALL;
+    rule.hour = min(v[2], (uint32_t)0xFF);
+    rule.minute = min(v[3], (uint32_t)0xFF);
+    rule.level = min(v[4], (uint32_t)0xFFFF);
+    rule.fadeS = min(v[5], (uint32_t)0xFFFF);
+    if(!SCHED_setRule(v[0], &rule)){
+      sendError(num, "SCHED rule");
+      return;
+    }
+  }
+
+  size_t len = snprintf(txBuf, sizeof(txBuf), "{\"SCHED\":[");
+  for(uint8_t i = 0; i < CFG_SCHED_RULES; i++){
+    const CfgSchedRule* r = SCHED_getRule(i);
+    len += snprintf(txBuf + len, sizeof(txBuf) - len, "%s[%u,%u,%u,%u,%u]", (i > 0) ? "," : "",
+                    r->days, r->hour, r->minute, r->level, r->fadeS);
+  }
+  len += snprintf(txBuf + len, sizeof(txBuf) - len, "],\"NEXT\":%u}", (uint32_t)SCHED_getNextUtc());
+  sendText(num, len);
+}
+
+/* {"SUB":"light,time"} or a topic bit mask. Replaces the subscription,
+ * newly added topics are sent in full with the next delta. */
+static void cmdSub(uint8_t num, const WsArg* arg, bool binary)
+{
+  uint8_t topics = 0;
+  /* A mask as a number, a binary argument or a string of digits, otherwise topic names. */
+  if(binary || (arg->str[0] == 0) || ((arg->str[0] >= '0') && (arg->str[0] <= '9'))){
+    topics = arg->value & TOPIC_MASK;
+  }else{
+    for(uint8_t i = 0; i < sizeof(topicNames) / sizeof(topicNames[0]); i++){
+      if(strstr(arg->str, topicNames[i]) != nullptr){
+        topics |= (1 << i);
+      }
+    }
+  }
+  WsClient* c = &clients[num];
+  if((topics & TOPIC_LOG) && !(c->topics & TOPIC_LOG)){
+    c->logSeq = LOG_nextSeq();
+  }
+  c->pendingFull |= topics & ~c->topics & TOPIC_ALL;
+  c->topics = topics;
+}
+
+/* {"LOG":seq} streams the log from that record on, 0 for everything still in the ring. */
+static void cmdLog(uint8_t num, const WsArg* arg, bool binary)
+{
+  WsClient* c = &clients[num];
+  c->logSeq = std::max((uint32_t)arg->value, LOG_firstSeq());
+  c->topics |= TOPIC_LOG;
+}
+
+/* {"SYNC":version} from a reconnecting client: only what changed after that version is sent.
+ * A version this boot never issued gets a full resync. */
+static void cmdSync(uint8_t num, const WsArg* arg, bool binary)
+{
+  WsClient* c = &clients[num];
+  uint32_t version = (uint32_t)arg->value;
+  if((version < versionBase) || (version > stateVersion)){
+    c->pendingFull = c->topics & TOPIC_ALL;
+  }else{
+    c->sentVersion = version;
+    c->pendingFull = 0;
+  }
+}
+
+static void cmdTz(uint8_t num, const WsArg* arg, bool binary)
+{
+  if((arg->str[0] != 0) && TZ_set(arg->str)){
+    NTPS_refresh();
+    refreshTimeFields();
+  }
+  const char* name = TZ_getName();
+  if(binary){
+    sendBinReply(num, WS_OP_TZ, name, strlen(name));
+  }else{
+    int len = snprintf(txBuf, sizeof(txBuf), "{\"TZ\":\"%s\"}", name);
+    sendText(num, len);
+  }
+}
+
+static void cmdTzList(uint8_t num, const WsArg* arg, bool binary)
+{
+  sendTzList(num);
+}
+
+static const WsCommand commands[] = {
+  { "APLIST",     WS_OP_APLIST,         cmdApList },
+  { "TOGGLE",     WS_OP_TOGGLE,         cmdToggle },
+  { "STATUS",     WS_OP_STATUS,         cmdStatus },
+  { "BRIGHTNESS", WS_OP_SET_BRIGHTNESS, cmdBrightness },
+  { "TZ",         WS_OP_TZ,             cmdTz },
+  { "TZLIST",     WS_OP_TZLIST,         cmdTzList },
+  { "SUB",        WS_OP_SUB,            cmdSub },
+  { "SYNC",       WS_OP_SYNC,           cmdSync },
+  { "LOG",        WS_OP_LOG,            cmdLog },
+  { "FADE",       WS_OP_FADE,           cmdFade },
+  { "SCHED",      WS_OP_SCHED,          cmdSched },
+};
+
+#define COMMAND_COUNT     (sizeof(commands) / sizeof(commands[0]))
+
+/* Every key of the object is a command, handled in the order received.
+ * The payload is parsed in place, string values point into it. */
+static void dispatchJson(uint8_t num, uint8_t* payload, size_t length)
+{
+  StaticJsonDocument<RX_DOC_SIZE> doc;
+  if(deserializeJson(doc, (char*)payload, length)){
+    return;
+  }
+
+  for(JsonPair kv : doc.as<JsonObject>()){
+    for(uint8_t i = 0; i < COMMAND_COUNT; i++){
+      if(strcmp(kv.key().c_str(), commands[i].key) == 0){
+        JsonVariant v = kv.value();
+        WsArg arg;
+        if(v.is<const char*>()){
+          arg.str = v.as<const char*>();
+          arg.value = atol(arg.str);
+        }else{
+          arg.str = "";
+          arg.value = v.as<int32_t>();
+        }
+        msgCount++;
+        msgWindowCount++;
+        commands[i].handler(num, &arg, false);
+        break;
+      }
+    }
+  }
+}
+
+static void dispatchBinary(uint8_t num, const uint8_t* payload, size_t length)
+{
+  if(length == 0){
+    return;
+  }
+
+  for(uint8_t i = 0; i < COMMAND_COUNT; i++){
+    if(payload[0] == commands[i].opcode){
+      char str[BIN_ARG_SIZE] = { 0 };     /* bytes past a short argument read as zero */
+      size_t argLen = std::min(length - 1, sizeof(str) - 1);
+      memcpy(str, payload + 1, argLen);
+      str[argLen] = 0;
+
+      WsArg arg;
+      arg.str = str;
+      /* Little endian, assembled unsigned: shifting a byte into the sign bit of an int32_t is undefined. */
+      uint32_t value = 0;
+      for(uint8_t b = 0; (b < 4) && (b < argLen); b++){
+        value |= (uint32_t)payload[1 + b] << (8 * b);
+      }
+      arg.value = (int32_t)value;
+      msgCount++;
+      msgWindowCount++;
+      commands[i].handler(num, &arg, true);
+      return;
+    }
+  }
+}
+
+// --- Public functions ---
+void WS_process(){
+  wsServer.loop();   
+
+  /* Everyone who asked during a scan gets the result of that one scan. */
+  if(apListWaiting && !WIFIC_isScanning()){
+    for(uint8_t num = 0; num < WEBSOCKETS_SERVER_CLIENT_MAX; num++){
+      if(apListWaiting & (1UL << num)){
+        sendApList(num);
+      }
+    }
+    apListWaiting = 0;
+  }
+
+  uint32_t elapsed = millis() - msgWindowStartMs;
+  if(elapsed >= RATE_WINDOW_MS){
+    msgRate = (msgWindowCount * 1000UL) / elapsed;
+    msgWindowCount = 0;
+    msgWindowStartMs += elapsed;
+  }
+
+  refreshFields();
+  sendDeltas();
+}
+
+uint32_t WS_getMsgRate(void){
+  return msgRate;
+}
+
+uint32_t WS_getMsgCount(void){
+  return msgCount;
+}
+
+uint32_t WS_getMsgOutCount(void){
+  return msgOutCount;
+}
+
+uint8_t WS_getClientCount(void){
+  return wsServer.connectedClients();
+}
+
+static void serverEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length)
+{ 
+  if(type == WStype_DISCONNECTED){
+    apListWaiting &= ~(1UL << num);
+    clients[num].topics = 0;
+  }else if(type == WStype_CONNECTED){
+    clients[num].topics = 0;
+    clients[num].pendingFull = 0;
+    clients[num].sentVersion = stateVersion;
+  }else if(type == WStype_TEXT){
+    dispatchJson(num, payload, length);
+  }else if(type == WStype_BIN){
+    dispatchBinary(num, payload, length);
+  }
 }
 
 void WS_init(){
+  if(versionBase == 0){
+    versionBase = ESP.random() & 0x7FFF0000;
+    stateVersion = versionBase;
+  }
+  setField(F_CURRENT, "%u", PINCTRL_getCurrent());
+  levelSent = PINCTRL_getLevel();
+  setField(F_LEVEL, "%u", levelSent);
+  setField(F_TARGET, "%u", PINCTRL_getBrightness());
+  EVT_subscribe(EVT_LIGHT_CHANGED | EVT_LEVEL_CHANGED | EVT_IP_ACQUIRED | EVT_WIFI_DOWN | EVT_TIME_SYNCED | EVT_CONFIG_CHANGED, onStateEvent);
+  NTPS_subscribe(NTPS_EVT_MINUTE, onMinuteChange);
+  memset(clients, 0, sizeof(clients));
   wsServer.close();
   wsServer.begin(); 
   wsServer.onEvent(serverEvent);  
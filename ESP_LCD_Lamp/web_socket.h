@@ -1,8 +1,36 @@
 #ifndef WEB_SOCKET_H
 #define WEB_SOCKET_H
 
+/* Binary framing: one WStype_BIN frame per command, [opcode][argument...].
+ * The argument is a little endian integer for SET_BRIGHTNESS and raw text for TZ.
+ * FADE takes [level, 16 bit][duration ms, 16 bit][easing], or {"FADE":"level,ms,easing"} as JSON.
+ * SCHED takes [slot + 1][days][hour][minute][level, 16 bit][fade s, 16 bit], a first byte of 0
+ * only reads, or {"SCHED":"slot,days,hour,minute,level,fade"} and {"SCHED":""} to only read.
+ * It replies with all rules and the next event, {"SCHED":[[days,hour,minute,level,fade],...],"NEXT":utc},
+ * or binary [next utc, 32 bit][7 bytes per rule, laid out as CfgSchedRule].
+ * A rule that is rejected, e.g. a slot past CFG_SCHED_RULES or an hour past 23, changes nothing and
+ * is answered with {"ERROR":"SCHED slot"} or {"ERROR":"SCHED rule"}, or a bare binary reply opcode.
+ * Direct replies to a binary command are binary too, [opcode | WS_OP_REPLY][data...],
+ * state deltas for subscribed topics are always JSON text, {"V":version,"KEY":value,...}.
+ * LEVEL is the level on the pin, updated every 100 ms during a fade, TARGET the level it fades to. */
+#define WS_OP_TOGGLE          (0x01)
+#define WS_OP_STATUS          (0x02)    // reply: [state][level now, 16 bit][level faded to, 16 bit]
+#define WS_OP_SET_BRIGHTNESS  (0x03)    // arg: level 0 to 1023, 0 is off, fades in LIGHT_FADE_MS
+#define WS_OP_APLIST          (0x04)    // reply is always the JSON list
+#define WS_OP_TZ              (0x05)    // arg: zone name, empty to only read it; reply: [name]
+#define WS_OP_TZLIST          (0x06)    // reply is always the JSON list
+#define WS_OP_SUB             (0x07)    // arg: topic mask, light 1, time 2, wifi 4, metrics 8, log 16
+#define WS_OP_SYNC            (0x08)    // arg: last version seen
+#define WS_OP_LOG             (0x09)    // arg: first log record to stream, records arrive as JSON text
+#define WS_OP_FADE            (0x0A)    // arg: level, duration and EASE_* easing, see above
+#define WS_OP_SCHED           (0x0B)    // arg: one light schedule rule, see above
+#define WS_OP_REPLY           (0x80)
+
 extern void WS_process(void);
 extern void WS_init(void);
-extern void WS_ServerBroadcast(String msg);
+extern uint32_t WS_getMsgRate(void);      // commands per second over the last full second
+extern uint32_t WS_getMsgCount(void);        // commands received since boot
+extern uint32_t WS_getMsgOutCount(void);     // frames sent since boot
+extern uint8_t WS_getClientCount(void);
 
 #endif
@@ -6,23 +6,65 @@
  *  - AP always on
  *  - STA connects if saved
  *  - Automatic reconnection handled by ESP8266 core
- *  - EEPROM stores SSID and password
+ *  - SSID and password come from the config store
+ *  - The last BSSID, channel and DHCP lease are cached in RTC memory and the config store,
+ *    so a restart can reconnect without a channel scan and use the address at once,
+ *    while DHCP confirms or replaces it in the background
  */
 
 #include <ESP8266WiFi.h>
-#include <EEPROM.h>
 #include "config.h"
+#include "config_store.h"
+#include "logger.h"
+#include "event_bus.h"
 #include "NTPSync.h"
 
+#define AP_CACHE_SIZE     (16)        // strongest networks kept from a scan
+#define AP_CACHE_TTL_MS   (30000)     // scan results are reused for this long
+#define RTC_FAST_OFFSET   (0)         // RTC user memory block of the fast connect cache
+#define RTC_FAST_MAGIC    (0x46415354UL)
+
+typedef struct {
+    char ssid[33];
+    int8_t rssi;
+    uint8_t channel;
+    uint8_t encryption;
+} ApInfo;
+
+/* Survives resets and deep sleep but not a power cycle, the config store covers that. */
+typedef struct {
+    uint32_t magic;
+    uint32_t checksum;
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t reserved;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t mask;
+    uint32_t dns;
+} RtcFastConnect;
+
+enum { CONNECT_IDLE, CONNECT_FAST, CONNECT_FULL, CONNECT_RENEW };
+
 // -----------------------------------------------------------------------------
 // Local variables
 // -----------------------------------------------------------------------------
 static char myApName[32] = {0};         // AP name
-static char st_ssid[SSID_SIZE] = {0};   // Saved SSID
-static char st_pass[WIFI_PASS_SIZE] = {0}; // Saved password
 static IPAddress stationIP;
 static IPAddress apIP(192, 168, 1, 1);
 static bool stationConnectedOnce = false; // mark first successful STA connect
+static ApInfo apCache[AP_CACHE_SIZE];
+static uint8_t apCount = 0;
+static uint32_t apScanMs = 0;
+static bool apCacheValid = false;
+static bool apScanRunning = false;
+static uint8_t connectPath = CONNECT_IDLE;
+static uint32_t connectStartMs = 0;
+static WiFiEventHandler connectedHandler;     // the core drops a callback once its handler is released
+static WiFiEventHandler gotIpHandler;
+static WiFiEventHandler disconnectedHandler;
+static uint32_t gotIpMs = 0;              // millis() since boot at the first GotIP
+static bool gotIpFast = false;
 
 // -----------------------------------------------------------------------------
 // Getters
@@ -39,47 +81,97 @@ IPAddress WIFIC_getStIP(void) {
     return stationIP;
 }
 
-String WIFIC_getStSSID(void) {
-    return String(st_ssid);
+const char* WIFIC_getStSSID(void) {
+    return CFG_get()->ssid;
 }
 
-String WIFIC_getStPass(void) {
-    return String(st_pass);
+const char* WIFIC_getStPass(void) {
+    return CFG_get()->pass;
+}
+
+/* Both values are saved together in one config store write.
+ * Returns false if either does not fit, nothing is changed then. */
+bool WIFIC_setCredentials(const char* ssid, const char* pass) {
+    CfgData* cfg = CFG_get();
+    if ((strlen(ssid) >= sizeof(cfg->ssid)) || (strlen(pass) >= sizeof(cfg->pass))) {
+        return false;
+    }
+    strcpy(cfg->ssid, ssid);
+    strcpy(cfg->pass, pass);
+    cfg->channel = 0;     // the cached connection belongs to the old network
+    RtcFastConnect rtc = {};
+    ESP.rtcUserMemoryWrite(RTC_FAST_OFFSET, (uint32_t*)&rtc, sizeof(rtc));
+    return CFG_save();
 }
 
 // -----------------------------------------------------------------------------
-// EEPROM helpers
+// Fast connect cache
 // -----------------------------------------------------------------------------
-void WIFIC_setStSSID(String new_ssid) {
-    EEPROM.begin(EEPROM_SIZE);
-    uint16_t addr = 0;
-    for (; addr < new_ssid.length() && addr < SSID_SIZE - 1; addr++) {
-        EEPROM.put(addr + SSID_EEPROM_ADDR, new_ssid[addr]);
-        st_ssid[addr] = new_ssid[addr];
+static uint32_t rtcChecksum(const RtcFastConnect* rtc) {
+    const uint8_t* p = (const uint8_t*)rtc->bssid;
+    const uint8_t* end = (const uint8_t*)rtc + sizeof(RtcFastConnect);
+    uint32_t sum = 0x811C9DC5UL;      // FNV-1a
+    for (; p < end; p++) {
+        sum = (sum ^ *p) * 0x01000193UL;
     }
-    EEPROM.put(addr + SSID_EEPROM_ADDR, 0);
-    st_ssid[addr] = 0;
-    EEPROM.commit();
+    return sum;
 }
 
-void WIFIC_setStPass(String new_pass) {
-    EEPROM.begin(EEPROM_SIZE);
-    uint16_t addr = 0;
-    for (; addr < new_pass.length() && addr < WIFI_PASS_SIZE - 1; addr++) {
-        EEPROM.put(addr + WIFI_PASS_EEPROM_ADDR, new_pass[addr]);
-        st_pass[addr] = new_pass[addr];
+/* Fills rtc from RTC memory, or from the config store after a power cycle. */
+static bool loadFastConnect(RtcFastConnect* rtc) {
+    if (ESP.rtcUserMemoryRead(RTC_FAST_OFFSET, (uint32_t*)rtc, sizeof(*rtc)) &&
+        (rtc->magic == RTC_FAST_MAGIC) && (rtc->checksum == rtcChecksum(rtc)) && (rtc->channel != 0)) {
+        return true;
+    }
+
+    const CfgData* cfg = CFG_get();
+    if ((cfg->channel == 0) || (cfg->ip == 0)) {
+        return false;
     }
-    EEPROM.put(addr + WIFI_PASS_EEPROM_ADDR, 0);
-    st_pass[addr] = 0;
-    EEPROM.commit();
+    memcpy(rtc->bssid, cfg->bssid, sizeof(rtc->bssid));
+    rtc->channel = cfg->channel;
+    rtc->ip = cfg->ip;
+    rtc->gateway = cfg->gateway;
+    rtc->mask = cfg->mask;
+    rtc->dns = cfg->dns;
+    return true;
+}
+
+/* Called once connected through DHCP, the config store is only written if something changed. */
+static void saveFastConnect(void) {
+    RtcFastConnect rtc = {};
+    memcpy(rtc.bssid, WiFi.BSSID(), sizeof(rtc.bssid));
+    rtc.channel = WiFi.channel();
+    rtc.ip = WiFi.localIP();
+    rtc.gateway = WiFi.gatewayIP();
+    rtc.mask = WiFi.subnetMask();
+    rtc.dns = WiFi.dnsIP();
+    rtc.magic = RTC_FAST_MAGIC;
+    rtc.checksum = rtcChecksum(&rtc);
+    ESP.rtcUserMemoryWrite(RTC_FAST_OFFSET, (uint32_t*)&rtc, sizeof(rtc));
+
+    CfgData* cfg = CFG_get();
+    memcpy(cfg->bssid, rtc.bssid, sizeof(cfg->bssid));
+    cfg->channel = rtc.channel;
+    cfg->ip = rtc.ip;
+    cfg->gateway = rtc.gateway;
+    cfg->mask = rtc.mask;
+    cfg->dns = rtc.dns;
+    CFG_save();
+}
+
+static void fullConnect(void) {
+    const CfgData* cfg = CFG_get();
+    connectPath = CONNECT_FULL;
+    connectStartMs = millis();
+    WiFi.config(0U, 0U, 0U);      // back to DHCP
+    WiFi.begin(cfg->ssid, cfg->pass);
 }
 
 // -----------------------------------------------------------------------------
 // Wi-Fi AP mode
 // -----------------------------------------------------------------------------
 static void APMode(void) {
-    Serial.println("\nStarting AP");
-
     WiFi.mode(WIFI_AP_STA);          // Ensure AP+STA mode
     WiFi.setAutoReconnect(true);
     WiFi.persistent(true);
@@ -90,91 +182,244 @@ static void APMode(void) {
     WiFi.softAPConfig(apIP, apIP, IPAddress(255, 255, 255, 0));
     WiFi.softAP(myApName, AP_PASS);
 
-    Serial.printf("AP active: %s, IP: %s\n", myApName, apIP.toString().c_str());
+    LOG_I(LOG_MOD_WIFI, "AP active: %s, IP: %I", myApName, (uint32_t)apIP);
 }
 
 // -----------------------------------------------------------------------------
 // Wi-Fi STA mode
 // -----------------------------------------------------------------------------
 void WIFIC_stationMode(void) {
-    if (st_ssid[0] == 0) {
-        Serial.println("No saved WiFi credentials.");
+    const CfgData* cfg = CFG_get();
+    if (cfg->ssid[0] == 0) {
+        LOG_I(LOG_MOD_WIFI, "no saved credentials");
         return;
     }
 
-    Serial.printf("Connecting STA [%s]...\n", st_ssid);
-    WiFi.begin(st_ssid, st_pass);
+    RtcFastConnect rtc;
+    if (loadFastConnect(&rtc)) {
+        LOG_I(LOG_MOD_WIFI, "connecting to [%s] on channel %u, cached BSSID", cfg->ssid, rtc.channel);
+        connectPath = CONNECT_FAST;
+        connectStartMs = millis();
+        WiFi.config(IPAddress(rtc.ip), IPAddress(rtc.gateway), IPAddress(rtc.mask), IPAddress(rtc.dns));
+        WiFi.begin(cfg->ssid, cfg->pass, rtc.channel, rtc.bssid);
+    } else {
+        LOG_I(LOG_MOD_WIFI, "connecting to [%s]", cfg->ssid);
+        fullConnect();
+    }
 }
 
 // -----------------------------------------------------------------------------
 // Wi-Fi event callbacks
 // -----------------------------------------------------------------------------
+/* SDK callbacks only record and post, the work happens in the event handlers. */
 void WIFIC_setupCallbacks(void) {
-    WiFi.onStationModeGotIP([](const WiFiEventStationModeGotIP& evt) {
+    connectedHandler = WiFi.onStationModeConnected([](const WiFiEventStationModeConnected& evt) {
+        EVT_post(EVT_WIFI_UP, evt.channel);
+    });
+
+    gotIpHandler = WiFi.onStationModeGotIP([](const WiFiEventStationModeGotIP& evt) {
         stationIP = evt.ip;
-        Serial.printf("\n\nConnected, IP: %s\n", stationIP.toString().c_str());
+        LOG_I(LOG_MOD_WIFI, "connected, IP %I", (uint32_t)stationIP);
 
         if (!stationConnectedOnce) {
             stationConnectedOnce = true;
         }
+        EVT_post(EVT_IP_ACQUIRED, (uint32_t)stationIP);
     });
 
-    WiFi.onStationModeDisconnected([](const WiFiEventStationModeDisconnected& evt) {
-        Serial.println("STA disconnected, will auto-reconnect.");
+    disconnectedHandler = WiFi.onStationModeDisconnected([](const WiFiEventStationModeDisconnected& evt) {
+        LOG_W(LOG_MOD_WIFI, "disconnected, reason %u, will auto-reconnect", evt.reason);
+        EVT_post(EVT_WIFI_DOWN, evt.reason);
     });
 }
 
+static void onGotIp(const Event* evt) {
+    if (connectPath == CONNECT_IDLE) {
+        return;     // an automatic reconnect
+    }
+    if (connectPath == CONNECT_RENEW) {
+        LOG_I(LOG_MOD_WIFI, "DHCP lease, IP %I", evt->value);
+        saveFastConnect();
+        connectPath = CONNECT_IDLE;
+        return;
+    }
+    gotIpFast = (connectPath == CONNECT_FAST);
+    if (gotIpMs == 0) {
+        gotIpMs = millis();
+    }
+    LOG_I(LOG_MOD_WIFI, "GotIP via the %s path, %u ms after boot, %u ms after connecting",
+          gotIpFast ? "fast" : "full", gotIpMs, millis() - connectStartMs);
+    if (gotIpFast) {
+        /* The cached lease may have expired or been given to another host since it was saved,
+         * DHCP on the link that is already up keeps or replaces it. */
+        connectPath = CONNECT_RENEW;
+        WiFi.config(0U, 0U, 0U);
+    } else {
+        saveFastConnect();
+        connectPath = CONNECT_IDLE;
+    }
+}
+
 // -----------------------------------------------------------------------------
 // Initialize Wi-Fi module
 // -----------------------------------------------------------------------------
 void WIFIC_init(void) {
     ESP.wdtFeed();
-    EEPROM.begin(EEPROM_SIZE);
-
-    // Load saved password
-    uint16_t i = 0;
-    do {
-        EEPROM.get(i + WIFI_PASS_EEPROM_ADDR, st_pass[i]);
-        if ((st_pass[i] < 32) || (st_pass[i] > 126)) break;
-        i++;
-    } while (i < WIFI_PASS_SIZE);
-    st_pass[i] = 0;
-
-    // Load saved SSID
-    i = 0;
-    do {
-        EEPROM.get(i + SSID_EEPROM_ADDR, st_ssid[i]);
-        if ((st_ssid[i] < 32) || (st_ssid[i] > 126)) break;
-        i++;
-    } while (i < SSID_SIZE);
-    st_ssid[i] = 0;
 
     // Setup AP and STA
     APMode();
+    EVT_subscribe(EVT_IP_ACQUIRED, onGotIp);
     WIFIC_setupCallbacks();
     WIFIC_stationMode();
 }
 
 // -----------------------------------------------------------------------------
-// Return list of scanned APs
+// Asynchronous AP scan with a cache of the results
 // -----------------------------------------------------------------------------
-String WIFIC_getApList(void) {
-    String result = "";
-    int n = WiFi.scanNetworks();
-    if (n > 0) {
-        result = WiFi.SSID(0);
-        for (int i = 1; i < n; ++i) {
-            result += "|" + WiFi.SSID(i);
+static const char* encryptionName(uint8_t enc) {
+    switch (enc) {
+        case ENC_TYPE_NONE: return "open";
+        case ENC_TYPE_WEP:  return "wep";
+        case ENC_TYPE_TKIP: return "wpa";
+        case ENC_TYPE_CCMP: return "wpa2";
+        default:            return "auto";
+    }
+}
+
+/* Keeps the cache sorted by signal strength, one entry per SSID. */
+static void cacheAp(const String& ssid, int8_t rssi, uint8_t channel, uint8_t enc) {
+    if (ssid.length() == 0) {
+        return;     // hidden network
+    }
+
+    for (uint8_t i = 0; i < apCount; i++) {
+        if (ssid.equals(apCache[i].ssid)) {
+            if (rssi <= apCache[i].rssi) {
+                return;
+            }
+            memmove(&apCache[i], &apCache[i + 1], (apCount - i - 1) * sizeof(ApInfo));
+            apCount--;
+            break;
         }
     }
-    return result;
+
+    uint8_t pos = 0;
+    while ((pos < apCount) && (apCache[pos].rssi >= rssi)) {
+        pos++;
+    }
+    if (pos >= AP_CACHE_SIZE) {
+        return;
+    }
+    if (apCount == AP_CACHE_SIZE) {
+        apCount--;
+    }
+    memmove(&apCache[pos + 1], &apCache[pos], (apCount - pos) * sizeof(ApInfo));
+    apCount++;
+
+    ssid.toCharArray(apCache[pos].ssid, sizeof(apCache[pos].ssid));
+    apCache[pos].rssi = rssi;
+    apCache[pos].channel = channel;
+    apCache[pos].encryption = enc;
+}
+
+static void collectScan(int n) {
+    apCount = 0;
+    for (int i = 0; i < n; i++) {
+        cacheAp(WiFi.SSID(i), WiFi.RSSI(i), WiFi.channel(i), WiFi.encryptionType(i));
+    }
+    WiFi.scanDelete();
+    apScanMs = millis();
+    apCacheValid = true;
+}
+
+/* Returns true if the cached list is fresh, otherwise starts a scan unless one is already running. */
+bool WIFIC_scanAps(void) {
+    if (apCacheValid && ((millis() - apScanMs) < AP_CACHE_TTL_MS)) {
+        return true;
+    }
+    if (!apScanRunning) {
+        apScanRunning = true;
+        WiFi.scanNetworks(true);
+    }
+    return false;
+}
+
+bool WIFIC_isScanning(void) {
+    return apScanRunning;
+}
+
+static size_t appendJsonString(char* buf, size_t size, size_t len, const char* str) {
+    if (len < size) buf[len] = '"';
+    len++;
+    for (; *str; str++) {
+        char c = *str;
+        if ((c == '"') || (c == '\\')) {
+            if (len < size) buf[len] = '\\';
+            len++;
+        } else if ((uint8_t)c < 0x20) {
+            c = ' ';
+        }
+        if (len < size) buf[len] = c;
+        len++;
+    }
+    if (len < size) buf[len] = '"';
+    return len + 1;
+}
+
+/* Writes the cached APs as a JSON array. Returns the length, or 0 if it did not fit. */
+size_t WIFIC_getApListJson(char* buf, size_t size) {
+    size_t len = snprintf(buf, size, "[");
+    for (uint8_t i = 0; (i < apCount) && (len < size); i++) {
+        len += snprintf(buf + len, size - len, "%s{\"ssid\":", (i > 0) ? "," : "");
+        if (len >= size) break;
+        len = appendJsonString(buf, size, len, apCache[i].ssid);
+        if (len >= size) break;
+        len += snprintf(buf + len, size - len, ",\"rssi\":%d,\"ch\":%u,\"enc\":\"%s\"}",
+                        apCache[i].rssi, apCache[i].channel, encryptionName(apCache[i].encryption));
+    }
+    if (len < size) {
+        len += snprintf(buf + len, size - len, "]");
+    }
+    return (len < size) ? len : 0;
+}
+
+uint32_t WIFIC_getGotIpMs(void) {
+    return gotIpMs;
+}
+
+static void processConnect(void) {
+    if ((connectPath == CONNECT_FAST) && ((millis() - connectStartMs) > WIFI_FAST_CONNECT_MS)) {
+        LOG_W(LOG_MOD_WIFI, "fast connect timed out, scanning");
+        RtcFastConnect rtc = {};
+        ESP.rtcUserMemoryWrite(RTC_FAST_OFFSET, (uint32_t*)&rtc, sizeof(rtc));
+        fullConnect();
+    }
+}
+
+void WIFIC_process(void) {
+    processConnect();
+
+    if (!apScanRunning) {
+        return;
+    }
+
+    int n = WiFi.scanComplete();
+    if (n >= 0) {
+        collectScan(n);
+        apScanRunning = false;
+        LOG_I(LOG_MOD_WIFI, "AP scan done, %d networks", n);
+    } else if (n == WIFI_SCAN_FAILED) {
+        apScanRunning = false;
+        LOG_W(LOG_MOD_WIFI, "AP scan failed");
+    }
 }
 
-String WIFIC_getStationIp()
+void WIFIC_formatStationIp(char* buf, size_t size)
 {
-    if (WiFi.status() == WL_CONNECTED){
-        return WiFi.localIP().toString();
+    buf[0] = 0;
+    if (WiFi.status() == WL_CONNECTED) {
+        IPAddress ip = WiFi.localIP();
+        snprintf(buf, size, "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
     }
-    return "";
 }
 
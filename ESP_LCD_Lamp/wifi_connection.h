@@ -3,12 +3,15 @@
 
 extern void WIFIC_init(void);
 extern void WIFIC_stationMode(void);
-extern void WIFIC_setStSSID(String new_ssid);
-extern void WIFIC_setStPass(String new_pass);
-extern String WIFIC_getApList(void);
-extern String WIFIC_getStSSID(void);
-extern String WIFIC_getStPass(void);
+extern bool WIFIC_setCredentials(const char* ssid, const char* pass);   // saved together, false if too long
+extern void WIFIC_process(void);
+extern bool WIFIC_scanAps(void);                              // true if the cached AP list is fresh, else starts a scan
+extern bool WIFIC_isScanning(void);
+extern size_t WIFIC_getApListJson(char* buf, size_t size);    // cached APs as a JSON array
+extern const char* WIFIC_getStSSID(void);
+extern const char* WIFIC_getStPass(void);
 extern char* WIFIC_getDeviceName(void);
-extern String WIFIC_getStationIp(void);
+extern void WIFIC_formatStationIp(char* buf, size_t size);   // "" while not connected
+extern uint32_t WIFIC_getGotIpMs(void);                       // ms from boot to the first GotIP, 0 until then
 
 #endif
@@ -0,0 +1,289 @@
+/*
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *
+ *  Allocation and latency benchmark of the firmware hot paths, on the host build.
+ *  malloc() and friends are interposed to count allocations, bytes and the peak of live
+ *  heap per operation. Results go out as JSON, tools/check_bench.py compares them to
+ *  sim/bench_baseline.json so the "bench" target fails when a path starts allocating.
+ *  Heap numbers are those of the host stand-ins, e.g. String is std::string here.
+ */
+#include <Arduino.h>
+#include <malloc.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "config.h"
+#include "config_store.h"
+#include "event_bus.h"
+#include "http_server.h"
+#include "lcd_display.h"
+#include "logger.h"
+#include "metrics.h"
+#include "timezones.h"
+#include "web_socket.h"
+#include "wifi_connection.h"
+#include "sim.h"
+
+#define BENCH_ITERATIONS  (20000)
+#define BENCH_WARMUP      (100)
+#define WIFI_SCAN_WAIT_MS (5000)
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t n, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+extern "C" void __libc_free(void* ptr);
+
+typedef struct {
+  uint64_t allocs;
+  uint64_t bytes;
+  int64_t live;
+  int64_t peak;
+} AllocStats;
+
+typedef struct {
+  const char* name;
+  void (*op)(uint32_t i);
+} BenchOp;
+
+static AllocStats heap;
+static bool tracking = false;
+
+static void trackAlloc(void* ptr)
+{
+  if(tracking && ptr){
+    size_t size = malloc_usable_size(ptr);
+    heap.allocs++;
+    heap.bytes += size;
+    heap.live += size;
+    if(heap.live > heap.peak){
+      heap.peak = heap.live;
+    }
+  }
+}
+
+static void trackFree(void* ptr)
+{
+  if(tracking && ptr){
+    heap.live -= malloc_usable_size(ptr);
+  }
+}
+
+extern "C" void* malloc(size_t size)
+{
+  void* ptr = __libc_malloc(size);
+  trackAlloc(ptr);
+  return ptr;
+}
+
+extern "C" void* calloc(size_t n, size_t size)
+{
+  void* ptr = __libc_calloc(n, size);
+  trackAlloc(ptr);
+  return ptr;
+}
+
+extern "C" void* realloc(void* ptr, size_t size)
+{
+  trackFree(ptr);
+  ptr = __libc_realloc(ptr, size);
+  trackAlloc(ptr);
+  return ptr;
+}
+
+extern "C" void free(void* ptr)
+{
+  trackFree(ptr);
+  __libc_free(ptr);
+}
+
+// ---- Operations ----
+static char line[LOG_LINE_SIZE];
+static uint32_t sink = 0;
+
+static void opLogWrite(uint32_t i)
+{
+  LOG_I(LOG_MOD_MAIN, "bench %u %s", i, "record");
+}
+
+static void opLogFormat(uint32_t i)
+{
+  sink += LOG_format(LOG_firstSeq() + i % (LOG_nextSeq() - LOG_firstSeq()), line, sizeof(line));
+}
+
+static void onBenchEvent(const Event* evt)
+{
+  sink += evt->value;
+}
+
+static void opEvent(uint32_t i)
+{
+  EVT_post(EVT_BUTTON, i);
+  EVT_process();
+}
+
+static void opTzToLocal(uint32_t i)
+{
+  sink += (uint32_t)TZ_toLocal(1766000000 + (time_t)i * 3600);
+}
+
+static void opClockMinute(uint32_t i)
+{
+  LCD_drawClock((i / 60) % 24, i % 60);
+}
+
+static void opLcdWrite(uint32_t i)
+{
+  if((i % 8) == 0){
+    LCD_clear();
+  }
+  LCD_write(WIFIC_getDeviceName());
+  LCD_write("\n");
+}
+
+static void countText(const char* text)
+{
+  sink += strlen(text);
+}
+
+static void opMetrics(uint32_t i)
+{
+  MET_writePrometheus(countText);
+}
+
+static void opCfgSaveUnchanged(uint32_t i)
+{
+  sink += CFG_save();
+}
+
+static void countBytes(const char* data, size_t len)
+{
+  sink += len;
+}
+
+/* The whole request path: parsing, dispatch, streamTemplate() and the chunked response. */
+static void opHttpStartPage(uint32_t i)
+{
+  SIMHTTP_request("GET / HTTP/1.1\r\nHost: lamp\r\n\r\n", countBytes);
+}
+
+static int8_t wsClient = -1;
+
+/* A JSON command parsed in place, answered with a full snapshot of the fields. */
+static void opWsStatus(uint32_t i)
+{
+  SIMWS_receive(wsClient, "{\"STATUS\":1}");
+}
+
+/* A light change serialised as a delta frame to the subscribed client. */
+static void opWsDelta(uint32_t i)
+{
+  EVT_post(EVT_LIGHT_CHANGED, i & 1);
+  EVT_process();
+  WS_process();
+}
+
+static void opApListJson(uint32_t i)
+{
+  char json[1024];
+  sink += WIFIC_getApListJson(json, sizeof(json));
+}
+
+static const BenchOp OPS[] = {
+  { "log_write",          opLogWrite },
+  { "log_format",         opLogFormat },
+  { "event_post_process", opEvent },
+  { "tz_to_local",        opTzToLocal },
+  { "lcd_clock_minute",   opClockMinute },
+  { "lcd_write",          opLcdWrite },
+  { "metrics_prometheus", opMetrics },
+  { "cfg_save_unchanged", opCfgSaveUnchanged },
+  { "http_start_page",    opHttpStartPage },
+  { "ws_status",          opWsStatus },
+  { "ws_delta",           opWsDelta },
+  { "ap_list_json",       opApListJson },
+};
+#define OP_COUNT  (sizeof(OPS) / sizeof(OPS[0]))
+
+static uint64_t hostNs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int main(int argc, char** argv)
+{
+  uint32_t iterations = BENCH_ITERATIONS;
+  const char* jsonPath = nullptr;
+
+  for(int i = 1; i + 1 < argc; i += 2){
+    if(strcmp(argv[i], "--json") == 0){
+      jsonPath = argv[i + 1];
+    }else if(strcmp(argv[i], "--iterations") == 0){
+      iterations = strtoul(argv[i + 1], nullptr, 0);
+    }
+  }
+
+  FILE* out = jsonPath ? fopen(jsonPath, "w") : stdout;
+  if(out == nullptr){
+    fprintf(stderr, "cannot write %s\n", jsonPath);
+    return 1;
+  }
+
+  /* Quiet the serial echo, the log ring itself is part of what is measured. */
+  int devNull = open("/dev/null", O_WRONLY);
+  fflush(stdout);
+  int savedStdout = dup(1);
+  dup2(devNull, 1);
+
+  CFG_init();
+  LCD_init();
+  TZ_init();
+  WIFIC_init();     // the AP name, there are no credentials to connect with
+  WS_init();
+  HTTP_SERVER_init();
+  EVT_subscribe(EVT_BUTTON, onBenchEvent);
+
+  /* A finished scan in the AP cache and one socketless client on the light topic. */
+  WIFIC_scanAps();
+  delay(WIFI_SCAN_WAIT_MS);
+  WIFIC_process();
+  wsClient = SIMWS_connect(countBytes);
+  SIMWS_receive(wsClient, "{\"SUB\":\"light\"}");
+  LOG_I(LOG_MOD_MAIN, "bench start");
+
+  AllocStats results[OP_COUNT];
+  uint64_t nsPerOp[OP_COUNT];
+
+  for(uint8_t n = 0; n < OP_COUNT; n++){
+    for(uint32_t i = 0; i < BENCH_WARMUP; i++){
+      OPS[n].op(i);
+    }
+    memset(&heap, 0, sizeof(heap));
+    tracking = true;
+    uint64_t start = hostNs();
+    for(uint32_t i = 0; i < iterations; i++){
+      OPS[n].op(i);
+    }
+    nsPerOp[n] = (hostNs() - start) / iterations;
+    tracking = false;
+    results[n] = heap;
+    LOG_process();
+  }
+
+  fflush(stdout);
+  dup2(savedStdout, 1);
+
+  fprintf(out, "{\n  \"iterations\": %u,\n  \"ops\": [\n", iterations);
+  for(uint8_t n = 0; n < OP_COUNT; n++){
+    fprintf(out, "    {\"name\": \"%s\", \"ns_per_op\": %llu, \"allocs_per_op\": %.3f, "
+                 "\"bytes_per_op\": %.1f, \"peak_bytes\": %lld}%s\n",
+            OPS[n].name, (unsigned long long)nsPerOp[n], (double)results[n].allocs / iterations,
+            (double)results[n].bytes / iterations, (long long)results[n].peak, (n + 1u < OP_COUNT) ? "," : "");
+  }
+  fprintf(out, "  ]\n}\n");
+  if(out != stdout){
+    fclose(out);
+  }
+  return (sink == 0xFFFFFFFF) ? 1 : 0;    // keeps the results of the operations alive
+}
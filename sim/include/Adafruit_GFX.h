@@ -0,0 +1,77 @@
+/* Host stand-in for the drawing primitives the firmware uses, rendered into the simulated panel.
+ * There is no font: every printable character is drawn as a solid 5x7 cell scaled by the text size. */
+#ifndef SIM_ADAFRUIT_GFX_H
+#define SIM_ADAFRUIT_GFX_H
+
+#include <Arduino.h>
+#include "sim.h"
+
+class Adafruit_GFX {
+  public:
+    Adafruit_GFX(int16_t w, int16_t h) : _width(w), _height(h) {}
+
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color){
+      SIMPANEL_fillRect(x, y, w, h, color);
+    }
+
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color){
+      int16_t dx = abs(x1 - x0), sx = (x0 < x1) ? 1 : -1;
+      int16_t dy = -abs(y1 - y0), sy = (y0 < y1) ? 1 : -1;
+      int16_t err = dx + dy;
+      for(;;){
+        SIMPANEL_fillRect(x0, y0, 1, 1, color);
+        if((x0 == x1) && (y0 == y1)){
+          break;
+        }
+        int16_t e2 = 2 * err;
+        if(e2 >= dy){ err += dy; x0 += sx; }
+        if(e2 <= dx){ err += dx; y0 += sy; }
+      }
+    }
+
+    void setCursor(int16_t x, int16_t y){ cursorX = x; cursorY = y; }
+    void setTextColor(uint16_t c){ textColor = c; }
+    void setTextSize(uint8_t s){ textSize = (s > 0) ? s : 1; }
+
+    size_t print(const char* text){
+      size_t n = 0;
+      for(; *text; text++, n++){
+        writeChar(*text);
+      }
+      return n;
+    }
+    size_t print(const String& text){ return print(text.c_str()); }
+    size_t println(const char* text){ return print(text) + print("\n"); }
+    size_t println(const String& text){ return println(text.c_str()); }
+
+  protected:
+    int16_t _width;
+    int16_t _height;
+
+  private:
+    void writeChar(char c){
+      if(c == '\n'){
+        cursorX = 0;
+        cursorY += 8 * textSize;
+        return;
+      }
+      if(c == '\r'){
+        return;
+      }
+      if((cursorX + 6 * textSize) > _width){
+        cursorX = 0;
+        cursorY += 8 * textSize;
+      }
+      if(c != ' '){
+        SIMPANEL_fillRect(cursorX, cursorY, 5 * textSize, 7 * textSize, textColor);
+      }
+      cursorX += 6 * textSize;
+    }
+
+    int16_t cursorX = 0;
+    int16_t cursorY = 0;
+    uint16_t textColor = 0xFFFF;
+    uint8_t textSize = 1;
+};
+
+#endif
@@ -0,0 +1,22 @@
+/* Host stand-in for the ST7789 driver, pixels go into the simulated panel. */
+#ifndef SIM_ADAFRUIT_ST7789_H
+#define SIM_ADAFRUIT_ST7789_H
+
+#include "Adafruit_GFX.h"
+
+class Adafruit_ST7789 : public Adafruit_GFX {
+  public:
+    Adafruit_ST7789(int8_t cs, int8_t dc, int8_t rst) : Adafruit_GFX(SIM_PANEL_W, SIM_PANEL_H) {}
+    void init(uint16_t w, uint16_t h, uint8_t mode){ _width = w; _height = h; }
+    void setSPISpeed(uint32_t hz){}
+    void startWrite(void){}
+    void endWrite(void){}
+    void setAddrWindow(int16_t x, int16_t y, int16_t w, int16_t h){ SIMPANEL_setWindow(x, y, w, h); }
+    void writePixels(const uint16_t* pixels, uint32_t count){ SIMPANEL_push(pixels, count); }
+
+  protected:
+    int16_t _xstart = 0;
+    int16_t _ystart = 0;
+};
+
+#endif
@@ -0,0 +1,105 @@
+/* 
+ *  Host stand-in for the parts of the ESP8266 Arduino core the firmware uses.
+ *  Time comes from the simulator's virtual clock, GPIO and flash are kept in memory.
+ */
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+#include "pgmspace.h"
+
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+
+#define HIGH            1
+#define LOW             0
+#define INPUT           0
+#define OUTPUT          1
+#define INPUT_PULLUP    2
+#define CHANGE          3
+#define IRAM_ATTR
+#define DEG_TO_RAD      0.017453292519943295
+
+#define digitalPinToInterrupt(pin)  (pin)
+#define constrain(x, lo, hi)        ((x) < (lo) ? (lo) : ((x) > (hi) ? (hi) : (x)))
+
+/* Like the core, min() and max() accept mixed argument types. */
+template<typename T, typename L> inline auto min(const T& a, const L& b) -> decltype((b < a) ? b : a) { return (b < a) ? b : a; }
+template<typename T, typename L> inline auto max(const T& a, const L& b) -> decltype((b < a) ? b : a) { return (a < b) ? b : a; }
+
+extern uint32_t millis(void);
+extern uint32_t micros(void);
+extern void delay(uint32_t ms);
+extern void yield(void);
+extern long random(long howBig);
+extern long random(long howSmall, long howBig);
+extern void randomSeed(unsigned long seed);
+
+extern void pinMode(uint8_t pin, uint8_t mode);
+extern void digitalWrite(uint8_t pin, uint8_t value);
+extern int digitalRead(uint8_t pin);
+extern void attachInterrupt(uint8_t pin, void (*isr)(void), int mode);
+extern void analogWrite(uint8_t pin, int value);
+extern void analogWriteRange(uint32_t range);
+extern void analogWriteFreq(uint32_t freq);
+
+/* Interrupts do not preempt the simulated loop, so the critical section helpers are no-ops. */
+static inline uint32_t xt_rsil(uint32_t level) { (void)level; return 0; }
+static inline void xt_wsr_ps(uint32_t state) { (void)state; }
+
+class String {
+  public:
+    String(const char* s = "") : s_(s ? s : "") {}
+    String(const std::string& s) : s_(s) {}
+    const char* c_str() const { return s_.c_str(); }
+    size_t length() const { return s_.length(); }
+    bool equals(const char* s) const { return s_ == s; }
+    bool equals(const String& s) const { return s_ == s.s_; }
+    String operator+(const String& rhs) const { return String(s_ + rhs.s_); }
+    String operator+(const char* rhs) const { return String(s_ + rhs); }
+    void toCharArray(char* buf, size_t size) const {
+      if(size > 0){
+        size_t n = std::min(size - 1, s_.length());
+        memcpy(buf, s_.data(), n);
+        buf[n] = 0;
+      }
+    }
+  private:
+    std::string s_;
+};
+
+class HardwareSerial {
+  public:
+    void begin(unsigned long baud) { (void)baud; }
+    int availableForWrite(void) { return 128; }
+    size_t write(const char* buf, size_t len) { return fwrite(buf, 1, len, stdout); }
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+extern HardwareSerial Serial;
+
+class EspClass {
+  public:
+    uint32_t getFreeHeap(void);
+    uint8_t getHeapFragmentation(void);
+    uint32_t getMaxFreeBlockSize(void);
+    uint32_t random(void);
+    uint32_t getSketchSize(void) { return 400 * 1024; }   // about what the sketch builds to
+    bool flashEraseSector(uint32_t sector);
+    bool flashWrite(uint32_t address, const uint32_t* data, size_t size);
+    bool flashRead(uint32_t address, uint32_t* data, size_t size);
+    bool rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size);
+    bool rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size);
+    void wdtFeed(void) {}
+};
+extern EspClass ESP;
+
+#endif
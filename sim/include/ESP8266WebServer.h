@@ -0,0 +1,94 @@
+/*
+ *  Host stand-in for ESP8266WebServer, on a POSIX socket.
+ *  One request per handleClient() call and one request per connection, like the library
+ *  without keep-alive. Responses of unknown length go out chunked, the rest with Content-Length.
+ *  Requests can also be handed in without a socket, see SIMHTTP_request() in sim.h.
+ */
+#ifndef SIM_ESP8266WEBSERVER_H
+#define SIM_ESP8266WEBSERVER_H
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+
+#define HTTP_REQUEST_SIZE       (2048)
+#define HTTP_MAX_ARGS           (8)
+#define HTTP_MAX_HEADERS        (4)
+#define HTTP_HEADER_BUF_SIZE    (512)
+#define CONTENT_LENGTH_UNKNOWN  ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET  ((size_t)-2)
+
+typedef enum { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS } HTTPMethod;
+
+class ESP8266WebServer {
+  public:
+    typedef std::function<void(void)> THandlerFunction;
+    typedef void (*Sink)(const char* data, size_t len);
+
+    ESP8266WebServer(int port = 80);
+    ~ESP8266WebServer();
+
+    void begin(void);
+    void close(void);
+    void handleClient(void);
+
+    void on(const char* uri, THandlerFunction handler);
+    void on(const char* uri, HTTPMethod method, THandlerFunction handler);
+    void onNotFound(THandlerFunction handler);
+    void collectHeaders(const char* headerKeys[], size_t count);
+
+    String arg(const char* name);
+    bool hasArg(const char* name);
+    String header(const char* name);
+    HTTPMethod method(void) { return method_; }
+
+    void setContentLength(size_t length) { contentLength_ = length; }
+    void sendHeader(const char* name, const char* value, bool first = false);
+    void send(int code, const char* contentType = nullptr, const char* content = "");
+    void send_P(int code, PGM_P contentType, PGM_P content, size_t length);
+    void sendContent(const char* content, size_t length);
+    void sendContent(const char* content) { sendContent(content, strlen(content)); }
+
+    /* Host only: serves one raw request, the response goes to sink. */
+    void serve(const char* request, size_t length, Sink sink);
+
+  private:
+    struct Route {
+      const char* uri;
+      HTTPMethod method;
+      THandlerFunction handler;
+    };
+    struct Pair {
+      const char* key;
+      const char* value;
+    };
+
+    bool parse(size_t length);
+    void dispatch(void);
+    void write(const char* data, size_t length);
+    void sendHead(int code, const char* contentType, size_t length);
+
+    int port_;
+    int listenFd_;
+    int clientFd_;
+    Sink sink_;
+    std::vector<Route> routes_;
+    THandlerFunction notFound_;
+    const char* collect_[HTTP_MAX_HEADERS];
+    size_t collectCount_;
+
+    HTTPMethod method_;
+    const char* uri_;
+    char request_[HTTP_REQUEST_SIZE + 1];
+    Pair args_[HTTP_MAX_ARGS];
+    size_t argCount_;
+    Pair headers_[HTTP_MAX_HEADERS];
+    size_t headerCount_;
+
+    char extraHeaders_[HTTP_HEADER_BUF_SIZE];
+    size_t extraLen_;
+    size_t contentLength_;
+    bool chunked_;
+};
+
+#endif
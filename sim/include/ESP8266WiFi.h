@@ -0,0 +1,116 @@
+/*
+ *  Host stand-in for the ESP8266WiFi library: the address type and the parts of the WiFi object
+ *  the firmware uses. The simulated network behind it lives in sim_net.cpp.
+ */
+#ifndef SIM_ESP8266WIFI_H
+#define SIM_ESP8266WIFI_H
+
+#include <Arduino.h>
+#include <functional>
+#include <memory>
+#include "lwip/dns.h"
+
+class IPAddress {
+  public:
+    IPAddress(uint32_t addr = 0) : addr_(addr) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : addr_(a | (b << 8) | (c << 16) | ((uint32_t)d << 24)) {}
+    IPAddress(const ip_addr_t* ip) : addr_(ip->addr) {}
+    operator uint32_t() const { return addr_; }
+    uint8_t operator[](int i) const { return (addr_ >> (8 * i)) & 0xFF; }
+    bool operator==(const IPAddress& rhs) const { return addr_ == rhs.addr_; }
+    bool operator!=(const IPAddress& rhs) const { return addr_ != rhs.addr_; }
+  private:
+    uint32_t addr_;
+};
+
+typedef enum {
+  WIFI_OFF = 0,
+  WIFI_STA = 1,
+  WIFI_AP = 2,
+  WIFI_AP_STA = 3
+} WiFiMode_t;
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+enum {
+  ENC_TYPE_WEP = 5,
+  ENC_TYPE_TKIP = 2,
+  ENC_TYPE_CCMP = 4,
+  ENC_TYPE_NONE = 7,
+  ENC_TYPE_AUTO = 8
+};
+
+#define WIFI_SCAN_RUNNING   (-1)
+#define WIFI_SCAN_FAILED    (-2)
+
+typedef enum {
+  WIFI_DISCONNECT_REASON_UNSPECIFIED = 1,
+  WIFI_DISCONNECT_REASON_NO_AP_FOUND = 201,
+} WiFiDisconnectReason;
+
+struct WiFiEventStationModeConnected {
+  String ssid;
+  uint8_t bssid[6];
+  uint8_t channel;
+};
+
+struct WiFiEventStationModeGotIP {
+  IPAddress ip;
+  IPAddress mask;
+  IPAddress gw;
+};
+
+struct WiFiEventStationModeDisconnected {
+  String ssid;
+  uint8_t bssid[6];
+  WiFiDisconnectReason reason;
+};
+
+/* As in the core, a callback stays registered only while its handler is held. */
+struct WiFiEventHandlerOpaque {
+  uint8_t event;
+  std::function<void(const void*)> callback;
+};
+typedef std::shared_ptr<WiFiEventHandlerOpaque> WiFiEventHandler;
+
+class ESP8266WiFiClass {
+  public:
+    bool mode(WiFiMode_t mode);
+    bool setAutoReconnect(bool autoReconnect);
+    void persistent(bool persistent);
+    String macAddress(void);
+
+    bool softAPConfig(IPAddress local, IPAddress gateway, IPAddress subnet);
+    bool softAP(const char* ssid, const char* pass = nullptr);
+
+    bool config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns = (uint32_t)0);
+    wl_status_t begin(const char* ssid, const char* pass = nullptr, int32_t channel = 0, const uint8_t* bssid = nullptr);
+    wl_status_t status(void);
+    uint8_t* BSSID(void);
+    int32_t channel(void);
+    IPAddress localIP(void);
+    IPAddress gatewayIP(void);
+    IPAddress subnetMask(void);
+    IPAddress dnsIP(uint8_t dnsNo = 0);
+
+    WiFiEventHandler onStationModeConnected(std::function<void(const WiFiEventStationModeConnected&)> callback);
+    WiFiEventHandler onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP&)> callback);
+    WiFiEventHandler onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected&)> callback);
+
+    int8_t scanNetworks(bool async = false);
+    int8_t scanComplete(void);
+    void scanDelete(void);
+    String SSID(uint8_t i);
+    int32_t RSSI(uint8_t i);
+    int32_t channel(uint8_t i);
+    uint8_t encryptionType(uint8_t i);
+};
+extern ESP8266WiFiClass WiFi;
+
+#endif
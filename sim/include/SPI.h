@@ -0,0 +1,16 @@
+/* Host stand-in: the panel is a framebuffer, there is no bus to set up. */
+#ifndef SIM_SPI_H
+#define SIM_SPI_H
+
+#include <Arduino.h>
+
+#define MSBFIRST    1
+#define SPI_MODE3   3
+
+class SPIClass {
+  public:
+    void begin(void) {}
+};
+extern SPIClass SPI;
+
+#endif
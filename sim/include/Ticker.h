@@ -0,0 +1,20 @@
+/* Host stand-in: callbacks run from delay(), where the SDK timers would fire on the device. */
+#ifndef SIM_TICKER_H
+#define SIM_TICKER_H
+
+#include <Arduino.h>
+
+class Ticker {
+  public:
+    void attach_ms(uint32_t ms, void (*cb)(void));
+    void detach(void);
+    bool active(void) const { return attached; }
+
+    uint8_t slot = 0xFF;
+    uint32_t generation = 0;
+    uint32_t periodMs = 0;
+    void (*callback)(void) = nullptr;
+    bool attached = false;
+};
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ *  Host stand-in for the WebSocketsServer library, on a POSIX socket.
+ *  Handshake, masked client frames up to WEBSOCKETS_MAX_DATA_SIZE, ping and close.
+ *  Fragmented messages are not supported. Clients without a socket are added through SIMWS_connect().
+ */
+#ifndef SIM_WEBSOCKETSSERVER_H
+#define SIM_WEBSOCKETSSERVER_H
+
+#include <Arduino.h>
+#include <functional>
+
+#define WEBSOCKETS_SERVER_CLIENT_MAX  (5)
+#define WEBSOCKETS_MAX_DATA_SIZE      (1024)
+#define WEBSOCKETS_MAX_HEADER_SIZE    (1024)
+
+typedef enum {
+  WStype_ERROR,
+  WStype_DISCONNECTED,
+  WStype_CONNECTED,
+  WStype_TEXT,
+  WStype_BIN,
+  WStype_FRAGMENT_TEXT_START,
+  WStype_FRAGMENT_BIN_START,
+  WStype_FRAGMENT,
+  WStype_FRAGMENT_FIN,
+  WStype_PING,
+  WStype_PONG,
+} WStype_t;
+
+class WebSocketsServer {
+  public:
+    typedef std::function<void(uint8_t num, WStype_t type, uint8_t* payload, size_t length)> WebSocketServerEvent;
+    typedef void (*Sink)(const char* data, size_t len);
+
+    WebSocketsServer(uint16_t port);
+    ~WebSocketsServer();
+
+    void begin(void);
+    void close(void);
+    void loop(void);
+    void onEvent(WebSocketServerEvent cbEvent) { event_ = cbEvent; }
+
+    bool sendTXT(uint8_t num, uint8_t* payload, size_t length = 0);
+    bool sendTXT(uint8_t num, const char* payload) { return sendTXT(num, (uint8_t*)payload, strlen(payload)); }
+    bool sendBIN(uint8_t num, uint8_t* payload, size_t length);
+    void disconnect(uint8_t num);
+    uint8_t connectedClients(bool ping = false);
+
+    /* Host only: clients without a socket. */
+    int8_t connectSink(Sink sink);
+    void receive(uint8_t num, WStype_t type, const uint8_t* payload, size_t length);
+
+  private:
+    struct Client {
+      int fd;
+      Sink sink;
+      bool upgraded;
+      size_t rxLen;
+      uint8_t rx[WEBSOCKETS_MAX_HEADER_SIZE + WEBSOCKETS_MAX_DATA_SIZE];
+    };
+
+    void accept(void);
+    void read(uint8_t num);
+    bool handshake(uint8_t num);
+    bool frame(uint8_t num);
+    bool sendFrame(uint8_t num, uint8_t opcode, const uint8_t* payload, size_t length);
+    bool writeAll(int fd, const uint8_t* data, size_t length);
+
+    uint16_t port_;
+    int listenFd_;
+    WebSocketServerEvent event_;
+    Client clients_[WEBSOCKETS_SERVER_CLIENT_MAX];
+    uint8_t message_[WEBSOCKETS_MAX_DATA_SIZE + 1];
+};
+
+#endif
@@ -0,0 +1,24 @@
+/* Host stand-in: a loopback NTP server answers every request sent to port 123, see sim_net.cpp. */
+#ifndef SIM_WIFIUDP_H
+#define SIM_WIFIUDP_H
+
+#include <ESP8266WiFi.h>
+
+class WiFiUDP {
+  public:
+    uint8_t begin(uint16_t port);
+    int beginPacket(IPAddress ip, uint16_t port);
+    size_t write(const uint8_t* buf, size_t size);
+    int endPacket(void);
+    int parsePacket(void);
+    int read(uint8_t* buf, size_t size);
+    void flush(void);
+    IPAddress remoteIP(void);
+  private:
+    IPAddress remote_;
+    uint16_t remotePort_ = 0;
+    uint8_t tx_[48];
+    size_t txLen_ = 0;
+};
+
+#endif
@@ -0,0 +1,358 @@
+/*
+ *  Fallback for ArduinoJson 6 when the library is not installed on the host, see CMakeLists.txt.
+ *  Covers what the firmware uses: deserializeJson() of a mutable buffer in place into a
+ *  StaticJsonDocument, iterating the root object and reading string or integer values.
+ *  Nested objects and arrays are validated but read as null. Nothing is allocated.
+ */
+#ifndef SIM_ARDUINOJSON_H
+#define SIM_ARDUINOJSON_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JSON_SLOT_SIZE        (16)      // bytes per value on the ESP8266, sets the document capacity
+#define JSON_NESTING_LIMIT    (10)
+
+class DeserializationError {
+  public:
+    enum Code { Ok, EmptyInput, IncompleteInput, InvalidInput, NoMemory, TooDeep };
+
+    DeserializationError(Code code = Ok) : code_(code) {}
+    explicit operator bool() const { return code_ != Ok; }
+    Code code() const { return code_; }
+    const char* c_str() const {
+      static const char* const names[] = { "Ok", "EmptyInput", "IncompleteInput", "InvalidInput", "NoMemory", "TooDeep" };
+      return names[code_];
+    }
+
+  private:
+    Code code_;
+};
+
+class JsonString {
+  public:
+    JsonString(const char* str = nullptr) : str_(str) {}
+    const char* c_str() const { return str_; }
+
+  private:
+    const char* str_;
+};
+
+class JsonVariant {
+  public:
+    enum Type { TYPE_NULL, TYPE_STRING, TYPE_NUMBER, TYPE_BOOL };
+
+    JsonVariant() : type_(TYPE_NULL), str_(nullptr), num_(0) {}
+    bool isNull() const { return type_ == TYPE_NULL; }
+    template<typename T> bool is() const;
+    template<typename T> T as() const;
+
+    Type type_;
+    const char* str_;
+    double num_;
+};
+
+template<> inline bool JsonVariant::is<const char*>() const { return type_ == TYPE_STRING; }
+template<> inline bool JsonVariant::is<int32_t>() const { return type_ == TYPE_NUMBER; }
+template<> inline bool JsonVariant::is<bool>() const { return type_ == TYPE_BOOL; }
+template<> inline const char* JsonVariant::as<const char*>() const { return (type_ == TYPE_STRING) ? str_ : nullptr; }
+template<> inline int32_t JsonVariant::as<int32_t>() const { return ((type_ == TYPE_NUMBER) || (type_ == TYPE_BOOL)) ? (int32_t)num_ : 0; }
+template<> inline bool JsonVariant::as<bool>() const { return ((type_ == TYPE_NUMBER) || (type_ == TYPE_BOOL)) && (num_ != 0); }
+
+class JsonPair {
+  public:
+    JsonString key() const { return key_; }
+    JsonVariant value() const { return value_; }
+
+    JsonString key_;
+    JsonVariant value_;
+};
+
+class JsonObject {
+  public:
+    JsonObject(const JsonPair* pairs = nullptr, size_t count = 0) : pairs_(pairs), count_(count) {}
+    const JsonPair* begin() const { return pairs_; }
+    const JsonPair* end() const { return pairs_ + count_; }
+    size_t size() const { return count_; }
+    bool isNull() const { return pairs_ == nullptr; }
+
+  private:
+    const JsonPair* pairs_;
+    size_t count_;
+};
+
+class JsonDocument {
+  public:
+    template<typename T> T as() const;
+    void clear() { count_ = 0; isObject_ = false; }
+
+    JsonPair* pairs_;
+    size_t capacity_;
+    size_t count_;
+    bool isObject_;
+
+  protected:
+    JsonDocument(JsonPair* pairs, size_t capacity) : pairs_(pairs), capacity_(capacity), count_(0), isObject_(false) {}
+    JsonDocument(const JsonDocument&) = delete;
+    JsonDocument& operator=(const JsonDocument&) = delete;
+};
+
+template<> inline JsonObject JsonDocument::as<JsonObject>() const
+{
+  return isObject_ ? JsonObject(pairs_, count_) : JsonObject();
+}
+
+template<size_t N>
+class StaticJsonDocument : public JsonDocument {
+  public:
+    StaticJsonDocument() : JsonDocument(slots_, N / JSON_SLOT_SIZE) {}
+
+  private:
+    JsonPair slots_[N / JSON_SLOT_SIZE];
+};
+
+class JsonInPlaceParser {
+  public:
+    JsonInPlaceParser(char* input, size_t length) : p_(input), end_(input + length) {}
+
+    DeserializationError parseRoot(JsonDocument& doc) {
+      skipSpace();
+      if(p_ == end_){
+        return DeserializationError::EmptyInput;
+      }
+      if(*p_ != '{'){
+        JsonVariant ignored;
+        return parseValue(&ignored, 0);
+      }
+      doc.isObject_ = true;
+      return parseObject(&doc, 0);
+    }
+
+  private:
+    void skipSpace() {
+      while((p_ < end_) && ((*p_ == ' ') || (*p_ == '\t') || (*p_ == '\r') || (*p_ == '\n'))){
+        p_++;
+      }
+    }
+
+    static int hex(char c) {
+      if((c >= '0') && (c <= '9')) return c - '0';
+      if((c >= 'a') && (c <= 'f')) return c - 'a' + 10;
+      if((c >= 'A') && (c <= 'F')) return c - 'A' + 10;
+      return -1;
+    }
+
+    /* Unescapes over the input, the result is NUL terminated where it ends. */
+    DeserializationError parseString(const char** out) {
+      char* start = ++p_;
+      char* w = start;
+      while(p_ < end_){
+        char c = *p_++;
+        if(c == '"'){
+          *w = 0;
+          *out = start;
+          return DeserializationError::Ok;
+        }
+        if((uint8_t)c < 0x20){
+          return DeserializationError::InvalidInput;
+        }
+        if(c != '\\'){
+          *w++ = c;
+          continue;
+        }
+        if(p_ == end_){
+          break;
+        }
+        c = *p_++;
+        switch(c){
+          case '"': case '\\': case '/': *w++ = c; break;
+          case 'b': *w++ = '\b'; break;
+          case 'f': *w++ = '\f'; break;
+          case 'n': *w++ = '\n'; break;
+          case 'r': *w++ = '\r'; break;
+          case 't': *w++ = '\t'; break;
+          case 'u': {
+            if(end_ - p_ < 4){
+              return DeserializationError::IncompleteInput;
+            }
+            uint32_t cp = 0;
+            for(uint8_t i = 0; i < 4; i++){
+              int h = hex(*p_++);
+              if(h < 0){
+                return DeserializationError::InvalidInput;
+              }
+              cp = (cp << 4) | h;
+            }
+            if(cp < 0x80){
+              *w++ = (char)cp;
+            }else if(cp < 0x800){
+              *w++ = (char)(0xC0 | (cp >> 6));
+              *w++ = (char)(0x80 | (cp & 0x3F));
+            }else{
+              *w++ = (char)(0xE0 | (cp >> 12));
+              *w++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+              *w++ = (char)(0x80 | (cp & 0x3F));
+            }
+            break;
+          }
+          default:
+            return DeserializationError::InvalidInput;
+        }
+      }
+      return DeserializationError::IncompleteInput;
+    }
+
+    DeserializationError parseLiteral(const char* word, JsonVariant* out, JsonVariant::Type type, double num) {
+      size_t len = strlen(word);
+      if((size_t)(end_ - p_) < len){
+        return DeserializationError::IncompleteInput;
+      }
+      if(strncmp(p_, word, len) != 0){
+        return DeserializationError::InvalidInput;
+      }
+      p_ += len;
+      out->type_ = type;
+      out->num_ = num;
+      return DeserializationError::Ok;
+    }
+
+    DeserializationError parseNumber(JsonVariant* out) {
+      char digits[32];
+      size_t len = 0;
+      while((p_ < end_) && (len < sizeof(digits) - 1) && (strchr("+-.eE0123456789", *p_) != nullptr)){
+        digits[len++] = *p_++;
+      }
+      digits[len] = 0;
+      char* stop;
+      double num = strtod(digits, &stop);
+      if((len == 0) || (*stop != 0)){
+        return DeserializationError::InvalidInput;
+      }
+      out->type_ = JsonVariant::TYPE_NUMBER;
+      out->num_ = num;
+      return DeserializationError::Ok;
+    }
+
+    /* Only the root object is kept, nested containers are checked and dropped. */
+    DeserializationError parseObject(JsonDocument* doc, uint8_t depth) {
+      p_++;
+      skipSpace();
+      if((p_ < end_) && (*p_ == '}')){
+        p_++;
+        return DeserializationError::Ok;
+      }
+      while(p_ < end_){
+        skipSpace();
+        if(p_ == end_){
+          break;
+        }
+        if(*p_ != '"'){
+          return DeserializationError::InvalidInput;
+        }
+        JsonPair pair;
+        const char* key;
+        DeserializationError err = parseString(&key);
+        if(err){
+          return err;
+        }
+        pair.key_ = JsonString(key);
+        skipSpace();
+        if(p_ == end_){
+          break;
+        }
+        if(*p_++ != ':'){
+          return DeserializationError::InvalidInput;
+        }
+        err = parseValue(&pair.value_, depth + 1);
+        if(err){
+          return err;
+        }
+        if(doc != nullptr){
+          if(doc->count_ == doc->capacity_){
+            return DeserializationError::NoMemory;
+          }
+          doc->pairs_[doc->count_++] = pair;
+        }
+        skipSpace();
+        if(p_ == end_){
+          break;
+        }
+        char c = *p_++;
+        if(c == '}'){
+          return DeserializationError::Ok;
+        }
+        if(c != ','){
+          return DeserializationError::InvalidInput;
+        }
+      }
+      return DeserializationError::IncompleteInput;
+    }
+
+    DeserializationError parseArray(uint8_t depth) {
+      p_++;
+      skipSpace();
+      if((p_ < end_) && (*p_ == ']')){
+        p_++;
+        return DeserializationError::Ok;
+      }
+      while(p_ < end_){
+        JsonVariant ignored;
+        DeserializationError err = parseValue(&ignored, depth + 1);
+        if(err){
+          return err;
+        }
+        skipSpace();
+        if(p_ == end_){
+          break;
+        }
+        char c = *p_++;
+        if(c == ']'){
+          return DeserializationError::Ok;
+        }
+        if(c != ','){
+          return DeserializationError::InvalidInput;
+        }
+      }
+      return DeserializationError::IncompleteInput;
+    }
+
+    DeserializationError parseValue(JsonVariant* out, uint8_t depth) {
+      if(depth > JSON_NESTING_LIMIT){
+        return DeserializationError::TooDeep;
+      }
+      skipSpace();
+      if(p_ == end_){
+        return DeserializationError::IncompleteInput;
+      }
+      switch(*p_){
+        case '"': {
+          DeserializationError err = parseString(&out->str_);
+          if(!err){
+            out->type_ = JsonVariant::TYPE_STRING;
+          }
+          return err;
+        }
+        case '{': return parseObject(nullptr, depth);
+        case '[': return parseArray(depth);
+        case 't': return parseLiteral("true", out, JsonVariant::TYPE_BOOL, 1);
+        case 'f': return parseLiteral("false", out, JsonVariant::TYPE_BOOL, 0);
+        case 'n': return parseLiteral("null", out, JsonVariant::TYPE_NULL, 0);
+        default:  return parseNumber(out);
+      }
+    }
+
+    char* p_;
+    char* end_;
+};
+
+/* Zero copy, like ArduinoJson with a mutable input: strings are left in the input buffer. */
+inline DeserializationError deserializeJson(JsonDocument& doc, char* input, size_t length)
+{
+  doc.clear();
+  JsonInPlaceParser parser(input, length);
+  return parser.parseRoot(doc);
+}
+
+#endif
@@ -0,0 +1,16 @@
+/* Host stand-in: every name resolves to the loopback NTP server at once. */
+#ifndef SIM_LWIP_DNS_H
+#define SIM_LWIP_DNS_H
+
+#include <stdint.h>
+
+typedef int8_t err_t;
+typedef struct { uint32_t addr; } ip_addr_t;
+typedef void (*dns_found_callback)(const char* name, const ip_addr_t* ipaddr, void* arg);
+
+#define ERR_OK          0
+#define ERR_INPROGRESS  -5
+
+extern err_t dns_gethostbyname(const char* hostname, ip_addr_t* addr, dns_found_callback found, void* arg);
+
+#endif
@@ -0,0 +1,7 @@
+/* Host stand-in: the simulator keeps flash sectors in memory. */
+#ifndef SIM_SPI_FLASH_H
+#define SIM_SPI_FLASH_H
+
+#define SPI_FLASH_SEC_SIZE      4096
+
+#endif
@@ -0,0 +1,42 @@
+/*
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *
+ *  Host replacement of lcd_bus.cpp: the same window and pixel stream calls,
+ *  written into the simulated panel instead of the HSPI FIFO.
+ */
+#include <Arduino.h>
+#include "lcd_bus.h"
+#include "sim.h"
+
+static int16_t panelX = 0;
+static int16_t panelY = 0;
+
+void LCDBUS_init(int16_t xOffset, int16_t yOffset)
+{
+  panelX = xOffset;
+  panelY = yOffset;
+}
+
+void LCDBUS_begin()
+{
+}
+
+void LCDBUS_end()
+{
+}
+
+void LCDBUS_setWindow(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+  SIMPANEL_setWindow(x + panelX, y + panelY, w, h);
+}
+
+void LCDBUS_fill(uint16_t color, uint32_t count)
+{
+  SIMPANEL_fill(color, count);
+}
+
+void LCDBUS_push(const uint16_t* pixels, uint32_t count)
+{
+  SIMPANEL_push(pixels, count);
+}
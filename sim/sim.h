@@ -0,0 +1,61 @@
+/* 
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *  
+ *  Host simulator interface.
+ *  The firmware modules are compiled unchanged against the stand-in headers in sim/include.
+ *  This header is what the stand-ins and the simulator main share.
+ */
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+
+#define SIM_PANEL_W         (240)
+#define SIM_PANEL_H         (240)
+#define SIM_LOOPBACK_IP     (0x0100007FUL)    // 127.0.0.1 in lwIP byte order
+
+typedef void (*SimAction)(uint32_t arg);
+typedef void (*SimSink)(const char* data, size_t len);
+
+// ---- Virtual clock and scheduled actions (sim_core.cpp) ----
+/* millis() and micros() follow host time while code runs, delay() jumps ahead instead of sleeping,
+ * so idle time costs nothing and busy time is measured on the host CPU. */
+extern void SIM_setRealtime(bool realtime);         // delay() really sleeps
+extern bool SIM_at(uint32_t ms, SimAction action, uint32_t arg);   // runs from delay(), like an interrupt or SDK callback
+extern void SIM_runDue(void);
+extern void SIM_setPin(uint8_t pin, uint8_t level); // calls the pin's interrupt handler on a change
+extern uint8_t SIM_getPin(uint8_t pin);
+extern uint16_t SIM_getDuty(uint8_t pin);          // last analogWrite() value
+extern void SIM_setPortOffset(uint16_t offset);     // servers listen on 127.0.0.1 at port + offset, 0 keeps them off
+extern int SIM_listen(uint16_t port);               // a non blocking listening socket, -1 if there is none
+
+// ---- Panel (sim_panel.cpp) ----
+extern void SIMPANEL_setWindow(int16_t x, int16_t y, int16_t w, int16_t h);
+extern void SIMPANEL_push(const uint16_t* pixels, uint32_t count);
+extern void SIMPANEL_fill(uint16_t color, uint32_t count);
+extern void SIMPANEL_fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+extern uint64_t SIMPANEL_getPixelWrites(void);
+extern bool SIMPANEL_writePpm(const char* path);
+
+// ---- Network (sim_net.cpp) ----
+#define SIMNET_SSID         "SimNet"          // the one network the station can join
+#define SIMNET_PASS         "lamp-sim"
+
+extern void SIMNET_setUtc(time_t utc);              // true UTC at virtual time 0
+extern void SIMNET_setDriftPpm(int32_t ppm);        // how much faster true time runs than millis()
+extern void SIMNET_setNtpLatencyMs(uint32_t ms);
+extern void SIMNET_setConnectMs(uint32_t ms);       // SIMNET_SSID can be joined from this virtual time, 0 never
+
+// ---- Servers without a socket (sim_http.cpp, sim_ws.cpp) ----
+/* The same paths a socket client takes, for the benchmark and the tests.
+ * WebSocket clients get message payloads without framing. */
+extern bool SIMHTTP_request(const char* request, SimSink sink);   // a whole raw request, false without a server
+extern int8_t SIMWS_connect(SimSink sink);          // the client number, -1 if all slots are taken
+extern void SIMWS_receive(uint8_t num, const char* text);
+extern void SIMWS_receiveBin(uint8_t num, const uint8_t* data, size_t len);
+extern void SIMWS_disconnect(uint8_t num);
+
+#endif
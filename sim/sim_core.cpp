@@ -0,0 +1,395 @@
+/*
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *
+ *  Host stand-in for the ESP8266 core: virtual clock, GPIO, flash, Serial and the ESP object.
+ *  The virtual clock is host monotonic time plus everything delay() skipped, so the firmware
+ *  sees real execution times but never waits. Scheduled actions (button edges, network events)
+ *  run from delay(), which is where interrupts and SDK callbacks would land on the device.
+ */
+#include <Arduino.h>
+#include <spi_flash.h>
+#include <SPI.h>
+#include <Ticker.h>
+#include <map>
+#include <vector>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "sim.h"
+
+#define SIM_PINS          (17)
+#define SIM_ACTIONS       (32)
+#define SIM_TICKERS       (4)
+#define SIM_RTC_USER_SIZE (512)      // bytes of RTC user memory, addressed in 4 byte blocks
+
+typedef struct {
+  uint32_t ms;
+  SimAction action;
+  uint32_t arg;
+} ScheduledAction;
+
+HardwareSerial Serial;
+EspClass ESP;
+SPIClass SPI;
+/* Flash layout without a filesystem, as the sketch is built: it ends where EEPROM starts. */
+extern "C" {
+  uint32_t _EEPROM_start = 0;
+  extern uint32_t _FS_start __attribute__((alias("_EEPROM_start")));
+  extern uint32_t _FS_end __attribute__((alias("_EEPROM_start")));
+}
+
+static bool realtime = false;
+static uint64_t hostStartUs = 0;
+static uint64_t skippedUs = 0;
+static ScheduledAction actions[SIM_ACTIONS];
+static uint8_t actionCount = 0;
+static uint8_t pinLevel[SIM_PINS];
+static void (*pinIsr[SIM_PINS])(void);
+static uint16_t pinDuty[SIM_PINS];
+static uint32_t pwmRange = 255;
+static Ticker* tickers[SIM_TICKERS];
+static std::map<uint32_t, std::vector<uint8_t>> flashSectors;
+static uint64_t randomState = 1;
+static uint16_t portOffset = 0;
+static uint8_t rtcUserMemory[SIM_RTC_USER_SIZE];   // zero, as after a power cycle
+
+static uint64_t hostUs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint64_t virtualUs(void)
+{
+  if(hostStartUs == 0){
+    hostStartUs = hostUs();
+  }
+  return hostUs() - hostStartUs + skippedUs;
+}
+
+// ---- Time ----
+uint32_t millis(void)
+{
+  return (uint32_t)(virtualUs() / 1000);
+}
+
+uint32_t micros(void)
+{
+  return (uint32_t)virtualUs();
+}
+
+void SIM_setRealtime(bool enable)
+{
+  realtime = enable;
+}
+
+bool SIM_at(uint32_t ms, SimAction action, uint32_t arg)
+{
+  if(actionCount >= SIM_ACTIONS){
+    return false;
+  }
+  actions[actionCount].ms = ms;
+  actions[actionCount].action = action;
+  actions[actionCount].arg = arg;
+  actionCount++;
+  return true;
+}
+
+void SIM_runDue(void)
+{
+  uint32_t now = millis();
+  uint8_t i = 0;
+
+  while(i < actionCount){
+    if((int32_t)(now - actions[i].ms) >= 0){
+      ScheduledAction a = actions[i];
+      actions[i] = actions[--actionCount];
+      a.action(a.arg);
+    }else{
+      i++;
+    }
+  }
+}
+
+/* Returns early at the next scheduled action, the scheduler simply looks again. */
+void delay(uint32_t ms)
+{
+  uint32_t now = millis();
+  uint32_t until = now + ms;
+
+  for(uint8_t i = 0; i < actionCount; i++){
+    if((int32_t)(actions[i].ms - now) <= 0){
+      until = now;
+    }else if((int32_t)(actions[i].ms - until) < 0){
+      until = actions[i].ms;
+    }
+  }
+  if(realtime){
+    usleep((until - now) * 1000);
+  }else{
+    skippedUs += (uint64_t)(until - now) * 1000;
+  }
+  SIM_runDue();
+}
+
+void yield(void)
+{
+  SIM_runDue();
+}
+
+// ---- Sockets ----
+void SIM_setPortOffset(uint16_t offset)
+{
+  portOffset = offset;
+}
+
+/* Failing to listen is not fatal, the server then only takes requests handed in directly. */
+int SIM_listen(uint16_t port)
+{
+  if(portOffset == 0){
+    return -1;
+  }
+  uint16_t hostPort = port + portOffset;
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  if(fd < 0){
+    return -1;
+  }
+  int on = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(hostPort);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if((bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) || (listen(fd, 4) < 0)){
+    fprintf(stderr, "sim: cannot listen on 127.0.0.1:%u for port %u\n", hostPort, port);
+    close(fd);
+    return -1;
+  }
+  printf("sim: port %u is 127.0.0.1:%u\n", port, hostPort);
+  return fd;
+}
+
+// ---- Random ----
+/* Deterministic, so two runs draw the same frames. */
+long random(long howBig)
+{
+  if(howBig <= 0){
+    return 0;
+  }
+  randomState = randomState * 6364136223846793005ULL + 1442695040888963407ULL;
+  return (long)((randomState >> 33) % (uint64_t)howBig);
+}
+
+long random(long howSmall, long howBig)
+{
+  if(howSmall >= howBig){
+    return howSmall;
+  }
+  return howSmall + random(howBig - howSmall);
+}
+
+void randomSeed(unsigned long seed)
+{
+  randomState = seed;
+}
+
+// ---- GPIO ----
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  if((pin < SIM_PINS) && (mode == INPUT_PULLUP)){
+    pinLevel[pin] = HIGH;
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  if(pin < SIM_PINS){
+    pinLevel[pin] = value ? HIGH : LOW;
+  }
+}
+
+int digitalRead(uint8_t pin)
+{
+  return (pin < SIM_PINS) ? pinLevel[pin] : LOW;
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode)
+{
+  if(pin < SIM_PINS){
+    pinIsr[pin] = isr;
+  }
+}
+
+/* The pin reads high while the duty is above zero. */
+void analogWrite(uint8_t pin, int value)
+{
+  if(pin < SIM_PINS){
+    pinDuty[pin] = constrain(value, 0, (int)pwmRange);
+    pinLevel[pin] = (pinDuty[pin] > 0) ? HIGH : LOW;
+  }
+}
+
+void analogWriteRange(uint32_t range)
+{
+  pwmRange = range;
+}
+
+void analogWriteFreq(uint32_t freq)
+{
+}
+
+uint16_t SIM_getDuty(uint8_t pin)
+{
+  return (pin < SIM_PINS) ? pinDuty[pin] : 0;
+}
+
+// ---- Ticker ----
+/* A ticker is a scheduled action that schedules itself again. The argument carries the
+ * slot and the ticker's generation, so an action left over from before a detach is ignored. */
+static void tickerFire(uint32_t arg)
+{
+  Ticker* t = tickers[arg & 0xFF];
+  if((t == nullptr) || (t->generation != (arg >> 8))){
+    return;
+  }
+  SIM_at(millis() + t->periodMs, tickerFire, arg);
+  t->callback();
+}
+
+void Ticker::attach_ms(uint32_t ms, void (*cb)(void))
+{
+  if(slot == 0xFF){
+    for(uint8_t i = 0; i < SIM_TICKERS; i++){
+      if(tickers[i] == nullptr){
+        tickers[i] = this;
+        slot = i;
+        break;
+      }
+    }
+    if(slot == 0xFF){
+      return;
+    }
+  }
+  generation++;
+  periodMs = ms;
+  callback = cb;
+  attached = true;
+  SIM_at(millis() + ms, tickerFire, slot | (generation << 8));
+}
+
+void Ticker::detach(void)
+{
+  generation++;
+  attached = false;
+}
+
+void SIM_setPin(uint8_t pin, uint8_t level)
+{
+  if((pin >= SIM_PINS) || (pinLevel[pin] == level)){
+    return;
+  }
+  pinLevel[pin] = level;
+  if(pinIsr[pin] != nullptr){
+    pinIsr[pin]();
+  }
+}
+
+uint8_t SIM_getPin(uint8_t pin)
+{
+  return (pin < SIM_PINS) ? pinLevel[pin] : LOW;
+}
+
+// ---- Serial ----
+size_t HardwareSerial::printf(const char* fmt, ...)
+{
+  va_list args;
+  va_start(args, fmt);
+  int len = vprintf(fmt, args);
+  va_end(args);
+  return (len > 0) ? len : 0;
+}
+
+// ---- ESP ----
+/* The host heap says nothing about the device one, these are typical values of a running lamp. */
+uint32_t EspClass::getFreeHeap(void)
+{
+  return 40000;
+}
+
+uint8_t EspClass::getHeapFragmentation(void)
+{
+  return 0;
+}
+
+uint32_t EspClass::getMaxFreeBlockSize(void)
+{
+  return 40000;
+}
+
+uint32_t EspClass::random(void)
+{
+  return (uint32_t)::random(0x7FFFFFFF);
+}
+
+/* Erased flash reads as 0xFF, writes can only clear bits, like the real part. */
+static std::vector<uint8_t>& flashSector(uint32_t sector)
+{
+  std::vector<uint8_t>& data = flashSectors[sector];
+  if(data.empty()){
+    data.assign(SPI_FLASH_SEC_SIZE, 0xFF);
+  }
+  return data;
+}
+
+bool EspClass::flashEraseSector(uint32_t sector)
+{
+  flashSector(sector).assign(SPI_FLASH_SEC_SIZE, 0xFF);
+  return true;
+}
+
+bool EspClass::flashWrite(uint32_t address, const uint32_t* data, size_t size)
+{
+  const uint8_t* src = (const uint8_t*)data;
+  if((address & 3) || (size & 3)){
+    return false;
+  }
+  for(size_t i = 0; i < size; i++){
+    flashSector((address + i) / SPI_FLASH_SEC_SIZE)[(address + i) % SPI_FLASH_SEC_SIZE] &= src[i];
+  }
+  return true;
+}
+
+bool EspClass::flashRead(uint32_t address, uint32_t* data, size_t size)
+{
+  uint8_t* dst = (uint8_t*)data;
+  if(address & 3){
+    return false;
+  }
+  for(size_t i = 0; i < size; i++){
+    dst[i] = flashSector((address + i) / SPI_FLASH_SEC_SIZE)[(address + i) % SPI_FLASH_SEC_SIZE];
+  }
+  return true;
+}
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size)
+{
+  if((offset * 4 + size) > sizeof(rtcUserMemory)){
+    return false;
+  }
+  memcpy(data, rtcUserMemory + offset * 4, size);
+  return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size)
+{
+  if((offset * 4 + size) > sizeof(rtcUserMemory)){
+    return false;
+  }
+  memcpy(rtcUserMemory + offset * 4, data, size);
+  return true;
+}
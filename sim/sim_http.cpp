@@ -0,0 +1,420 @@
+/*
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *
+ *  ESP8266WebServer stand-in. A request is read whole into one fixed buffer and parsed in place,
+ *  arguments and collected headers point into it, so serving a page allocates nothing beyond
+ *  what the handler itself does. The socket is optional, SIMHTTP_request() feeds the same path.
+ */
+#include <ESP8266WebServer.h>
+#include <poll.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "sim.h"
+
+#define REQUEST_WAIT_MS     (1000)      // a client that sends nothing for this long is dropped
+
+static ESP8266WebServer* activeServer = nullptr;
+
+static const char* statusText(int code)
+{
+  switch(code){
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    default:  return "Internal Server Error";
+  }
+}
+
+static int hexValue(char c)
+{
+  if((c >= '0') && (c <= '9')) return c - '0';
+  if((c >= 'a') && (c <= 'f')) return c - 'a' + 10;
+  if((c >= 'A') && (c <= 'F')) return c - 'A' + 10;
+  return -1;
+}
+
+/* In place, the result is never longer than the input. */
+static void urlDecode(char* s)
+{
+  char* out = s;
+  for(; *s; s++){
+    if((*s == '%') && (hexValue(s[1]) >= 0) && (hexValue(s[2]) >= 0)){
+      *out++ = (char)((hexValue(s[1]) << 4) | hexValue(s[2]));
+      s += 2;
+    }else{
+      *out++ = (*s == '+') ? ' ' : *s;
+    }
+  }
+  *out = 0;
+}
+
+/* True once the headers and as much body as Content-Length announces are in. */
+static bool requestComplete(const char* request, size_t length)
+{
+  const char* end = strstr(request, "\r\n\r\n");
+  if(end == nullptr){
+    return false;
+  }
+  size_t need = end + 4 - request;
+  const char* cl = strcasestr(request, "\r\nContent-Length:");
+  if((cl != nullptr) && (cl < end)){
+    need += strtoul(cl + 17, nullptr, 10);
+  }
+  return length >= need;
+}
+
+ESP8266WebServer::ESP8266WebServer(int port)
+  : port_(port), listenFd_(-1), clientFd_(-1), sink_(nullptr), collectCount_(0),
+    method_(HTTP_GET), uri_(""), argCount_(0), headerCount_(0),
+    extraLen_(0), contentLength_(CONTENT_LENGTH_NOT_SET), chunked_(false)
+{
+  request_[0] = 0;
+  extraHeaders_[0] = 0;
+}
+
+ESP8266WebServer::~ESP8266WebServer()
+{
+  close();
+  if(activeServer == this){
+    activeServer = nullptr;
+  }
+}
+
+void ESP8266WebServer::begin(void)
+{
+  activeServer = this;
+  if(listenFd_ < 0){
+    listenFd_ = SIM_listen(port_);
+  }
+}
+
+void ESP8266WebServer::close(void)
+{
+  if(listenFd_ >= 0){
+    ::close(listenFd_);
+    listenFd_ = -1;
+  }
+}
+
+void ESP8266WebServer::handleClient(void)
+{
+  if(listenFd_ < 0){
+    return;
+  }
+  int fd = accept(listenFd_, nullptr, nullptr);
+  if(fd < 0){
+    return;
+  }
+
+  size_t length = 0;
+  while(length < HTTP_REQUEST_SIZE){
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    if(poll(&pfd, 1, REQUEST_WAIT_MS) <= 0){
+      break;
+    }
+    ssize_t n = recv(fd, request_ + length, HTTP_REQUEST_SIZE - length, 0);
+    if(n <= 0){
+      break;
+    }
+    length += n;
+    request_[length] = 0;
+    if(requestComplete(request_, length)){
+      break;
+    }
+  }
+
+  clientFd_ = fd;
+  sink_ = nullptr;
+  if(parse(length)){
+    dispatch();
+  }
+  ::close(fd);
+  clientFd_ = -1;
+}
+
+void ESP8266WebServer::serve(const char* request, size_t length, Sink sink)
+{
+  length = std::min(length, (size_t)HTTP_REQUEST_SIZE);
+  memcpy(request_, request, length);
+  clientFd_ = -1;
+  sink_ = sink;
+  if(parse(length)){
+    dispatch();
+  }
+  sink_ = nullptr;
+}
+
+void ESP8266WebServer::on(const char* uri, THandlerFunction handler)
+{
+  on(uri, HTTP_ANY, handler);
+}
+
+void ESP8266WebServer::on(const char* uri, HTTPMethod method, THandlerFunction handler)
+{
+  routes_.push_back(Route{ uri, method, handler });
+}
+
+void ESP8266WebServer::onNotFound(THandlerFunction handler)
+{
+  notFound_ = handler;
+}
+
+void ESP8266WebServer::collectHeaders(const char* headerKeys[], size_t count)
+{
+  collectCount_ = std::min(count, (size_t)HTTP_MAX_HEADERS);
+  memcpy(collect_, headerKeys, collectCount_ * sizeof(collect_[0]));
+}
+
+String ESP8266WebServer::arg(const char* name)
+{
+  for(size_t i = 0; i < argCount_; i++){
+    if(strcmp(args_[i].key, name) == 0){
+      return String(args_[i].value);
+    }
+  }
+  return String();
+}
+
+bool ESP8266WebServer::hasArg(const char* name)
+{
+  for(size_t i = 0; i < argCount_; i++){
+    if(strcmp(args_[i].key, name) == 0){
+      return true;
+    }
+  }
+  return false;
+}
+
+String ESP8266WebServer::header(const char* name)
+{
+  for(size_t i = 0; i < headerCount_; i++){
+    if(strcasecmp(headers_[i].key, name) == 0){
+      return String(headers_[i].value);
+    }
+  }
+  return String();
+}
+
+/* Splits key=value&key=value in place. */
+static size_t parseArgs(char* s, const char** keys, const char** values, size_t count, size_t max)
+{
+  while((s != nullptr) && (*s != 0) && (count < max)){
+    char* next = strchr(s, '&');
+    if(next != nullptr){
+      *next++ = 0;
+    }
+    char* eq = strchr(s, '=');
+    if(eq != nullptr){
+      *eq++ = 0;
+    }
+    urlDecode(s);
+    if(eq != nullptr){
+      urlDecode(eq);
+    }
+    keys[count] = s;
+    values[count] = (eq != nullptr) ? eq : "";
+    count++;
+    s = next;
+  }
+  return count;
+}
+
+bool ESP8266WebServer::parse(size_t length)
+{
+  request_[length] = 0;
+  argCount_ = 0;
+  headerCount_ = 0;
+
+  char* line = request_;
+  char* eol = strstr(line, "\r\n");
+  if(eol == nullptr){
+    return false;
+  }
+  *eol = 0;
+
+  char* uri = strchr(line, ' ');
+  if(uri == nullptr){
+    return false;
+  }
+  *uri++ = 0;
+  char* version = strchr(uri, ' ');
+  if(version != nullptr){
+    *version = 0;
+  }
+
+  static const struct { const char* name; HTTPMethod method; } methods[] = {
+    { "GET", HTTP_GET }, { "HEAD", HTTP_HEAD }, { "POST", HTTP_POST }, { "PUT", HTTP_PUT },
+    { "PATCH", HTTP_PATCH }, { "DELETE", HTTP_DELETE }, { "OPTIONS", HTTP_OPTIONS },
+  };
+  method_ = HTTP_ANY;
+  for(const auto& m : methods){
+    if(strcmp(line, m.name) == 0){
+      method_ = m.method;
+    }
+  }
+  if(method_ == HTTP_ANY){
+    return false;
+  }
+
+  const char* keys[HTTP_MAX_ARGS];
+  const char* values[HTTP_MAX_ARGS];
+  char* query = strchr(uri, '?');
+  if(query != nullptr){
+    *query++ = 0;
+  }
+  urlDecode(uri);
+  uri_ = uri;
+  argCount_ = parseArgs(query, keys, values, 0, HTTP_MAX_ARGS);
+
+  char* body = nullptr;
+  for(line = eol + 2; (eol = strstr(line, "\r\n")) != nullptr; line = eol + 2){
+    *eol = 0;
+    if(*line == 0){
+      body = eol + 2;
+      break;
+    }
+    char* colon = strchr(line, ':');
+    if(colon == nullptr){
+      continue;
+    }
+    *colon++ = 0;
+    while(*colon == ' '){
+      colon++;
+    }
+    for(size_t i = 0; (i < collectCount_) && (headerCount_ < HTTP_MAX_HEADERS); i++){
+      if(strcasecmp(line, collect_[i]) == 0){
+        headers_[headerCount_].key = collect_[i];
+        headers_[headerCount_].value = colon;
+        headerCount_++;
+      }
+    }
+  }
+  if(method_ == HTTP_POST){
+    argCount_ = parseArgs(body, keys, values, argCount_, HTTP_MAX_ARGS);
+  }
+
+  for(size_t i = 0; i < argCount_; i++){
+    args_[i].key = keys[i];
+    args_[i].value = values[i];
+  }
+  return true;
+}
+
+void ESP8266WebServer::dispatch(void)
+{
+  extraLen_ = 0;
+  extraHeaders_[0] = 0;
+  contentLength_ = CONTENT_LENGTH_NOT_SET;
+  chunked_ = false;
+
+  for(const Route& route : routes_){
+    if((strcmp(route.uri, uri_) == 0) && ((route.method == HTTP_ANY) || (route.method == method_))){
+      route.handler();
+      return;
+    }
+  }
+  if(notFound_){
+    notFound_();
+  }else{
+    send(404, "text/plain", "Not found");
+  }
+}
+
+void ESP8266WebServer::write(const char* data, size_t length)
+{
+  if(sink_ != nullptr){
+    sink_(data, length);
+    return;
+  }
+  while((clientFd_ >= 0) && (length > 0)){
+    ssize_t n = ::send(clientFd_, data, length, MSG_NOSIGNAL);
+    if(n <= 0){
+      return;
+    }
+    data += n;
+    length -= n;
+  }
+}
+
+void ESP8266WebServer::sendHeader(const char* name, const char* value, bool first)
+{
+  int n = snprintf(extraHeaders_ + extraLen_, sizeof(extraHeaders_) - extraLen_, "%s: %s\r\n", name, value);
+  if((n > 0) && (extraLen_ + n < sizeof(extraHeaders_))){
+    extraLen_ += n;
+  }else{
+    extraHeaders_[extraLen_] = 0;
+  }
+}
+
+void ESP8266WebServer::sendHead(int code, const char* contentType, size_t length)
+{
+  char head[HTTP_HEADER_BUF_SIZE + 192];
+  size_t len = snprintf(head, sizeof(head), "HTTP/1.1 %d %s\r\n", code, statusText(code));
+  if(contentType != nullptr){
+    len += snprintf(head + len, sizeof(head) - len, "Content-Type: %s\r\n", contentType);
+  }
+  chunked_ = (length == CONTENT_LENGTH_UNKNOWN);
+  if(chunked_){
+    len += snprintf(head + len, sizeof(head) - len, "Transfer-Encoding: chunked\r\n");
+  }else{
+    len += snprintf(head + len, sizeof(head) - len, "Content-Length: %u\r\n", (unsigned)length);
+  }
+  snprintf(head + len, sizeof(head) - len, "%sConnection: close\r\n\r\n", extraHeaders_);
+  write(head, strlen(head));
+
+  contentLength_ = CONTENT_LENGTH_NOT_SET;
+  extraLen_ = 0;
+  extraHeaders_[0] = 0;
+}
+
+void ESP8266WebServer::send(int code, const char* contentType, const char* content)
+{
+  if(contentLength_ == CONTENT_LENGTH_UNKNOWN){
+    sendHead(code, contentType, CONTENT_LENGTH_UNKNOWN);
+    if(*content != 0){
+      sendContent(content);
+    }
+    return;
+  }
+  size_t length = strlen(content);
+  sendHead(code, contentType, length);
+  write(content, length);
+}
+
+void ESP8266WebServer::send_P(int code, PGM_P contentType, PGM_P content, size_t length)
+{
+  sendHead(code, contentType, length);
+  write(content, length);
+}
+
+/* An empty chunk ends a chunked response. */
+void ESP8266WebServer::sendContent(const char* content, size_t length)
+{
+  if(!chunked_){
+    write(content, length);
+    return;
+  }
+  char size[12];
+  if(length == 0){
+    write("0\r\n\r\n", 5);
+    chunked_ = false;
+    return;
+  }
+  write(size, snprintf(size, sizeof(size), "%X\r\n", (unsigned)length));
+  write(content, length);
+  write("\r\n", 2);
+}
+
+bool SIMHTTP_request(const char* request, SimSink sink)
+{
+  if(activeServer == nullptr){
+    return false;
+  }
+  activeServer->serve(request, strlen(request), sink);
+  return true;
+}
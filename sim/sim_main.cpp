@@ -0,0 +1,168 @@
+/*
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *
+ *  Host simulator main.
+ *  Runs the unmodified sketch, setup() once and loop() until the virtual run time is over,
+ *  feeds it scripted button presses, and dumps the panel to PPM files on request.
+ *  The log is echoed to stdout as on the serial port, /metrics can be printed at the end.
+ */
+#include <Arduino.h>
+#include "config.h"
+#include "config_store.h"
+#include "logger.h"
+#include "metrics.h"
+#include "wifi_connection.h"
+#include "sim.h"
+
+#define CLICK_MS          (80)
+#define LONG_PRESS_HOLD_MS (1500)
+#define MAX_FRAMES        (16)
+#define PORT_OFFSET       (8000)    // port 80 is served on 8080, 81 on 8081
+
+extern void setup(void);
+extern void loop(void);
+
+static const char* framePaths[MAX_FRAMES];
+static uint8_t frameCount = 0;
+
+static void usage(const char* name)
+{
+  fprintf(stderr,
+    "usage: %s [options]\n"
+    "  --run-ms N          virtual time to run, default 30000\n"
+    "  --utc N             true UTC at start, default 1766000000\n"
+    "  --drift PPM         true time runs this much faster than millis()\n"
+    "  --ntp-latency-ms N  NTP round trip, default 20\n"
+    "  --connect-ms N      the network can be joined from N, default 1500, 0 never\n"
+    "  --no-credentials    start without saved WiFi credentials\n"
+    "  --port-offset N     HTTP and WebSocket ports are 80 + N and 81 + N, default 8000, 0 none\n"
+    "  --click MS          click the button at MS, repeatable\n"
+    "  --long MS           long press the button at MS, repeatable\n"
+    "  --frame MS:PATH     dump the panel at MS, repeatable\n"
+    "  --out PATH          dump the panel at the end\n"
+    "  --metrics           print /metrics at the end\n"
+    "  --realtime          delay() sleeps instead of skipping ahead\n"
+    "  --seed N            animation random seed\n", name);
+}
+
+static void press(uint32_t arg)
+{
+  SIM_setPin(BTN_PIN, LOW);
+}
+
+static void release(uint32_t arg)
+{
+  SIM_setPin(BTN_PIN, HIGH);
+}
+
+static void dumpFrame(uint32_t index)
+{
+  if(!SIMPANEL_writePpm(framePaths[index])){
+    fprintf(stderr, "cannot write %s\n", framePaths[index]);
+  }
+}
+
+static void printMetric(const char* text)
+{
+  fputs(text, stdout);
+}
+
+int main(int argc, char** argv)
+{
+  uint32_t runMs = 30000;
+  const char* outPath = nullptr;
+  bool metrics = false;
+  bool credentials = true;
+
+  SIMNET_setUtc(1766000000);
+  SIM_setPortOffset(PORT_OFFSET);
+
+  for(int i = 1; i < argc; i++){
+    const char* opt = argv[i];
+    const char* val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+    if(strcmp(opt, "--metrics") == 0){
+      metrics = true;
+      continue;
+    }
+    if(strcmp(opt, "--realtime") == 0){
+      SIM_setRealtime(true);
+      continue;
+    }
+    if(strcmp(opt, "--no-credentials") == 0){
+      credentials = false;
+      continue;
+    }
+    if(val == nullptr){
+      usage(argv[0]);
+      return 2;
+    }
+    i++;
+
+    if(strcmp(opt, "--run-ms") == 0){
+      runMs = strtoul(val, nullptr, 0);
+    }else if(strcmp(opt, "--utc") == 0){
+      SIMNET_setUtc(strtoll(val, nullptr, 0));
+    }else if(strcmp(opt, "--drift") == 0){
+      SIMNET_setDriftPpm(strtol(val, nullptr, 0));
+    }else if(strcmp(opt, "--ntp-latency-ms") == 0){
+      SIMNET_setNtpLatencyMs(strtoul(val, nullptr, 0));
+    }else if(strcmp(opt, "--connect-ms") == 0){
+      SIMNET_setConnectMs(strtoul(val, nullptr, 0));
+    }else if(strcmp(opt, "--port-offset") == 0){
+      SIM_setPortOffset(strtoul(val, nullptr, 0));
+    }else if((strcmp(opt, "--click") == 0) || (strcmp(opt, "--long") == 0)){
+      uint32_t at = strtoul(val, nullptr, 0);
+      SIM_at(at, press, 0);
+      SIM_at(at + ((opt[2] == 'c') ? CLICK_MS : LONG_PRESS_HOLD_MS), release, 0);
+    }else if(strcmp(opt, "--frame") == 0){
+      const char* colon = strchr(val, ':');
+      if((colon == nullptr) || (frameCount >= MAX_FRAMES)){
+        usage(argv[0]);
+        return 2;
+      }
+      framePaths[frameCount] = colon + 1;
+      SIM_at(strtoul(val, nullptr, 0), dumpFrame, frameCount);
+      frameCount++;
+    }else if(strcmp(opt, "--out") == 0){
+      outPath = val;
+    }else if(strcmp(opt, "--seed") == 0){
+      randomSeed(strtoul(val, nullptr, 0));
+    }else{
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  struct timespec hostStart, hostEnd;
+  clock_gettime(CLOCK_MONOTONIC, &hostStart);
+
+  /* The sketch finds the simulated network saved, as if set up through the portal before. */
+  if(credentials){
+    CFG_init();
+    WIFIC_setCredentials(SIMNET_SSID, SIMNET_PASS);
+  }
+
+  setup();
+  uint32_t loops = 0;
+  while(millis() < runMs){
+    loop();
+    loops++;
+  }
+  LOG_process();
+
+  clock_gettime(CLOCK_MONOTONIC, &hostEnd);
+  uint32_t hostMs = (hostEnd.tv_sec - hostStart.tv_sec) * 1000 + (hostEnd.tv_nsec - hostStart.tv_nsec) / 1000000;
+  printf("sim: %u ms virtual in %u ms host, %u loops, %llu pixels written\n",
+         millis(), hostMs, loops, (unsigned long long)SIMPANEL_getPixelWrites());
+
+  if(outPath && !SIMPANEL_writePpm(outPath)){
+    fprintf(stderr, "cannot write %s\n", outPath);
+    return 1;
+  }
+  if(metrics){
+    MET_writePrometheus(printMetric);
+  }
+  return 0;
+}
@@ -0,0 +1,418 @@
+/*
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *
+ *  Loopback stand-ins for the network side of the lamp.
+ *  Every DNS name resolves to 127.0.0.1, where an NTP server answers from the simulator's
+ *  true UTC, optionally running at a different rate than millis() to exercise drift correction.
+ *  The WiFi object simulates one access point, SIMNET_SSID, which can be joined from a set virtual
+ *  time on, and a scan that finds it among a few neighbours. Its callbacks run from delay(),
+ *  as SDK events do on the device.
+ */
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+#include "sim.h"
+
+#define NTP_SERVER_PORT       123
+#define NTP_PACKET_BYTES      48
+#define NTP_UNIX_OFFSET       2208988800ULL
+#define STA_CHANNEL           (6)
+#define STA_FAST_JOIN_MS      (300)     // a directed join to a known BSSID with a static IP
+#define STA_FULL_JOIN_MS      (1500)    // channel scan, association and DHCP
+#define STA_DHCP_MS           (200)     // DHCP alone, on a link that is already up
+#define SCAN_MS               (2200)
+#define EVENT_HANDLERS        (6)
+
+enum { STA_EVT_CONNECTED, STA_EVT_GOT_IP, STA_EVT_DISCONNECTED };
+
+typedef struct {
+  const char* ssid;
+  int8_t rssi;
+  uint8_t channel;
+  uint8_t encryption;
+} SimAp;
+
+/* A hidden network, a duplicate SSID and one that needs escaping in JSON. */
+static const SimAp scanAps[] = {
+  { SIMNET_SSID,       -52, STA_CHANNEL, ENC_TYPE_CCMP },
+  { "Neighbour",       -71, 11,          ENC_TYPE_CCMP },
+  { "",                -60, 1,           ENC_TYPE_CCMP },
+  { "Cafe \"Guest\"",  -80, 1,           ENC_TYPE_NONE },
+  { "Neighbour",       -84, 1,           ENC_TYPE_TKIP },
+  { "<Printer>",       -88, 6,           ENC_TYPE_WEP },
+};
+
+#define SCAN_AP_COUNT         (sizeof(scanAps) / sizeof(scanAps[0]))
+
+static const uint8_t staBssid[6] = { 0x02, 0x00, 0x5E, 0x51, 0x4D, 0x01 };
+
+static time_t utcAtZero = 0;
+static int32_t driftPpm = 0;
+static uint32_t ntpLatencyMs = 20;
+static uint32_t connectMs = 1500;
+static bool stationUp = false;
+static uint32_t joinGeneration = 0;     // a new begin() abandons the join in progress
+static IPAddress staticIp;
+static IPAddress staticGateway;
+static IPAddress staticMask;
+static IPAddress staticDns;
+static std::weak_ptr<WiFiEventHandlerOpaque> eventHandlers[EVENT_HANDLERS];
+static bool scanRunning = false;
+static bool scanResults = false;
+static uint32_t scanDoneMs = 0;
+
+ESP8266WiFiClass WiFi;
+
+static uint8_t reply[NTP_PACKET_BYTES];
+static bool replyPending = false;
+static uint32_t replyReadyMs = 0;
+
+void SIMNET_setUtc(time_t utc)
+{
+  utcAtZero = utc;
+}
+
+void SIMNET_setDriftPpm(int32_t ppm)
+{
+  driftPpm = ppm;
+}
+
+void SIMNET_setNtpLatencyMs(uint32_t ms)
+{
+  ntpLatencyMs = ms;
+}
+
+void SIMNET_setConnectMs(uint32_t ms)
+{
+  connectMs = ms;
+}
+
+static uint64_t trueUtcMs(void)
+{
+  uint32_t now = millis();
+  return (uint64_t)utcAtZero * 1000 + now + (int64_t)now * driftPpm / 1000000;
+}
+
+// ---- DNS and UDP ----
+err_t dns_gethostbyname(const char* hostname, ip_addr_t* addr, dns_found_callback found, void* arg)
+{
+  addr->addr = SIM_LOOPBACK_IP;
+  return ERR_OK;
+}
+
+uint8_t WiFiUDP::begin(uint16_t port)
+{
+  return 1;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+  if(!stationUp){
+    return 0;
+  }
+  remote_ = ip;
+  remotePort_ = port;
+  txLen_ = 0;
+  return 1;
+}
+
+size_t WiFiUDP::write(const uint8_t* buf, size_t size)
+{
+  size_t n = std::min(size, sizeof(tx_) - txLen_);
+  memcpy(tx_ + txLen_, buf, n);
+  txLen_ += n;
+  return n;
+}
+
+/* The server side: a stratum 2 reply that echoes the client's transmit time as the origin. */
+int WiFiUDP::endPacket(void)
+{
+  if((remotePort_ != NTP_SERVER_PORT) || (txLen_ != NTP_PACKET_BYTES) || ((uint32_t)remote_ != SIM_LOOPBACK_IP)){
+    return 1;
+  }
+  uint64_t utcMs = trueUtcMs();
+  uint32_t seconds = (uint32_t)(utcMs / 1000 + NTP_UNIX_OFFSET);
+  uint32_t fraction = (uint32_t)(((utcMs % 1000) << 32) / 1000);
+
+  memset(reply, 0, sizeof(reply));
+  reply[0] = 0x24;        // LI 0, version 4, mode 4 (server)
+  reply[1] = 2;
+  memcpy(&reply[24], &tx_[40], 8);
+  for(uint8_t i = 0; i < 4; i++){
+    reply[40 + i] = seconds >> (24 - 8 * i);
+    reply[44 + i] = fraction >> (24 - 8 * i);
+  }
+  replyPending = true;
+  replyReadyMs = millis() + ntpLatencyMs;
+  return 1;
+}
+
+int WiFiUDP::parsePacket(void)
+{
+  return (replyPending && ((int32_t)(millis() - replyReadyMs) >= 0)) ? NTP_PACKET_BYTES : 0;
+}
+
+int WiFiUDP::read(uint8_t* buf, size_t size)
+{
+  if(!replyPending){
+    return 0;
+  }
+  size_t n = std::min(size, sizeof(reply));
+  memcpy(buf, reply, n);
+  replyPending = false;
+  return n;
+}
+
+void WiFiUDP::flush(void)
+{
+  replyPending = false;
+}
+
+IPAddress WiFiUDP::remoteIP(void)
+{
+  return IPAddress((uint32_t)SIM_LOOPBACK_IP);
+}
+
+// ---- Station ----
+static void dispatch(uint8_t event, const void* info)
+{
+  for(uint8_t i = 0; i < EVENT_HANDLERS; i++){
+    std::shared_ptr<WiFiEventHandlerOpaque> handler = eventHandlers[i].lock();
+    if(handler && (handler->event == event)){
+      handler->callback(info);
+    }
+  }
+}
+
+static WiFiEventHandler addHandler(uint8_t event, std::function<void(const void*)> callback)
+{
+  WiFiEventHandler handler = std::make_shared<WiFiEventHandlerOpaque>();
+  handler->event = event;
+  handler->callback = callback;
+  for(uint8_t i = 0; i < EVENT_HANDLERS; i++){
+    if(eventHandlers[i].expired()){
+      eventHandlers[i] = handler;
+      break;
+    }
+  }
+  return handler;
+}
+
+static void dispatchGotIp(void)
+{
+  WiFiEventStationModeGotIP gotIp;
+  gotIp.ip = WiFi.localIP();
+  gotIp.mask = WiFi.subnetMask();
+  gotIp.gw = WiFi.gatewayIP();
+  dispatch(STA_EVT_GOT_IP, &gotIp);
+}
+
+static void stationJoined(uint32_t generation)
+{
+  if(generation != joinGeneration){
+    return;
+  }
+  stationUp = true;
+
+  WiFiEventStationModeConnected connected;
+  connected.ssid = SIMNET_SSID;
+  memcpy(connected.bssid, staBssid, sizeof(connected.bssid));
+  connected.channel = STA_CHANNEL;
+  dispatch(STA_EVT_CONNECTED, &connected);
+  dispatchGotIp();
+}
+
+/* DHCP started after joining with a static address. */
+static void dhcpBound(uint32_t generation)
+{
+  if((generation == joinGeneration) && stationUp){
+    dispatchGotIp();
+  }
+}
+
+static void stationFailed(uint32_t generation)
+{
+  if(generation != joinGeneration){
+    return;
+  }
+  WiFiEventStationModeDisconnected disconnected;
+  memset(disconnected.bssid, 0, sizeof(disconnected.bssid));
+  disconnected.reason = WIFI_DISCONNECT_REASON_NO_AP_FOUND;
+  dispatch(STA_EVT_DISCONNECTED, &disconnected);
+}
+
+bool ESP8266WiFiClass::mode(WiFiMode_t mode)
+{
+  return true;
+}
+
+bool ESP8266WiFiClass::setAutoReconnect(bool autoReconnect)
+{
+  return true;
+}
+
+void ESP8266WiFiClass::persistent(bool persistent)
+{
+}
+
+String ESP8266WiFiClass::macAddress(void)
+{
+  return String("5C:CF:7F:51:4D:01");
+}
+
+bool ESP8266WiFiClass::softAPConfig(IPAddress local, IPAddress gateway, IPAddress subnet)
+{
+  return true;
+}
+
+bool ESP8266WiFiClass::softAP(const char* ssid, const char* pass)
+{
+  return true;
+}
+
+/* A zero address goes back to DHCP, which leases SIM_LOOPBACK_IP a little later if the link is up. */
+bool ESP8266WiFiClass::config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns)
+{
+  if(stationUp && ((uint32_t)staticIp != 0) && ((uint32_t)local == 0)){
+    SIM_at(millis() + STA_DHCP_MS, dhcpBound, joinGeneration);
+  }
+  staticIp = local;
+  staticGateway = gateway;
+  staticMask = subnet;
+  staticDns = dns;
+  return true;
+}
+
+/* Joins SIMNET_SSID no earlier than the connect time. A directed join only works with the right
+ * BSSID and channel, like on the device anything else never completes. A wrong SSID or password
+ * fails the way a missing network does. */
+wl_status_t ESP8266WiFiClass::begin(const char* ssid, const char* pass, int32_t channel, const uint8_t* bssid)
+{
+  stationUp = false;
+  joinGeneration++;
+
+  uint32_t now = millis();
+  bool directed = (bssid != nullptr);
+  if((strcmp(ssid, SIMNET_SSID) != 0) || (pass == nullptr) || (strcmp(pass, SIMNET_PASS) != 0)){
+    SIM_at(now + STA_FULL_JOIN_MS, stationFailed, joinGeneration);
+  }else if(connectMs == 0){
+    return WL_DISCONNECTED;
+  }else if(!directed || ((channel == STA_CHANNEL) && (memcmp(bssid, staBssid, sizeof(staBssid)) == 0))){
+    uint32_t at = now + (directed ? STA_FAST_JOIN_MS : STA_FULL_JOIN_MS);
+    SIM_at(((int32_t)(connectMs - at) > 0) ? connectMs : at, stationJoined, joinGeneration);
+  }
+  return WL_DISCONNECTED;
+}
+
+wl_status_t ESP8266WiFiClass::status(void)
+{
+  return stationUp ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+uint8_t* ESP8266WiFiClass::BSSID(void)
+{
+  static uint8_t bssid[6];
+  memcpy(bssid, staBssid, sizeof(bssid));
+  return bssid;
+}
+
+int32_t ESP8266WiFiClass::channel(void)
+{
+  return STA_CHANNEL;
+}
+
+/* DHCP hands out the loopback address, so the servers are reachable where the station says. */
+IPAddress ESP8266WiFiClass::localIP(void)
+{
+  if(!stationUp){
+    return IPAddress();
+  }
+  return ((uint32_t)staticIp != 0) ? staticIp : IPAddress((uint32_t)SIM_LOOPBACK_IP);
+}
+
+IPAddress ESP8266WiFiClass::gatewayIP(void)
+{
+  return ((uint32_t)staticIp != 0) ? staticGateway : IPAddress((uint32_t)SIM_LOOPBACK_IP);
+}
+
+IPAddress ESP8266WiFiClass::subnetMask(void)
+{
+  return ((uint32_t)staticIp != 0) ? staticMask : IPAddress(255, 0, 0, 0);
+}
+
+IPAddress ESP8266WiFiClass::dnsIP(uint8_t dnsNo)
+{
+  return ((uint32_t)staticIp != 0) ? staticDns : IPAddress((uint32_t)SIM_LOOPBACK_IP);
+}
+
+WiFiEventHandler ESP8266WiFiClass::onStationModeConnected(std::function<void(const WiFiEventStationModeConnected&)> callback)
+{
+  return addHandler(STA_EVT_CONNECTED, [callback](const void* info){
+    callback(*(const WiFiEventStationModeConnected*)info);
+  });
+}
+
+WiFiEventHandler ESP8266WiFiClass::onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP&)> callback)
+{
+  return addHandler(STA_EVT_GOT_IP, [callback](const void* info){
+    callback(*(const WiFiEventStationModeGotIP*)info);
+  });
+}
+
+WiFiEventHandler ESP8266WiFiClass::onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected&)> callback)
+{
+  return addHandler(STA_EVT_DISCONNECTED, [callback](const void* info){
+    callback(*(const WiFiEventStationModeDisconnected*)info);
+  });
+}
+
+// ---- Scan ----
+int8_t ESP8266WiFiClass::scanNetworks(bool async)
+{
+  scanResults = false;
+  scanRunning = true;
+  scanDoneMs = millis() + SCAN_MS;
+  if(!async){
+    delay(SCAN_MS);
+    return scanComplete();
+  }
+  return WIFI_SCAN_RUNNING;
+}
+
+int8_t ESP8266WiFiClass::scanComplete(void)
+{
+  if(scanRunning && ((int32_t)(millis() - scanDoneMs) >= 0)){
+    scanRunning = false;
+    scanResults = true;
+  }
+  if(scanRunning){
+    return WIFI_SCAN_RUNNING;
+  }
+  return scanResults ? SCAN_AP_COUNT : WIFI_SCAN_FAILED;
+}
+
+void ESP8266WiFiClass::scanDelete(void)
+{
+  scanResults = false;
+}
+
+String ESP8266WiFiClass::SSID(uint8_t i)
+{
+  return String((scanResults && (i < SCAN_AP_COUNT)) ? scanAps[i].ssid : "");
+}
+
+int32_t ESP8266WiFiClass::RSSI(uint8_t i)
+{
+  return (scanResults && (i < SCAN_AP_COUNT)) ? scanAps[i].rssi : 0;
+}
+
+int32_t ESP8266WiFiClass::channel(uint8_t i)
+{
+  return (scanResults && (i < SCAN_AP_COUNT)) ? scanAps[i].channel : 0;
+}
+
+uint8_t ESP8266WiFiClass::encryptionType(uint8_t i)
+{
+  return (scanResults && (i < SCAN_AP_COUNT)) ? scanAps[i].encryption : 0;
+}
@@ -0,0 +1,89 @@
+/*
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *
+ *  Simulated ST7789 panel: a 240x240 RGB565 framebuffer written through an address window,
+ *  the way the controller RAM is. Both display backends end up here, the Adafruit_ST7789
+ *  stand-in and the raw FIFO transport in lcd_bus_sim.cpp.
+ */
+#include <Arduino.h>
+#include "sim.h"
+
+static uint16_t frame[SIM_PANEL_H][SIM_PANEL_W];
+static int16_t winX = 0;
+static int16_t winY = 0;
+static int16_t winW = SIM_PANEL_W;
+static int16_t winH = SIM_PANEL_H;
+static uint32_t winPos = 0;       /* next pixel inside the window */
+static uint64_t pixelWrites = 0;
+
+static void writePixel(uint16_t color)
+{
+  int16_t x = winX + winPos % winW;
+  int16_t y = winY + winPos / winW;
+
+  if((x >= 0) && (x < SIM_PANEL_W) && (y >= 0) && (y < SIM_PANEL_H)){
+    frame[y][x] = color;
+  }
+  winPos = (winPos + 1) % ((uint32_t)winW * winH);
+  pixelWrites++;
+}
+
+void SIMPANEL_setWindow(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+  winX = x;
+  winY = y;
+  winW = (w > 0) ? w : 1;
+  winH = (h > 0) ? h : 1;
+  winPos = 0;
+}
+
+void SIMPANEL_push(const uint16_t* pixels, uint32_t count)
+{
+  while(count--){
+    writePixel(*pixels++);
+  }
+}
+
+void SIMPANEL_fill(uint16_t color, uint32_t count)
+{
+  while(count--){
+    writePixel(color);
+  }
+}
+
+void SIMPANEL_fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+  if((w <= 0) || (h <= 0)){
+    return;
+  }
+  SIMPANEL_setWindow(x, y, w, h);
+  SIMPANEL_fill(color, (uint32_t)w * h);
+}
+
+uint64_t SIMPANEL_getPixelWrites(void)
+{
+  return pixelWrites;
+}
+
+/* Binary PPM, RGB565 expanded to 8 bits per channel. */
+bool SIMPANEL_writePpm(const char* path)
+{
+  FILE* f = fopen(path, "wb");
+  if(f == nullptr){
+    return false;
+  }
+  fprintf(f, "P6\n%d %d\n255\n", SIM_PANEL_W, SIM_PANEL_H);
+  for(int16_t y = 0; y < SIM_PANEL_H; y++){
+    for(int16_t x = 0; x < SIM_PANEL_W; x++){
+      uint16_t c = frame[y][x];
+      uint8_t rgb[3] = {
+        (uint8_t)(((c >> 11) & 0x1F) * 255 / 31),
+        (uint8_t)(((c >> 5) & 0x3F) * 255 / 63),
+        (uint8_t)((c & 0x1F) * 255 / 31)
+      };
+      fwrite(rgb, 1, sizeof(rgb), f);
+    }
+  }
+  return fclose(f) == 0;
+}
@@ -0,0 +1,477 @@
+/*
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *
+ *  WebSocketsServer stand-in. Each client has one fixed receive buffer, frames are unmasked there
+ *  and copied out NUL terminated, as the library hands them over. Clients added through
+ *  SIMWS_connect() have no socket, their outgoing payloads go to a sink instead.
+ */
+#include <WebSocketsServer.h>
+#include <errno.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "sim.h"
+
+#define WS_GUID             "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WS_OP_CONTINUATION  (0x0)
+#define WS_OP_TEXT          (0x1)
+#define WS_OP_BINARY        (0x2)
+#define WS_OP_CLOSE         (0x8)
+#define WS_OP_PING          (0x9)
+#define WS_OP_PONG          (0xA)
+
+static WebSocketsServer* activeServer = nullptr;
+
+// ---- Handshake key ----
+static uint32_t rol(uint32_t v, uint8_t n)
+{
+  return (v << n) | (v >> (32 - n));
+}
+
+static void sha1(const uint8_t* data, size_t len, uint8_t digest[20])
+{
+  uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+  uint64_t bits = (uint64_t)len * 8;
+  size_t total = ((len + 8) / 64 + 1) * 64;
+
+  for(size_t block = 0; block < total; block += 64){
+    uint32_t w[80];
+    for(uint8_t i = 0; i < 64; i++){
+      size_t pos = block + i;
+      uint8_t b;
+      if(pos < len){
+        b = data[pos];
+      }else if(pos == len){
+        b = 0x80;
+      }else if(pos >= total - 8){
+        b = (uint8_t)(bits >> (8 * (total - 1 - pos)));
+      }else{
+        b = 0;
+      }
+      if((i & 3) == 0){
+        w[i / 4] = 0;
+      }
+      w[i / 4] |= (uint32_t)b << (24 - 8 * (i & 3));
+    }
+    for(uint8_t i = 16; i < 80; i++){
+      w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for(uint8_t i = 0; i < 80; i++){
+      uint32_t f, k;
+      if(i < 20){
+        f = (b & c) | (~b & d);
+        k = 0x5A827999;
+      }else if(i < 40){
+        f = b ^ c ^ d;
+        k = 0x6ED9EBA1;
+      }else if(i < 60){
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8F1BBCDC;
+      }else{
+        f = b ^ c ^ d;
+        k = 0xCA62C1D6;
+      }
+      uint32_t t = rol(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = rol(b, 30);
+      b = a;
+      a = t;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+  }
+
+  for(uint8_t i = 0; i < 20; i++){
+    digest[i] = h[i / 4] >> (24 - 8 * (i & 3));
+  }
+}
+
+static size_t base64(const uint8_t* data, size_t len, char* out)
+{
+  static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  size_t n = 0;
+  for(size_t i = 0; i < len; i += 3){
+    uint32_t v = (uint32_t)data[i] << 16;
+    if(i + 1 < len) v |= (uint32_t)data[i + 1] << 8;
+    if(i + 2 < len) v |= data[i + 2];
+    out[n++] = alphabet[(v >> 18) & 0x3F];
+    out[n++] = alphabet[(v >> 12) & 0x3F];
+    out[n++] = (i + 1 < len) ? alphabet[(v >> 6) & 0x3F] : '=';
+    out[n++] = (i + 2 < len) ? alphabet[v & 0x3F] : '=';
+  }
+  out[n] = 0;
+  return n;
+}
+
+// ---- Server ----
+WebSocketsServer::WebSocketsServer(uint16_t port) : port_(port), listenFd_(-1)
+{
+  for(uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++){
+    clients_[i].fd = -1;
+    clients_[i].sink = nullptr;
+    clients_[i].upgraded = false;
+    clients_[i].rxLen = 0;
+  }
+}
+
+WebSocketsServer::~WebSocketsServer()
+{
+  close();
+  if(activeServer == this){
+    activeServer = nullptr;
+  }
+}
+
+void WebSocketsServer::begin(void)
+{
+  activeServer = this;
+  if(listenFd_ < 0){
+    listenFd_ = SIM_listen(port_);
+  }
+}
+
+void WebSocketsServer::close(void)
+{
+  for(uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++){
+    disconnect(i);
+  }
+  if(listenFd_ >= 0){
+    ::close(listenFd_);
+    listenFd_ = -1;
+  }
+}
+
+void WebSocketsServer::loop(void)
+{
+  accept();
+  for(uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++){
+    if(clients_[i].fd >= 0){
+      read(i);
+    }
+  }
+}
+
+uint8_t WebSocketsServer::connectedClients(bool ping)
+{
+  uint8_t count = 0;
+  for(uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++){
+    if(clients_[i].upgraded){
+      count++;
+    }
+  }
+  return count;
+}
+
+/* Without a free slot the connection is closed right away, like the library does. */
+void WebSocketsServer::accept(void)
+{
+  if(listenFd_ < 0){
+    return;
+  }
+  int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK);
+  if(fd < 0){
+    return;
+  }
+  for(uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++){
+    Client* c = &clients_[i];
+    if((c->fd < 0) && (c->sink == nullptr)){
+      c->fd = fd;
+      c->upgraded = false;
+      c->rxLen = 0;
+      return;
+    }
+  }
+  ::close(fd);
+}
+
+void WebSocketsServer::read(uint8_t num)
+{
+  Client* c = &clients_[num];
+  ssize_t n = recv(c->fd, c->rx + c->rxLen, sizeof(c->rx) - c->rxLen, 0);
+  if((n == 0) || ((n < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK))){
+    disconnect(num);
+    return;
+  }
+  if(n > 0){
+    c->rxLen += n;
+  }
+
+  if(!c->upgraded){
+    if(!handshake(num)){
+      return;
+    }
+  }
+  while((c->fd >= 0) && frame(num)){
+  }
+  if((c->fd >= 0) && (c->rxLen == sizeof(c->rx))){
+    disconnect(num);      // a frame larger than the buffer
+  }
+}
+
+/* Returns true once the client is upgraded. */
+bool WebSocketsServer::handshake(uint8_t num)
+{
+  Client* c = &clients_[num];
+  char* req = (char*)c->rx;
+  if(c->rxLen >= WEBSOCKETS_MAX_HEADER_SIZE){
+    disconnect(num);
+    return false;
+  }
+  req[c->rxLen] = 0;
+  char* end = strstr(req, "\r\n\r\n");
+  if(end == nullptr){
+    return false;
+  }
+  *end = 0;
+
+  char* key = strcasestr(req, "\r\nSec-WebSocket-Key:");
+  if(key == nullptr){
+    static const char bad[] = "HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n";
+    writeAll(c->fd, (const uint8_t*)bad, sizeof(bad) - 1);
+    disconnect(num);
+    return false;
+  }
+  key += 20;
+  while(*key == ' '){
+    key++;
+  }
+  char keyGuid[64 + sizeof(WS_GUID)];
+  size_t keyLen = strcspn(key, "\r\n ");
+  keyLen = std::min(keyLen, (size_t)64);
+  memcpy(keyGuid, key, keyLen);
+  strcpy(keyGuid + keyLen, WS_GUID);
+
+  uint8_t digest[20];
+  char accept[32];
+  sha1((const uint8_t*)keyGuid, strlen(keyGuid), digest);
+  base64(digest, sizeof(digest), accept);
+
+  char reply[192];
+  int len = snprintf(reply, sizeof(reply),
+                     "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                     "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+  if(!writeAll(c->fd, (const uint8_t*)reply, len)){
+    disconnect(num);
+    return false;
+  }
+
+  char path[64] = "/";
+  char* space = strchr(req, ' ');
+  if(space != nullptr){
+    size_t pathLen = std::min(strcspn(space + 1, " \r\n"), sizeof(path) - 1);
+    memcpy(path, space + 1, pathLen);
+    path[pathLen] = 0;
+  }
+
+  size_t used = end + 4 - req;
+  c->rxLen -= used;
+  memmove(c->rx, c->rx + used, c->rxLen);
+  c->upgraded = true;
+  if(event_){
+    event_(num, WStype_CONNECTED, (uint8_t*)path, strlen(path));
+  }
+  return true;
+}
+
+/* Handles one complete frame from the buffer. Returns false if there is none yet. */
+bool WebSocketsServer::frame(uint8_t num)
+{
+  Client* c = &clients_[num];
+  if(c->rxLen < 2){
+    return false;
+  }
+  uint8_t opcode = c->rx[0] & 0x0F;
+  bool masked = (c->rx[1] & 0x80) != 0;
+  uint64_t length = c->rx[1] & 0x7F;
+  size_t header = 2;
+  if(length == 126){
+    if(c->rxLen < 4){
+      return false;
+    }
+    length = ((uint16_t)c->rx[2] << 8) | c->rx[3];
+    header = 4;
+  }else if(length == 127){
+    if(c->rxLen < 10){
+      return false;
+    }
+    length = 0;
+    for(uint8_t i = 0; i < 8; i++){
+      length = (length << 8) | c->rx[2 + i];
+    }
+    header = 10;
+  }
+  if(length > WEBSOCKETS_MAX_DATA_SIZE){
+    disconnect(num);
+    return false;
+  }
+  const uint8_t* mask = c->rx + header;
+  if(masked){
+    header += 4;
+  }
+  if(c->rxLen < header + length){
+    return false;
+  }
+
+  for(size_t i = 0; i < length; i++){
+    message_[i] = c->rx[header + i] ^ (masked ? mask[i & 3] : 0);
+  }
+  message_[length] = 0;
+  c->rxLen -= header + length;
+  memmove(c->rx, c->rx + header + length, c->rxLen);
+
+  switch(opcode){
+    case WS_OP_TEXT:
+      receive(num, WStype_TEXT, message_, length);
+      break;
+    case WS_OP_BINARY:
+      receive(num, WStype_BIN, message_, length);
+      break;
+    case WS_OP_PING:
+      sendFrame(num, WS_OP_PONG, message_, length);
+      break;
+    case WS_OP_CLOSE:
+      sendFrame(num, WS_OP_CLOSE, message_, std::min(length, (uint64_t)2));
+      disconnect(num);
+      return false;
+    default:
+      break;      // pong and continuation frames
+  }
+  return true;
+}
+
+void WebSocketsServer::receive(uint8_t num, WStype_t type, const uint8_t* payload, size_t length)
+{
+  if(payload != message_){
+    length = std::min(length, (size_t)WEBSOCKETS_MAX_DATA_SIZE);
+    memcpy(message_, payload, length);
+    message_[length] = 0;
+  }
+  if(event_){
+    event_(num, type, message_, length);
+  }
+}
+
+bool WebSocketsServer::writeAll(int fd, const uint8_t* data, size_t length)
+{
+  while(length > 0){
+    ssize_t n = ::send(fd, data, length, MSG_NOSIGNAL);
+    if(n < 0){
+      if((errno == EAGAIN) || (errno == EWOULDBLOCK)){
+        continue;
+      }
+      return false;
+    }
+    data += n;
+    length -= n;
+  }
+  return true;
+}
+
+bool WebSocketsServer::sendFrame(uint8_t num, uint8_t opcode, const uint8_t* payload, size_t length)
+{
+  if(num >= WEBSOCKETS_SERVER_CLIENT_MAX){
+    return false;
+  }
+  Client* c = &clients_[num];
+  if(c->sink != nullptr){
+    c->sink((const char*)payload, length);
+    return true;
+  }
+  if((c->fd < 0) || !c->upgraded){
+    return false;
+  }
+
+  uint8_t header[4];
+  size_t headerLen = 2;
+  header[0] = 0x80 | opcode;
+  if(length < 126){
+    header[1] = length;
+  }else{
+    header[1] = 126;
+    header[2] = length >> 8;
+    header[3] = length & 0xFF;
+    headerLen = 4;
+  }
+  if(!writeAll(c->fd, header, headerLen) || !writeAll(c->fd, payload, length)){
+    disconnect(num);
+    return false;
+  }
+  return true;
+}
+
+bool WebSocketsServer::sendTXT(uint8_t num, uint8_t* payload, size_t length)
+{
+  if(length == 0){
+    length = strlen((const char*)payload);
+  }
+  return sendFrame(num, WS_OP_TEXT, payload, length);
+}
+
+bool WebSocketsServer::sendBIN(uint8_t num, uint8_t* payload, size_t length)
+{
+  return sendFrame(num, WS_OP_BINARY, payload, length);
+}
+
+void WebSocketsServer::disconnect(uint8_t num)
+{
+  Client* c = &clients_[num];
+  bool wasConnected = c->upgraded;
+  if(c->fd >= 0){
+    ::close(c->fd);
+  }
+  c->fd = -1;
+  c->sink = nullptr;
+  c->upgraded = false;
+  c->rxLen = 0;
+  if(wasConnected && event_){
+    event_(num, WStype_DISCONNECTED, nullptr, 0);
+  }
+}
+
+int8_t WebSocketsServer::connectSink(Sink sink)
+{
+  for(uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++){
+    Client* c = &clients_[i];
+    if((c->fd < 0) && (c->sink == nullptr)){
+      c->sink = sink;
+      c->upgraded = true;
+      c->rxLen = 0;
+      if(event_){
+        char path[] = "/";
+        event_(i, WStype_CONNECTED, (uint8_t*)path, 1);
+      }
+      return i;
+    }
+  }
+  return -1;
+}
+
+// ---- Host access ----
+int8_t SIMWS_connect(SimSink sink)
+{
+  return (activeServer != nullptr) ? activeServer->connectSink(sink) : -1;
+}
+
+void SIMWS_receive(uint8_t num, const char* text)
+{
+  if(activeServer != nullptr){
+    activeServer->receive(num, WStype_TEXT, (const uint8_t*)text, strlen(text));
+  }
+}
+
+void SIMWS_receiveBin(uint8_t num, const uint8_t* data, size_t len)
+{
+  if(activeServer != nullptr){
+    activeServer->receive(num, WStype_BIN, data, len);
+  }
+}
+
+void SIMWS_disconnect(uint8_t num)
+{
+  if((activeServer != nullptr) && (num < WEBSOCKETS_SERVER_CLIENT_MAX)){
+    activeServer->disconnect(num);
+  }
+}
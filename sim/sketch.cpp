@@ -0,0 +1,3 @@
+/* The sketch, compiled the way the Arduino builder does: as C++ with Arduino.h in front. */
+#include <Arduino.h>
+#include "ESP_LCD_Lamp.ino"
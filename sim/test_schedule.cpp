@@ -0,0 +1,146 @@
+/*
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *
+ *  Runs the light schedule on the virtual clock, with the real WiFi and NTP modules syncing
+ *  against the simulated network, and checks when the rule fires. One case per run, the
+ *  firmware state is global: test_schedule <case>.
+ *  DST cases put a daily rule on the local time that is skipped in spring and repeated in
+ *  autumn, it must fire once at the change and once the next day at the usual time.
+ *  Step cases move the true time before the 4 hour resync, so the sync steps the clock
+ *  back over a rule that already fired, or forward past a rule that has not.
+ */
+#include <Arduino.h>
+#include "config_store.h"
+#include "event_bus.h"
+#include "logger.h"
+#include "NTPSync.h"
+#include "light_schedule.h"
+#include "pinctrl.h"
+#include "timezones.h"
+#include "wifi_connection.h"
+#include "sim.h"
+
+#define RULE_LEVEL        (512)
+#define STEP_MS           (1000)
+#define FIRE_SLACK_S      (2)         // the minute tick is polled, a fire is seen up to a loop later
+#define STEP_AT_MS        ((NTP_SYNC_H * 3600UL - 60) * 1000)   // just before the resync
+#define MAX_FIRES         (4)
+
+typedef struct {
+  const char* name;
+  const char* zone;
+  time_t startUtc;          // true UTC at virtual time 0
+  uint8_t hour;             // the rule, every day
+  uint8_t minute;
+  int32_t stepS;            // true time moves by this at STEP_AT_MS, 0 for none
+  uint32_t runS;
+  uint32_t slackS;          // how late each fire may be seen
+  uint8_t fireCount;
+  time_t fires[MAX_FIRES];
+}Case;
+
+#define HOURS(h)          ((uint32_t)(h) * 3600UL)
+#define STEP_START        (1781510400)      // 2026-06-15 08:00 UTC, 10:00 in Belgrade
+
+static const Case cases[] = {
+  /* 02:30 does not exist on 2026-03-29, the clock goes from 02:00 straight to 03:00 CEST. */
+  { "belgrade_gap",     "Europe/Belgrade",  1774738800, 2, 30, 0, HOURS(28), FIRE_SLACK_S, 2, { 1774746000, 1774830600 } },
+  /* 02:30 comes twice on 2026-10-25, first in CEST. */
+  { "belgrade_overlap", "Europe/Belgrade",  1792879200, 2, 30, 0, HOURS(28), FIRE_SLACK_S, 2, { 1792888200, 1792978200 } },
+  { "new_york_gap",     "America/New_York", 1772946000, 2, 15, 0, HOURS(28), FIRE_SLACK_S, 2, { 1772953200, 1773036900 } },
+  { "new_york_overlap", "America/New_York", 1793505600, 1, 30, 0, HOURS(28), FIRE_SLACK_S, 2, { 1793511000, 1793601000 } },
+  /* Southern hemisphere, summer time starts in October and ends in April. */
+  { "sydney_gap",       "Australia/Sydney", 1791036000, 2, 30, 0, HOURS(28), FIRE_SLACK_S, 2, { 1791043200, 1791127800 } },
+  { "sydney_overlap",   "Australia/Sydney", 1775307600, 2, 30, 0, HOURS(28), FIRE_SLACK_S, 2, { 1775316600, 1775406600 } },
+  /* Fires at 13:59, the resync at 14:00 takes the clock back 3 minutes, it must not fire again. */
+  { "step_back",        "Europe/Belgrade",  STEP_START, 13, 59, -180, HOURS(4) + 900, FIRE_SLACK_S, 1, { STEP_START + HOURS(4) - 60 } },
+  /* The resync takes the clock 3 minutes ahead, past 14:01, which is then late but not too late. */
+  { "step_forward",     "Europe/Belgrade",  STEP_START, 14, 1, 180, HOURS(4) + 900, SCHED_LATE_S, 1, { STEP_START + HOURS(4) + 60 } },
+  /* 15 minutes ahead is past SCHED_LATE_S, the rule is skipped rather than fired that late. */
+  { "step_far",         "Europe/Belgrade",  STEP_START, 14, 1, 900, HOURS(4) + 900, 0, 0, { 0 } },
+};
+
+static const Case* findCase(const char* name)
+{
+  for(const Case& c : cases){
+    if(strcmp(c.name, name) == 0){
+      return &c;
+    }
+  }
+  return nullptr;
+}
+
+static uint32_t run(const Case* c)
+{
+  SIMNET_setUtc(c->startUtc);
+  CFG_init();
+  WIFIC_setCredentials(SIMNET_SSID, SIMNET_PASS);
+  PINCTRL_init();
+  WIFIC_init();
+  TZ_init();
+  NTPS_init();
+  SCHED_init();
+  TZ_set(c->zone);
+
+  CfgSchedRule rule = { SCHED_DAYS_ALL, c->hour, c->minute, RULE_LEVEL, 0 };
+  SCHED_setRule(0, &rule);
+
+  time_t seen[MAX_FIRES];
+  uint8_t seenCount = 0;
+  uint32_t failures = 0;
+  bool stepped = (c->stepS == 0);
+
+  while(millis() < c->runS * 1000UL){
+    EVT_process();
+    WIFIC_process();
+    NTPS_process();
+    LOG_process();
+
+    /* Every fire sets RULE_LEVEL, turning it off again makes the next one visible. */
+    if(PINCTRL_getBrightness() != 0){
+      time_t now = NTPS_getUtcEpoch();
+      if(seenCount < MAX_FIRES){
+        seen[seenCount] = now;
+      }
+      seenCount++;
+      PINCTRL_fade(0, 0, EASE_LINEAR);
+    }
+
+    if(!stepped && (millis() >= STEP_AT_MS)){
+      SIMNET_setUtc(c->startUtc + c->stepS);
+      stepped = true;
+    }
+    delay(STEP_MS);
+  }
+
+  if(seenCount != c->fireCount){
+    printf("FAIL %s: fired %u times, expected %u\n", c->name, seenCount, c->fireCount);
+    failures++;
+  }
+  for(uint8_t i = 0; (i < seenCount) && (i < c->fireCount) && (i < MAX_FIRES); i++){
+    int64_t late = (int64_t)(seen[i] - c->fires[i]);
+    printf("%s: fire %u at %lld, %lld s after %lld\n", c->name, i, (long long)seen[i], (long long)late, (long long)c->fires[i]);
+    if((late < 0) || (late > c->slackS)){
+      printf("FAIL %s: fire %u is %lld s off\n", c->name, i, (long long)late);
+      failures++;
+    }
+  }
+  return failures;
+}
+
+int main(int argc, char** argv)
+{
+  const Case* c = (argc == 2) ? findCase(argv[1]) : nullptr;
+  if(c == nullptr){
+    printf("usage: test_schedule <case>, one of:\n");
+    for(const Case& each : cases){
+      printf("  %s\n", each.name);
+    }
+    return 2;
+  }
+
+  uint32_t failures = run(c);
+  printf("%s: %s\n", c->name, (failures == 0) ? "ok" : "FAILED");
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+/*
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *
+ *  Checks the compiled zone table against the host's tz database.
+ *  For every zone, TZ_toLocal() must give the same offset as localtime_r() with TZ set to
+ *  that zone, sampled through several years and one second before, at and after each
+ *  transition the host finds. Zones missing from /usr/share/zoneinfo are skipped.
+ */
+#include <Arduino.h>
+#include <unistd.h>
+#include "config_store.h"
+#include "timezones.h"
+
+#define FIRST_YEAR        (2020)
+#define LAST_YEAR         (2035)
+#define SAMPLE_S          (6 * 3600L)
+#define ZONEINFO_DIR      "/usr/share/zoneinfo/"
+#define MAX_REPORTED      (20)
+#define SKIP_EXIT_CODE    (77)
+
+static uint32_t checks = 0;
+static uint32_t failures = 0;
+
+static long hostOffset(time_t utc)
+{
+  struct tm tm;
+  localtime_r(&utc, &tm);
+  return tm.tm_gmtoff;
+}
+
+static void check(const char* name, time_t utc)
+{
+  long expected = hostOffset(utc);
+  long actual = (long)(TZ_toLocal(utc) - utc);
+  checks++;
+  if(actual != expected){
+    if(failures < MAX_REPORTED){
+      printf("FAIL %s at %lld: offset %ld s, host says %ld s\n", name, (long long)utc, actual, expected);
+    }
+    failures++;
+  }
+}
+
+/* The first second with the new offset, the host offset changes exactly once in (lo, hi]. */
+static time_t findTransition(time_t lo, time_t hi)
+{
+  long before = hostOffset(lo);
+  while(hi - lo > 1){
+    time_t mid = lo + (hi - lo) / 2;
+    if(hostOffset(mid) == before){
+      lo = mid;
+    }else{
+      hi = mid;
+    }
+  }
+  return hi;
+}
+
+static uint32_t checkZone(const char* name)
+{
+  uint32_t transitions = 0;
+  time_t from = (time_t)(FIRST_YEAR - 1970) * 365 * 86400L;
+  time_t to = (time_t)(LAST_YEAR + 1 - 1970) * 365 * 86400L;
+
+  for(time_t t = from; t < to; t += SAMPLE_S){
+    check(name, t);
+    if(hostOffset(t) != hostOffset(t + SAMPLE_S)){
+      time_t change = findTransition(t, t + SAMPLE_S);
+      check(name, change - 1);
+      check(name, change);
+      check(name, change + 1);
+      transitions++;
+    }
+  }
+  return transitions;
+}
+
+int main(void)
+{
+  CFG_init();
+  TZ_init();
+
+  uint8_t tested = 0;
+  for(uint8_t i = 0; i < TZ_count(); i++){
+    char name[TZ_NAME_SIZE];
+    TZ_getNameAt(i, name);
+
+    char path[sizeof(ZONEINFO_DIR) + TZ_NAME_SIZE];
+    snprintf(path, sizeof(path), ZONEINFO_DIR "%s", name);
+    if(access(path, R_OK) != 0){
+      printf("skip %s, not in the host tz database\n", name);
+      continue;
+    }
+
+    char tz[TZ_NAME_SIZE + 1];
+    snprintf(tz, sizeof(tz), ":%s", name);
+    setenv("TZ", tz, 1);
+    tzset();
+    TZ_set(name);
+
+    uint32_t transitions = checkZone(name);
+    printf("%-24s %u transitions\n", name, transitions);
+    tested++;
+  }
+
+  printf("%u zones, %u checks, %u failures\n", tested, checks, failures);
+  if(tested == 0){
+    return SKIP_EXIT_CODE;
+  }
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+/*
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *
+ *  Checks that every form of SUB subscribes a client: topic names, a mask as a string,
+ *  a mask as a JSON number and the binary opcode. A subscribed client gets the topic's
+ *  fields that have a value with the next WS_process(), an empty subscription gets nothing.
+ */
+#include <Arduino.h>
+#include "config_store.h"
+#include "event_bus.h"
+#include "NTPSync.h"
+#include "pinctrl.h"
+#include "timezones.h"
+#include "web_socket.h"
+#include "sim.h"
+
+#define REPLY_SIZE        (2048)
+
+typedef struct {
+  const char* name;
+  const char* text;         // JSON command, or nullptr for the binary one
+  uint8_t mask;             // binary argument
+  const char* expect;       // a key the first delta must contain, nullptr for no delta
+  const char* absent;       // a key it must not contain
+}Case;
+
+static const Case cases[] = {
+  { "names",         "{\"SUB\":\"light\"}",  0, "\"CURRENT\"", "\"TIME\"" },
+  { "mask_string",   "{\"SUB\":\"1\"}",      0, "\"CURRENT\"", "\"TIME\"" },
+  { "mask_number",   "{\"SUB\":1}",          0, "\"CURRENT\"", "\"TIME\"" },
+  { "mask_number_2", "{\"SUB\":2}",          0, "\"TIME\"",    "\"CURRENT\"" },
+  { "mask_binary",   nullptr,                1, "\"CURRENT\"", "\"TIME\"" },
+  { "nothing",       "{\"SUB\":\"\"}",       0, nullptr,       nullptr },
+  /* Metrics are first sampled 5 s after boot, until then there is nothing to send. */
+  { "metrics_unset", "{\"SUB\":\"metrics\"}", 0, nullptr,     nullptr },
+};
+
+static char reply[REPLY_SIZE];
+static size_t replyLen = 0;
+
+static void collect(const char* data, size_t len)
+{
+  len = std::min(len, sizeof(reply) - 1 - replyLen);
+  memcpy(reply + replyLen, data, len);
+  replyLen += len;
+  reply[replyLen] = 0;
+}
+
+static bool check(const Case* c)
+{
+  replyLen = 0;
+  reply[0] = 0;
+  int8_t num = SIMWS_connect(collect);
+  if(num < 0){
+    printf("FAIL %s: no client slot\n", c->name);
+    return false;
+  }
+  if(c->text != nullptr){
+    SIMWS_receive(num, c->text);
+  }else{
+    uint8_t frame[2] = { WS_OP_SUB, c->mask };
+    SIMWS_receiveBin(num, frame, sizeof(frame));
+  }
+  WS_process();
+  SIMWS_disconnect(num);
+
+  bool ok;
+  if(c->expect == nullptr){
+    ok = (replyLen == 0);
+  }else{
+    ok = (strstr(reply, c->expect) != nullptr) && (strstr(reply, c->absent) == nullptr) &&
+         (strstr(reply, ":,") == nullptr) && (strstr(reply, ":}") == nullptr);   // no field without a value
+  }
+  printf("%s %s: %s\n", ok ? "ok  " : "FAIL", c->name, (replyLen > 0) ? reply : "no delta");
+  return ok;
+}
+
+int main(void)
+{
+  CFG_init();
+  PINCTRL_init();
+  WS_init();
+  TZ_init();
+  NTPS_init();
+  EVT_post(EVT_CONFIG_CHANGED, 0);    // fills the time fields, as a zone change would
+  EVT_process();
+
+  uint8_t failures = 0;
+  for(const Case& c : cases){
+    if(!check(&c)){
+      failures++;
+    }
+  }
+  printf("%u cases, %u failures\n", (unsigned)(sizeof(cases) / sizeof(cases[0])), failures);
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,60 @@
+/*
+ *  Author: Rada Berar
+ *  email: ujagaga@gmail.com
+ *
+ *  Boots with a cached connection whose address the router has since given to another host,
+ *  as after a power cycle with an old lease in the config store. The station must still take
+ *  the fast path to the cached BSSID, then move to the address DHCP hands out and cache that.
+ */
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include "config_store.h"
+#include "event_bus.h"
+#include "wifi_connection.h"
+#include "sim.h"
+
+#define RUN_MS            (5000)
+#define FAST_PATH_MS      (1000)      // the simulated full join takes 1500 ms
+#define STALE_IP          (0x4D01A8C0UL)   // 192.168.1.77 in lwIP byte order
+
+static const uint8_t cachedBssid[6] = { 0x02, 0x00, 0x5E, 0x51, 0x4D, 0x01 };
+
+int main(void)
+{
+  SIMNET_setConnectMs(1);       // the network is there from the start
+  CFG_init();
+  WIFIC_setCredentials(SIMNET_SSID, SIMNET_PASS);
+  CfgData* cfg = CFG_get();
+  memcpy(cfg->bssid, cachedBssid, sizeof(cfg->bssid));
+  cfg->channel = 6;
+  cfg->ip = STALE_IP;
+  cfg->gateway = 0x0101A8C0UL;
+  cfg->mask = 0x00FFFFFFUL;
+  cfg->dns = 0x0101A8C0UL;
+  CFG_save();
+
+  WIFIC_init();
+  while(millis() < RUN_MS){
+    EVT_process();
+    WIFIC_process();
+    delay(10);
+  }
+
+  char ip[16];
+  WIFIC_formatStationIp(ip, sizeof(ip));
+  uint32_t failures = 0;
+  if((WIFIC_getGotIpMs() == 0) || (WIFIC_getGotIpMs() > FAST_PATH_MS)){
+    printf("FAIL first GotIP after %u ms, expected the fast path\n", WIFIC_getGotIpMs());
+    failures++;
+  }
+  if(strcmp(ip, "127.0.0.1") != 0){
+    printf("FAIL station IP %s, expected the DHCP lease 127.0.0.1\n", ip);
+    failures++;
+  }
+  if(cfg->ip != SIM_LOOPBACK_IP){
+    printf("FAIL cached IP %08X, expected the DHCP lease\n", cfg->ip);
+    failures++;
+  }
+  printf("fast path GotIP after %u ms, station IP %s: %s\n", WIFIC_getGotIpMs(), ip, (failures == 0) ? "ok" : "FAILED");
+  return (failures == 0) ? 0 : 1;
+}
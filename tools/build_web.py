@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""
+Minifies and gzips the web UI sources in web/ into PROGMEM arrays.
+
+Usage:
+    python3 tools/build_web.py [--src web] [--out ESP_LCD_Lamp/web_assets.h]
+
+Run it after editing anything in web/ and commit the regenerated header.
+
+Static assets (*.css, *.js) are minified, gzipped and served as-is with a
+strong ETag and a one year immutable Cache-Control. Page templates (*.html)
+are only minified, because the firmware fills {{NAME}} placeholders while
+streaming them; their links to static assets are rewritten to
+/name.ext?v=<hash> so a changed asset is never served from a stale cache.
+Only the Python standard library is used.
+"""
+
+import argparse
+import gzip
+import hashlib
+import os
+import re
+
+ROOT = os.path.join(os.path.dirname(__file__), "..")
+DEFAULT_SRC = os.path.join(ROOT, "web")
+DEFAULT_OUT = os.path.join(ROOT, "ESP_LCD_Lamp", "web_assets.h")
+
+CONTENT_TYPES = {
+    ".css": "text/css",
+    ".js": "application/javascript",
+}
+
+
+def minify_css(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"\s+", " ", text)
+    text = re.sub(r"\s*([{};,>])\s*", r"\1", text)
+    text = re.sub(r":\s+", ":", text)
+    return text.replace(";}", "}").strip()
+
+
+def minify_js(text):
+    """Conservative: drops full line comments, indentation and blank lines.
+    Statements stay on their own lines so missing semicolons are harmless."""
+    out = []
+    for line in text.splitlines():
+        line = line.strip()
+        if line and not line.startswith("//"):
+            out.append(line)
+    return "\n".join(out)
+
+
+def minify_html(text):
+    text = re.sub(r"<!--.*?-->", "", text, flags=re.S)
+    text = re.sub(r"<script>(.*?)</script>",
+                  lambda m: "<script>" + minify_js(m.group(1)) + "</script>", text, flags=re.S)
+    text = re.sub(r">\s+<", "><", text)
+    text = re.sub(r"[ \t]*\n\s*", "\n", text)
+    return text.strip()
+
+
+def c_ident(name):
+    return re.sub(r"[^A-Za-z0-9]", "_", name).upper()
+
+
+def c_bytes(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("  " + ", ".join("0x%02X" % b for b in data[i:i + 16]) + ",")
+    return "\n".join(lines)
+
+
+def c_string(text):
+    """One C string literal per source line, newlines kept inside the quotes."""
+    lines = text.split("\n")
+    out = []
+    for i, line in enumerate(lines):
+        line = line.replace("\\", "\\\\").replace('"', '\\"')
+        out.append('  "%s%s"' % (line, "\\n" if i < len(lines) - 1 else ""))
+    return "\n".join(out)
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--src", default=DEFAULT_SRC)
+    ap.add_argument("--out", default=DEFAULT_OUT)
+    args = ap.parse_args()
+
+    names = sorted(os.listdir(args.src))
+    assets = []
+    versions = {}
+    for name in names:
+        ext = os.path.splitext(name)[1]
+        if ext not in CONTENT_TYPES:
+            continue
+        with open(os.path.join(args.src, name), encoding="utf-8") as f:
+            text = f.read()
+        text = minify_css(text) if ext == ".css" else minify_js(text)
+        raw = text.encode("utf-8")
+        data = gzip.compress(raw, compresslevel=9, mtime=0)
+        digest = hashlib.sha256(raw).hexdigest()[:16]
+        versions[name] = digest[:8]
+        assets.append((name, CONTENT_TYPES[ext], data, digest, len(raw)))
+
+    pages = []
+    for name in names:
+        if not name.endswith(".html"):
+            continue
+        with open(os.path.join(args.src, name), encoding="utf-8") as f:
+            text = minify_html(f.read())
+        text = re.sub(r'(href|src)="/([\w.-]+)"',
+                      lambda m: '%s="/%s?v=%s"' % (m.group(1), m.group(2), versions[m.group(2)])
+                      if m.group(2) in versions else m.group(0), text)
+        pages.append((name, text))
+
+    with open(args.out, "w") as f:
+        f.write("/* Generated by tools/build_web.py from web/, do not edit. */\n\n")
+        f.write("#ifndef WEB_ASSETS_H\n#define WEB_ASSETS_H\n\n")
+        f.write("#include <Arduino.h>\n#include <pgmspace.h>\n\n")
+        f.write("typedef struct{\n"
+                "  const char* path;\n"
+                "  const char* contentType;\n"
+                "  const uint8_t* data;     /* gzip compressed */\n"
+                "  uint16_t size;\n"
+                "  const char* etag;\n"
+                "}WebAsset;\n\n")
+        f.write("// --- Page templates, {{NAME}} placeholders are filled while streaming ---\n")
+        for name, text in pages:
+            f.write("/* %s: %u bytes */\n" % (name, len(text.encode("utf-8"))))
+            f.write("static const char %s[] PROGMEM =\n%s;\n\n" % (c_ident(name), c_string(text)))
+
+        f.write("// --- Static assets ---\n")
+        for name, _, data, _, raw_len in assets:
+            f.write("/* %s: %u bytes, %u gzipped */\n" % (name, raw_len, len(data)))
+            f.write("static const uint8_t %s_GZ[] PROGMEM = {\n%s\n};\n\n" % (c_ident(name), c_bytes(data)))
+
+        f.write("static const WebAsset WEB_ASSETS[] = {\n")
+        for name, ctype, data, digest, _ in assets:
+            f.write('  { "/%s", "%s", %s_GZ, sizeof(%s_GZ), "\\"%s\\"" },\n'
+                    % (name, ctype, c_ident(name), c_ident(name), digest))
+        f.write("};\n\n")
+        f.write("#define WEB_ASSET_COUNT     (sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]))\n\n")
+        f.write("#endif\n")
+
+    total_raw = sum(a[4] for a in assets)
+    total_gz = sum(len(a[2]) for a in assets)
+    print("%d assets, %d -> %d bytes gzipped; %d templates, %d bytes" %
+          (len(assets), total_raw, total_gz, len(pages), sum(len(p[1]) for p in pages)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+"""
+Compares a benchmark run of the host build against the committed baseline.
+
+Usage:
+    python3 tools/check_bench.py sim/bench_baseline.json build/sim/bench.json [--ns-tolerance 4]
+
+Fails when an operation allocates more often or holds more heap than the
+baseline allows, when it is slower than ns_tolerance times its baseline
+latency, or when an operation is missing from either side. Allocations are
+exact, latency gets a wide margin because it depends on the host. Lower the
+baseline numbers when a path gets cheaper.
+Only the Python standard library is used.
+"""
+
+import argparse
+import json
+import sys
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("baseline")
+    ap.add_argument("result")
+    ap.add_argument("--ns-tolerance", type=float)
+    args = ap.parse_args()
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    with open(args.result) as f:
+        result = {op["name"]: op for op in json.load(f)["ops"]}
+
+    tolerance = args.ns_tolerance or baseline.get("ns_tolerance", 4.0)
+    failures = []
+
+    for name, limit in sorted(baseline["ops"].items()):
+        op = result.pop(name, None)
+        if op is None:
+            failures.append("%s: missing from the run" % name)
+            continue
+        if op["allocs_per_op"] > limit["allocs_per_op"]:
+            failures.append("%s: %.3f allocations per op, baseline %s"
+                            % (name, op["allocs_per_op"], limit["allocs_per_op"]))
+        if op["peak_bytes"] > limit["peak_bytes"]:
+            failures.append("%s: peak heap %d bytes, baseline %d" % (name, op["peak_bytes"], limit["peak_bytes"]))
+        if op["ns_per_op"] > limit["ns_per_op"] * tolerance:
+            failures.append("%s: %d ns per op, baseline %d x %.1f"
+                            % (name, op["ns_per_op"], limit["ns_per_op"], tolerance))
+        print("%-20s %8d ns/op %7.3f allocs/op %6d peak bytes"
+              % (name, op["ns_per_op"], op["allocs_per_op"], op["peak_bytes"]))
+
+    for name in sorted(result):
+        failures.append("%s: not in the baseline" % name)
+
+    for failure in failures:
+        print("FAIL " + failure, file=sys.stderr)
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == "__main__":
+    main()
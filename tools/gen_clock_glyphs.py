@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""
+Rasterizes the clock face glyphs (0-9 and ':') into 1bpp PROGMEM bitmaps.
+
+Usage:
+    python3 tools/gen_clock_glyphs.py [--font FONT.ttf] [--out ESP_LCD_Lamp/clock_glyphs.h]
+
+Requires Pillow. Every glyph is rendered into a cell of the same size so the
+firmware can blit any of them into a digit cell with a single address window.
+Rows are packed MSB first, each row padded to a whole byte.
+"""
+
+import argparse
+import os
+
+from PIL import Image, ImageDraw, ImageFont
+
+CHARS = "0123456789:"
+CELL_W = 84
+CELL_H = 112
+MARGIN = 4
+THRESHOLD = 128
+DEFAULT_FONT = "/usr/share/fonts/truetype/dejavu/DejaVuSansMono-Bold.ttf"
+DEFAULT_OUT = os.path.join(os.path.dirname(__file__), "..", "ESP_LCD_Lamp", "clock_glyphs.h")
+
+
+def fit_font(path):
+    """Largest font size at which every glyph fits inside the cell margins."""
+    size = CELL_H
+    while size > 8:
+        font = ImageFont.truetype(path, size)
+        boxes = [font.getbbox(c) for c in CHARS]
+        w = max(b[2] - b[0] for b in boxes)
+        h = max(b[3] for b in boxes) - min(b[1] for b in boxes)
+        if w <= CELL_W - 2 * MARGIN and h <= CELL_H - 2 * MARGIN:
+            return font
+        size -= 1
+    raise SystemExit("font does not fit the cell")
+
+
+def rasterize(font, char):
+    digit_box = font.getbbox("0")
+    top = digit_box[1]
+    height = digit_box[3] - digit_box[1]
+    box = font.getbbox(char)
+    img = Image.new("L", (CELL_W, CELL_H), 0)
+    draw = ImageDraw.Draw(img)
+    x = (CELL_W - (box[2] - box[0])) // 2 - box[0]
+    y = (CELL_H - height) // 2 - top
+    draw.text((x, y), char, font=font, fill=255)
+    return img
+
+
+def pack(img):
+    stride = (CELL_W + 7) // 8
+    out = bytearray()
+    px = img.load()
+    for y in range(CELL_H):
+        row = bytearray(stride)
+        for x in range(CELL_W):
+            if px[x, y] >= THRESHOLD:
+                row[x >> 3] |= 0x80 >> (x & 7)
+        out += row
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--font", default=DEFAULT_FONT)
+    parser.add_argument("--out", default=DEFAULT_OUT)
+    args = parser.parse_args()
+
+    font = fit_font(args.font)
+    stride = (CELL_W + 7) // 8
+
+    lines = [
+        "/* Generated by tools/gen_clock_glyphs.py from %s at %d px. Do not edit. */"
+        % (os.path.basename(args.font), font.size),
+        "#ifndef CLOCK_GLYPHS_H",
+        "#define CLOCK_GLYPHS_H",
+        "",
+        "#define CLK_GLYPH_W       %d" % CELL_W,
+        "#define CLK_GLYPH_H       %d" % CELL_H,
+        "#define CLK_GLYPH_STRIDE  %d" % stride,
+        "#define CLK_GLYPH_COUNT   %d" % len(CHARS),
+        "",
+        'static const char CLK_GLYPH_CHARS[] = "%s";' % CHARS,
+        "",
+        "static const uint8_t CLK_GLYPHS[CLK_GLYPH_COUNT][CLK_GLYPH_H * CLK_GLYPH_STRIDE] PROGMEM = {",
+    ]
+    for char in CHARS:
+        data = pack(rasterize(font, char))
+        lines.append("  { // '%s'" % char)
+        for i in range(0, len(data), stride):
+            lines.append("    " + ", ".join("0x%02X" % b for b in data[i:i + stride]) + ",")
+        lines.append("  },")
+    lines += ["};", "", "#endif", ""]
+
+    with open(args.out, "w") as f:
+        f.write("\n".join(lines))
+
+
+if __name__ == "__main__":
+    main()
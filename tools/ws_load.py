@@ -0,0 +1,328 @@
+#!/usr/bin/env python3
+"""
+WebSocket load generator and end-to-end latency benchmark for the lamp.
+
+Usage:
+    python3 tools/ws_load.py --url ws://192.168.4.1:81/ [--clients 4] [--duration 60]
+        [--rate 2] [--mix TOGGLE=4,STATUS=2,APLIST=1,TZLIST=1,BRIGHTNESS=1,TZ=1]
+        [--binary 0.25] [--churn 20] [--seed 1] [--label v1.2] [--json report.json]
+        [--compare old_report.json]
+
+Opens N clients that each subscribe to the light topic like the web UI does,
+then send commands from the mix at random (Poisson) intervals. Measured:
+  - TOGGLE to CURRENT: time from sending TOGGLE until the same client sees the
+    CURRENT field change. TOGGLEs sent within the firmware's 500 ms lockout
+    after the last change this client saw are only counted, not timed. When one
+    change answers several pending TOGGLEs, the oldest is timed and the rest are
+    counted as coalesced. BRIGHTNESS also changes CURRENT, leave it out of the
+    mix for the cleanest toggle numbers.
+  - round trips of the commands that get a direct reply (APLIST, TZLIST, TZ,
+    and STATUS when sent as binary)
+  - connection attempts, failures, drops (closed by the lamp), rejections
+    (closed before the first frame, e.g. over the client limit) and churn
+    (reconnects the tool makes on purpose, resuming with SYNC)
+  - frames and bytes in both directions
+The JSON report records the configuration with the results. Runs with the same
+mix, rate and seed can be compared across firmware versions with --compare.
+Use tools/ws_standin.py as the target when no device is at hand.
+Only the Python standard library is used.
+"""
+
+import argparse
+import asyncio
+import json
+import random
+import struct
+import sys
+import time
+import urllib.parse
+
+import wsproto
+
+SCHEMA = 1
+OPCODES = {"TOGGLE": 0x01, "STATUS": 0x02, "BRIGHTNESS": 0x03, "APLIST": 0x04, "TZ": 0x05, "TZLIST": 0x06}
+REPLY_KEYS = ("APLIST", "TZLIST", "TZ")
+ZONES = ["Europe/Belgrade", "Europe/London"]
+REJECT_S = 0.2
+TOGGLE_LOCKOUT_S = 0.5
+RECONNECT_S = 0.5
+
+
+def percentiles(samples):
+    if not samples:
+        return {"count": 0}
+    s = sorted(samples)
+
+    def rank(p):
+        return round(s[min(len(s) - 1, int(p * len(s)))] * 1000, 2)
+    return {"count": len(s), "p50": rank(0.50), "p90": rank(0.90), "p99": rank(0.99), "max": round(s[-1] * 1000, 2)}
+
+
+class Stats:
+    def __init__(self):
+        self.conn = {"attempts": 0, "established": 0, "failed": 0, "dropped": 0, "rejected": 0, "churned": 0}
+        self.frames = {"sent": 0, "received": 0, "bytes_out": 0, "bytes_in": 0}
+        self.commands = {}
+        self.latency = {"TOGGLE_TO_CURRENT": []}
+        self.toggle_unanswered = 0
+        self.toggle_in_lockout = 0
+        self.toggle_coalesced = 0
+        self.reply_unanswered = 0
+
+
+class LoadClient:
+    def __init__(self, index, args, stats, rng, stop_at):
+        self.index = index
+        self.args = args
+        self.stats = stats
+        self.rng = rng
+        self.stop_at = stop_at
+        self.version = None
+        self.current = None
+        self.changed_at = 0.0     # when this client last saw CURRENT change
+        self.toggles = []         # send times of unanswered TOGGLEs
+        self.pending = {}         # reply key -> send times, oldest first
+
+    def expire(self, now):
+        timeout = self.args.timeout
+        fresh = [t for t in self.toggles if now - t < timeout]
+        self.stats.toggle_unanswered += len(self.toggles) - len(fresh)
+        self.toggles = fresh
+        for key, times in self.pending.items():
+            fresh = [t for t in times if now - t < timeout]
+            self.stats.reply_unanswered += len(times) - len(fresh)
+            self.pending[key] = fresh
+
+    def answer(self, key, now):
+        times = self.pending.get(key)
+        if times:
+            self.stats.latency.setdefault(key, []).append(now - times.pop(0))
+
+    def on_message(self, opcode, payload, now):
+        self.stats.frames["received"] += 1
+        self.stats.frames["bytes_in"] += len(payload)
+        if opcode == wsproto.OP_BINARY:
+            if payload and payload[0] & 0x80:
+                name = [k for k, v in OPCODES.items() if v == payload[0] & 0x7F]
+                if name:
+                    self.answer(name[0], now)
+            return
+        try:
+            doc = json.loads(payload)
+        except ValueError:
+            return
+        if "V" in doc:
+            self.version = doc["V"]
+        if "CURRENT" in doc:
+            if self.current is not None and doc["CURRENT"] != self.current:
+                self.changed_at = now
+                if self.toggles:
+                    self.stats.latency["TOGGLE_TO_CURRENT"].append(now - self.toggles[0])
+                    self.stats.toggle_coalesced += len(self.toggles) - 1
+                    self.toggles = []
+            self.current = doc["CURRENT"]
+        for key in REPLY_KEYS:
+            if key in doc:
+                self.answer(key, now)
+
+    async def send(self, writer, opcode, payload):
+        await wsproto.send(writer, opcode, payload, True)
+        self.stats.frames["sent"] += 1
+        self.stats.frames["bytes_out"] += len(payload)
+
+    async def command(self, writer, name):
+        binary = self.rng.random() < self.args.binary
+        arg = b""
+        text = '""'
+        if name == "BRIGHTNESS":
+            level = self.rng.choice([0, 512, 1023])
+            arg, text = struct.pack("<H", level), str(level)
+        elif name == "TZ":
+            zone = self.rng.choice(ZONES)
+            arg, text = zone.encode(), '"%s"' % zone
+        elif name == "TOGGLE":
+            text = '"1"'
+
+        now = time.monotonic()
+        if name == "TOGGLE":
+            if now - self.changed_at < TOGGLE_LOCKOUT_S:
+                self.stats.toggle_in_lockout += 1
+            else:
+                self.toggles.append(now)
+        elif name in REPLY_KEYS or (name == "STATUS" and binary):
+            self.pending.setdefault(name, []).append(now)
+        self.stats.commands[name] = self.stats.commands.get(name, 0) + 1
+
+        if binary and name != "APLIST" and name != "TZLIST":
+            await self.send(writer, wsproto.OP_BINARY, bytes([OPCODES[name]]) + arg)
+        else:
+            await self.send(writer, wsproto.OP_TEXT, '{"%s":%s}' % (name, text))
+
+    async def session(self, host, port, path):
+        """One connection. Returns True when the tool ended it, False when the lamp did."""
+        args = self.args
+        self.stats.conn["attempts"] += 1
+        try:
+            reader, writer = await asyncio.wait_for(asyncio.open_connection(host, port), args.timeout)
+            await asyncio.wait_for(wsproto.client_handshake(reader, writer, host, port, path), args.timeout)
+        except (OSError, asyncio.TimeoutError, wsproto.ConnectionClosed, asyncio.IncompleteReadError):
+            self.stats.conn["failed"] += 1
+            return False
+        self.stats.conn["established"] += 1
+        opened = time.monotonic()
+        received_any = False
+
+        if self.version is None:
+            await self.send(writer, wsproto.OP_TEXT, '{"SUB":"%s","STATUS":""}' % args.topics)
+        else:
+            await self.send(writer, wsproto.OP_TEXT, '{"SUB":"%s","SYNC":%d}' % (args.topics, self.version))
+
+        churn_at = opened + self.rng.expovariate(1.0 / args.churn) if args.churn > 0 else float("inf")
+        next_cmd = opened + self.rng.expovariate(args.rate) if args.rate > 0 else float("inf")
+        names, weights = zip(*args.mix)
+        receiver = asyncio.ensure_future(wsproto.receive(reader, writer, True))
+        try:
+            while True:
+                now = time.monotonic()
+                self.expire(now)
+                if now >= self.stop_at:
+                    return True
+                if now >= churn_at:
+                    self.stats.conn["churned"] += 1
+                    return True
+                if now >= next_cmd:
+                    await self.command(writer, self.rng.choices(names, weights)[0])
+                    next_cmd += self.rng.expovariate(args.rate)
+                    continue
+                wait = min(next_cmd, churn_at, self.stop_at) - now
+                done, _ = await asyncio.wait([receiver], timeout=wait)
+                if done:
+                    try:
+                        opcode, payload = receiver.result()
+                    except wsproto.ConnectionClosed:
+                        closed_early = not received_any and time.monotonic() - opened < REJECT_S
+                        self.stats.conn["rejected" if closed_early else "dropped"] += 1
+                        return False
+                    received_any = True
+                    self.on_message(opcode, payload, time.monotonic())
+                    receiver = asyncio.ensure_future(wsproto.receive(reader, writer, True))
+        except ConnectionError:
+            self.stats.conn["dropped"] += 1
+            return False
+        finally:
+            receiver.cancel()
+            try:
+                await wsproto.send(writer, wsproto.OP_CLOSE, b"\x03\xe8", True)
+            except (ConnectionError, RuntimeError):
+                pass
+            writer.close()
+
+    async def run(self, host, port, path):
+        await asyncio.sleep(self.index * self.args.stagger)
+        while time.monotonic() < self.stop_at:
+            if not await self.session(host, port, path):
+                await asyncio.sleep(RECONNECT_S)
+        self.expire(float("inf"))
+
+
+def parse_mix(text):
+    mix = []
+    for part in text.split(","):
+        name, _, weight = part.partition("=")
+        name = name.strip().upper()
+        if name not in OPCODES:
+            raise argparse.ArgumentTypeError("unknown command " + name)
+        mix.append((name, float(weight or 1)))
+    return mix
+
+
+def compare(old, new):
+    def rows(report):
+        out = {}
+        for key, lat in report["latency_ms"].items():
+            for p in ("p50", "p90", "p99"):
+                if p in lat:
+                    out["latency %s %s ms" % (key, p)] = lat[p]
+        out["throughput frames/s in"] = report["frames"]["received_per_s"]
+        out["throughput frames/s out"] = report["frames"]["sent_per_s"]
+        out["toggles unanswered"] = report["toggle_unanswered"]
+        out["toggles coalesced"] = report["toggle_coalesced"]
+        for key in ("dropped", "rejected", "failed"):
+            out["connections " + key] = report["connections"][key]
+        return out
+
+    if old["config"] != new["config"]:
+        print("warning: the runs used different configurations", file=sys.stderr)
+    a, b = rows(old), rows(new)
+    print("%-34s %12s %12s %9s" % ("", old.get("label") or "old", new.get("label") or "new", "change"))
+    for key in sorted(set(a) | set(b)):
+        va, vb = a.get(key), b.get(key)
+        change = "%+.0f%%" % ((vb - va) * 100.0 / va) if va and vb is not None else ""
+        print("%-34s %12s %12s %9s" % (key, va, vb, change))
+
+
+async def run(args):
+    url = urllib.parse.urlparse(args.url)
+    host, port, path = url.hostname, url.port or 81, url.path or "/"
+    stats = Stats()
+    start = time.monotonic()
+    stop_at = start + args.duration
+    rng = random.Random(args.seed)
+    clients = [LoadClient(i, args, stats, random.Random(rng.random()), stop_at) for i in range(args.clients)]
+    await asyncio.gather(*(c.run(host, port, path) for c in clients))
+    elapsed = time.monotonic() - start
+
+    frames = dict(stats.frames)
+    frames["sent_per_s"] = round(frames["sent"] / elapsed, 2)
+    frames["received_per_s"] = round(frames["received"] / elapsed, 2)
+    return {
+        "schema": SCHEMA,
+        "label": args.label,
+        "target": args.url,
+        "config": {"clients": args.clients, "duration_s": args.duration, "rate": args.rate,
+                   "mix": dict(args.mix), "binary": args.binary, "churn_s": args.churn,
+                   "topics": args.topics, "timeout_s": args.timeout, "seed": args.seed},
+        "elapsed_s": round(elapsed, 2),
+        "connections": stats.conn,
+        "frames": frames,
+        "commands": stats.commands,
+        "latency_ms": {key: percentiles(samples) for key, samples in stats.latency.items()},
+        "toggle_unanswered": stats.toggle_unanswered,
+        "toggle_in_lockout": stats.toggle_in_lockout,
+        "toggle_coalesced": stats.toggle_coalesced,
+        "reply_unanswered": stats.reply_unanswered,
+    }
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--url", default="ws://192.168.4.1:81/")
+    ap.add_argument("--clients", type=int, default=4)
+    ap.add_argument("--duration", type=float, default=60, help="seconds")
+    ap.add_argument("--rate", type=float, default=2, help="commands per second per client")
+    ap.add_argument("--mix", type=parse_mix, default=parse_mix("TOGGLE=4,STATUS=2,APLIST=1,TZLIST=1,BRIGHTNESS=1,TZ=1"))
+    ap.add_argument("--binary", type=float, default=0.25, help="share of commands sent as binary frames")
+    ap.add_argument("--churn", type=float, default=0, help="mean seconds between reconnects per client, 0 off")
+    ap.add_argument("--topics", default="light")
+    ap.add_argument("--timeout", type=float, default=3, help="seconds before a command counts as unanswered")
+    ap.add_argument("--stagger", type=float, default=0.1, help="seconds between client start-ups")
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--label", default="")
+    ap.add_argument("--json", help="write the report here instead of stdout")
+    ap.add_argument("--compare", help="earlier report to compare this run with")
+    args = ap.parse_args()
+
+    report = asyncio.run(run(args))
+    text = json.dumps(report, indent=2)
+    if args.json:
+        with open(args.json, "w") as f:
+            f.write(text + "\n")
+    else:
+        print(text)
+    if args.compare:
+        with open(args.compare) as f:
+            compare(json.load(f), report)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,326 @@
+#!/usr/bin/env python3
+"""
+Local stand-in for the lamp's WebSocket server on port 81.
+
+Usage:
+    python3 tools/ws_standin.py [--port 8081] [--max-clients 5] [--tick-ms 5]
+
+Speaks the same protocol as ESP_LCD_Lamp/web_socket.cpp, so tools/ws_load.py
+and the web UI can be exercised without a device:
+  - JSON commands {"KEY":value,...} and binary [opcode][argument] frames
+  - versioned state fields sent as one {"V":n,...} delta per client per tick,
+    for the topics the client subscribed to with SUB
+  - STATUS snapshots, SYNC resumes, APLIST after a simulated scan, TZ, TZLIST
+  - the 500 ms lockout of TOGGLE and the server's client limit, beyond which
+    new connections are closed right after the handshake, as WebSocketsServer does
+  - BRIGHTNESS and FADE levels; fades are not timed, LEVEL and TARGET both
+    report the new level at once
+  - SCHED rules are stored and listed, but never fire and NEXT stays 0
+Timing is host timing, so only relative results against a device are meaningful.
+Only the Python standard library is used.
+"""
+
+import argparse
+import asyncio
+import json
+import random
+import struct
+import time
+
+import wsproto
+
+OP_TOGGLE = 0x01
+OP_STATUS = 0x02
+OP_SET_BRIGHTNESS = 0x03
+OP_APLIST = 0x04
+OP_TZ = 0x05
+OP_TZLIST = 0x06
+OP_SUB = 0x07
+OP_SYNC = 0x08
+OP_LOG = 0x09
+OP_FADE = 0x0A
+OP_SCHED = 0x0B
+OP_REPLY = 0x80
+
+TOPIC_LIGHT = 0x01
+TOPIC_TIME = 0x02
+TOPIC_WIFI = 0x04
+TOPIC_METRICS = 0x08
+TOPIC_ALL = 0x0F
+TOPIC_NAMES = ["light", "time", "wifi", "metrics", "log"]
+
+TOGGLE_LOCKOUT_S = 0.5
+LEVEL_MAX = 1023
+SCHED_RULES = 8
+SCAN_S = 2.5
+SCAN_CACHE_S = 30
+ZONES = ["Europe/Belgrade", "Europe/London", "America/New_York", "Asia/Tokyo", "Australia/Sydney"]
+APS = [{"ssid": "HomeNet", "rssi": -48, "ch": 6, "enc": "WPA2"},
+       {"ssid": "Neighbour", "rssi": -77, "ch": 11, "enc": "WPA2"}]
+
+# (key, topic, quoted), in the firmware's field order
+FIELDS = [("CURRENT", TOPIC_LIGHT, False), ("LEVEL", TOPIC_LIGHT, False), ("TARGET", TOPIC_LIGHT, False),
+          ("TIME", TOPIC_TIME, True), ("TZ", TOPIC_TIME, True),
+          ("SYNCED", TOPIC_TIME, False), ("IP", TOPIC_WIFI, True), ("MSGS", TOPIC_METRICS, False),
+          ("HEAP", TOPIC_METRICS, False), ("UPTIME", TOPIC_METRICS, False), ("CLIENTS", TOPIC_METRICS, False)]
+
+
+class Client:
+    def __init__(self, writer):
+        self.writer = writer
+        self.topics = 0
+        self.pending_full = 0
+        self.sent_version = 0
+
+
+class Lamp:
+    def __init__(self, max_clients):
+        self.max_clients = max_clients
+        self.clients = {}
+        self.version_base = random.getrandbits(15) << 16
+        self.version = self.version_base
+        self.fields = {}
+        self.light = 0
+        self.level = 0
+        self.on_level = LEVEL_MAX
+        self.sched = [[0, 0, 0, 0, 0] for _ in range(SCHED_RULES)]
+        self.light_changed_at = 0.0
+        self.tz = ZONES[0]
+        self.scan_done_at = None
+        self.scan_waiting = set()
+        self.msg_count = 0
+        self.start = time.monotonic()
+        self.refresh()
+
+    def set_field(self, key, value):
+        if key not in self.fields or self.fields[key][0] != value:
+            self.version += 1
+            self.fields[key] = (value, self.version)
+
+    def refresh(self):
+        self.set_field("CURRENT", str(self.light))
+        self.set_field("LEVEL", str(self.level))
+        self.set_field("TARGET", str(self.level))
+        self.set_field("TIME", time.strftime("%H:%M"))
+        self.set_field("TZ", self.tz)
+        self.set_field("SYNCED", "1")
+        self.set_field("IP", "127.0.0.1")
+        now = time.monotonic()
+        if int(now - self.start) % 5 == 0:
+            self.set_field("MSGS", str(self.msg_count))
+            self.set_field("HEAP", "40000")
+            self.set_field("UPTIME", str(int(now - self.start)))
+            self.set_field("CLIENTS", str(len(self.clients)))
+
+    def delta(self, topics, full_topics, since):
+        parts = ['"V":%d' % self.version]
+        for key, topic, quoted in FIELDS:
+            value, version = self.fields.get(key, (None, 0))
+            if value is None or not topic & topics or (version <= since and not topic & full_topics):
+                continue
+            parts.append('"%s":%s' % (key, '"%s"' % value if quoted else value))
+        return "{%s}" % ",".join(parts) if len(parts) > 1 else None
+
+    def set_level(self, level):
+        self.level = max(0, min(level, LEVEL_MAX))
+        self.light = 1 if self.level > 0 else 0
+        if self.level:
+            self.on_level = self.level
+
+    # ---- commands, arg is (text, value) ----
+    def toggle(self, num, arg, binary):
+        now = time.monotonic()
+        if now - self.light_changed_at >= TOGGLE_LOCKOUT_S:
+            self.set_level(0 if self.light else self.on_level)
+            self.light_changed_at = now
+
+    def status(self, num, arg, binary):
+        if binary:
+            return bytes([OP_STATUS | OP_REPLY, self.light]) + struct.pack("<HH", self.level, self.level)
+        c = self.clients[num]
+        topics = c.topics & TOPIC_ALL or TOPIC_ALL
+        c.sent_version = self.version
+        c.pending_full = 0
+        return self.delta(topics, topics, 0)
+
+    def brightness(self, num, arg, binary):
+        self.set_level(arg[1])
+
+    def fade(self, num, arg, binary):
+        if binary:
+            self.set_level(arg[1] & 0xFFFF)
+        else:
+            level = arg[0].split(",")[0]
+            self.set_level(int(level) if level.isdigit() else 0)
+
+    def sched_cmd(self, num, arg, binary):
+        if binary:
+            raw = arg[0].encode("latin-1").ljust(8, b"\0")
+            if raw[0] and not self.set_rule(raw[0] - 1, list(struct.unpack("<BBBHH", raw[1:8]))):
+                return bytes([OP_SCHED | OP_REPLY])
+            return bytes([OP_SCHED | OP_REPLY]) + struct.pack("<I", 0) + \
+                b"".join(struct.pack("<BBBHH", *rule) for rule in self.sched)
+        if arg[0]:
+            values = arg[0].split(",")
+            if len(values) != 6 or not all(v.isdigit() for v in values):
+                return json.dumps({"ERROR": "SCHED rule"}, separators=(",", ":"))
+            if int(values[0]) >= SCHED_RULES:
+                return json.dumps({"ERROR": "SCHED slot"}, separators=(",", ":"))
+            if not self.set_rule(int(values[0]), [int(v) for v in values[1:]]):
+                return json.dumps({"ERROR": "SCHED rule"}, separators=(",", ":"))
+        return json.dumps({"SCHED": self.sched, "NEXT": 0}, separators=(",", ":"))
+
+    def set_rule(self, index, rule):
+        days, hour, minute, level, fade = rule
+        if index < SCHED_RULES and hour < 24 and minute < 60 and level <= LEVEL_MAX:
+            self.sched[index] = [days & 0x7F, hour, minute, level, min(fade, 0xFFFF)]
+            return True
+        return False
+
+    def aplist(self, num, arg, binary):
+        now = time.monotonic()
+        if self.scan_done_at is not None and 0 <= now - self.scan_done_at < SCAN_CACHE_S:
+            return json.dumps({"APLIST": APS}, separators=(",", ":"))
+        if self.scan_done_at is None or now - self.scan_done_at >= SCAN_CACHE_S:
+            self.scan_done_at = now + SCAN_S     # otherwise a scan is running, wait for it
+        self.scan_waiting.add(num)
+
+    def tz_cmd(self, num, arg, binary):
+        if arg[0] in ZONES:
+            self.tz = arg[0]
+        if binary:
+            return bytes([OP_TZ | OP_REPLY]) + self.tz.encode()
+        return '{"TZ":"%s"}' % self.tz
+
+    def tzlist(self, num, arg, binary):
+        return json.dumps({"TZLIST": ZONES}, separators=(",", ":"))
+
+    def sub(self, num, arg, binary):
+        c = self.clients[num]
+        if binary or arg[0][:1].isdigit():
+            topics = arg[1] & 0x1F
+        else:
+            topics = sum(1 << i for i, name in enumerate(TOPIC_NAMES) if name in arg[0])
+        c.pending_full |= topics & ~c.topics & TOPIC_ALL
+        c.topics = topics
+
+    def sync(self, num, arg, binary):
+        c = self.clients[num]
+        if arg[1] < self.version_base or arg[1] > self.version:
+            c.pending_full = c.topics & TOPIC_ALL
+        else:
+            c.sent_version = arg[1]
+            c.pending_full = 0
+
+    def log(self, num, arg, binary):
+        pass
+
+    COMMANDS = {"APLIST": (OP_APLIST, aplist), "TOGGLE": (OP_TOGGLE, toggle), "STATUS": (OP_STATUS, status),
+                "BRIGHTNESS": (OP_SET_BRIGHTNESS, brightness), "TZ": (OP_TZ, tz_cmd), "TZLIST": (OP_TZLIST, tzlist),
+                "SUB": (OP_SUB, sub), "SYNC": (OP_SYNC, sync), "LOG": (OP_LOG, log),
+                "FADE": (OP_FADE, fade), "SCHED": (OP_SCHED, sched_cmd)}
+    BY_OPCODE = {op: fn for op, fn in COMMANDS.values()}
+
+    def dispatch(self, num, opcode, payload):
+        replies = []
+        if opcode == wsproto.OP_TEXT:
+            try:
+                doc = json.loads(payload)
+            except ValueError:
+                return replies
+            if not isinstance(doc, dict):
+                return replies
+            for key, value in doc.items():
+                if key not in self.COMMANDS:
+                    continue
+                text = value if isinstance(value, str) else ""
+                number = int(value) if isinstance(value, (int, float)) else int(text) if text.isdigit() else 0
+                self.msg_count += 1
+                replies.append(self.COMMANDS[key][1](self, num, (text, number), False))
+        elif payload:
+            fn = self.BY_OPCODE.get(payload[0])
+            if fn:
+                arg = payload[1:33]
+                number = struct.unpack("<i", (arg[:4] + b"\0\0\0\0")[:4])[0]
+                self.msg_count += 1
+                replies.append(fn(self, num, (arg.decode("latin-1"), number), True))
+        return [r for r in replies if r is not None]
+
+
+async def send_reply(writer, reply):
+    if isinstance(reply, bytes):
+        await wsproto.send(writer, wsproto.OP_BINARY, reply, False)
+    else:
+        await wsproto.send(writer, wsproto.OP_TEXT, reply, False)
+
+
+async def ticker(lamp, tick_s):
+    while True:
+        await asyncio.sleep(tick_s)
+        lamp.refresh()
+        if lamp.scan_waiting and time.monotonic() >= lamp.scan_done_at:
+            reply = json.dumps({"APLIST": APS}, separators=(",", ":"))
+            for num in list(lamp.scan_waiting):
+                if num in lamp.clients:
+                    await send_reply(lamp.clients[num].writer, reply)
+            lamp.scan_waiting.clear()
+        for num, c in list(lamp.clients.items()):
+            if not c.topics & TOPIC_ALL or (c.sent_version == lamp.version and not c.pending_full):
+                continue
+            frame = lamp.delta(c.topics, c.pending_full, c.sent_version)
+            c.sent_version = lamp.version
+            c.pending_full = 0
+            if frame:
+                try:
+                    await send_reply(c.writer, frame)
+                except ConnectionError:
+                    pass
+
+
+async def serve_client(lamp, reader, writer):
+    try:
+        await wsproto.server_handshake(reader, writer)
+    except (wsproto.ConnectionClosed, asyncio.IncompleteReadError, ConnectionError):
+        writer.close()
+        return
+    free = [n for n in range(lamp.max_clients) if n not in lamp.clients]
+    if not free:
+        writer.close()
+        return
+    num = free[0]
+    lamp.clients[num] = Client(writer)
+    lamp.clients[num].sent_version = lamp.version
+    try:
+        while True:
+            opcode, payload = await wsproto.receive(reader, writer, False)
+            for reply in lamp.dispatch(num, opcode, payload):
+                await send_reply(writer, reply)
+    except (wsproto.ConnectionClosed, ConnectionError):
+        pass
+    finally:
+        del lamp.clients[num]
+        lamp.scan_waiting.discard(num)
+        writer.close()
+
+
+async def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--host", default="127.0.0.1")
+    ap.add_argument("--port", type=int, default=8081)
+    ap.add_argument("--max-clients", type=int, default=5, help="WEBSOCKETS_SERVER_CLIENT_MAX of the device")
+    ap.add_argument("--tick-ms", type=float, default=5, help="period of the firmware's ws task")
+    args = ap.parse_args()
+
+    lamp = Lamp(args.max_clients)
+    server = await asyncio.start_server(lambda r, w: serve_client(lamp, r, w), args.host, args.port)
+    print("stand-in lamp listening on ws://%s:%d/" % (args.host, args.port), flush=True)
+    asyncio.ensure_future(ticker(lamp, args.tick_ms / 1000))
+    async with server:
+        await server.serve_forever()
+
+
+if __name__ == "__main__":
+    try:
+        asyncio.run(main())
+    except KeyboardInterrupt:
+        pass
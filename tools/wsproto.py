@@ -0,0 +1,137 @@
+"""
+Minimal RFC 6455 WebSocket framing over asyncio streams, for the lamp test tools.
+
+Both sides are covered: ws_load.py is a client, ws_standin.py a server.
+Only what the lamp uses is implemented: text and binary messages, ping/pong,
+close, and reassembly of fragmented messages. No extensions.
+Only the Python standard library is used.
+"""
+
+import asyncio
+import base64
+import hashlib
+import os
+import struct
+
+GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+OP_CONT = 0x0
+OP_TEXT = 0x1
+OP_BINARY = 0x2
+OP_CLOSE = 0x8
+OP_PING = 0x9
+OP_PONG = 0xA
+
+MAX_MESSAGE = 64 * 1024
+
+
+class ConnectionClosed(Exception):
+    pass
+
+
+def accept_key(key):
+    return base64.b64encode(hashlib.sha1((key + GUID).encode()).digest()).decode()
+
+
+async def _read_headers(reader):
+    data = await reader.readuntil(b"\r\n\r\n")
+    lines = data.decode("latin-1").split("\r\n")
+    headers = {}
+    for line in lines[1:]:
+        if ":" in line:
+            name, value = line.split(":", 1)
+            headers[name.strip().lower()] = value.strip()
+    return lines[0], headers
+
+
+async def client_handshake(reader, writer, host, port, path="/"):
+    key = base64.b64encode(os.urandom(16)).decode()
+    writer.write(("GET %s HTTP/1.1\r\nHost: %s:%d\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                  "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n\r\n" % (path, host, port, key)).encode())
+    await writer.drain()
+    status, headers = await _read_headers(reader)
+    if " 101 " not in status + " " or headers.get("sec-websocket-accept") != accept_key(key):
+        raise ConnectionClosed("handshake refused: " + status)
+
+
+async def server_handshake(reader, writer):
+    status, headers = await _read_headers(reader)
+    key = headers.get("sec-websocket-key")
+    if not status.startswith("GET ") or key is None:
+        writer.write(b"HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n")
+        await writer.drain()
+        raise ConnectionClosed("not a WebSocket request")
+    writer.write(("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                  "Sec-WebSocket-Accept: %s\r\n\r\n" % accept_key(key)).encode())
+    await writer.drain()
+
+
+def encode_frame(opcode, payload, mask):
+    if isinstance(payload, str):
+        payload = payload.encode()
+    head = bytes([0x80 | opcode])
+    length = len(payload)
+    mask_bit = 0x80 if mask else 0
+    if length < 126:
+        head += bytes([mask_bit | length])
+    elif length < 65536:
+        head += bytes([mask_bit | 126]) + struct.pack(">H", length)
+    else:
+        head += bytes([mask_bit | 127]) + struct.pack(">Q", length)
+    if mask:
+        key = os.urandom(4)
+        payload = bytes(b ^ key[i & 3] for i, b in enumerate(payload))
+        head += key
+    return head + payload
+
+
+async def send(writer, opcode, payload, mask):
+    """Clients must mask their frames, servers must not."""
+    writer.write(encode_frame(opcode, payload, mask))
+    await writer.drain()
+
+
+async def _read_frame(reader):
+    head = await reader.readexactly(2)
+    fin = head[0] & 0x80
+    opcode = head[0] & 0x0F
+    length = head[1] & 0x7F
+    if length == 126:
+        length = struct.unpack(">H", await reader.readexactly(2))[0]
+    elif length == 127:
+        length = struct.unpack(">Q", await reader.readexactly(8))[0]
+    if length > MAX_MESSAGE:
+        raise ConnectionClosed("frame too large")
+    key = await reader.readexactly(4) if head[1] & 0x80 else None
+    payload = await reader.readexactly(length)
+    if key:
+        payload = bytes(b ^ key[i & 3] for i, b in enumerate(payload))
+    return fin, opcode, payload
+
+
+async def receive(reader, writer, mask):
+    """Next text or binary message as (opcode, payload). Answers pings, raises ConnectionClosed on close."""
+    message = b""
+    message_op = None
+    while True:
+        try:
+            fin, opcode, payload = await _read_frame(reader)
+        except (asyncio.IncompleteReadError, ConnectionError) as e:
+            raise ConnectionClosed(str(e))
+        if opcode == OP_PING:
+            await send(writer, OP_PONG, payload, mask)
+            continue
+        if opcode == OP_PONG:
+            continue
+        if opcode == OP_CLOSE:
+            try:
+                await send(writer, OP_CLOSE, payload[:2], mask)
+            except ConnectionError:
+                pass
+            raise ConnectionClosed("closed by peer")
+        if opcode != OP_CONT:
+            message_op = opcode
+            message = b""
+        message += payload
+        if fin:
+            return message_op, message
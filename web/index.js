@@ -0,0 +1,62 @@
+// Last state version seen, sent back on reconnect so only missed changes are resent.
+var ver = 0;
+var cn;
+
+function connect() {
+  cn = new WebSocket('ws://' + location.hostname + ':81/');
+
+  cn.onopen = function() {
+    if (ver) {
+      cn.send(JSON.stringify({SUB: 'light,time', SYNC: ver}));
+    } else {
+      cn.send('{"SUB":"light,time","STATUS":""}');
+      cn.send('{"TZLIST":""}');
+    }
+  };
+
+  cn.onclose = function() {
+    setTimeout(connect, 2000);
+  };
+
+  cn.onmessage = function(e) {
+    var data = JSON.parse(e.data);
+
+    if (data.hasOwnProperty('V')) {
+      ver = data.V;
+    }
+
+    if (data.hasOwnProperty('TZLIST')) {
+      var sel = document.getElementById('tz');
+      data.TZLIST.forEach(function(n) { sel.add(new Option(n, n)); });
+      cn.send('{"TZ":""}');
+    }
+    if (data.hasOwnProperty('TZ')) {
+      document.getElementById('tz').value = data.TZ;
+    }
+
+    if (data.hasOwnProperty('CURRENT')) {
+      var tgl = document.getElementById('tgl');
+      tgl.classList.toggle('lightBtnOff', data.CURRENT == 0);
+      tgl.classList.toggle('lightBtnOn', data.CURRENT != 0);
+    }
+    // TARGET is where a fade ends, LEVEL moves along with it. 0 means off, the slider keeps
+    // showing the level the light comes back on at.
+    if (data.hasOwnProperty('TARGET') && data.TARGET > 0) {
+      document.getElementById('lvl').value = data.TARGET;
+    }
+  };
+}
+
+function toggleLight() {
+  cn.send('{"TOGGLE": "1"}');
+}
+
+function setLevel(level) {
+  cn.send(JSON.stringify({BRIGHTNESS: Number(level)}));
+}
+
+function setTimezone(name) {
+  cn.send(JSON.stringify({TZ: name}));
+}
+
+connect();
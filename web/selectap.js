@@ -0,0 +1,35 @@
+// Fills the SSID field from a clicked network name.
+function c(l) {
+  document.getElementById('s').value = l.innerText || l.textContent;
+  document.getElementById('p').focus();
+}
+
+var cn = new WebSocket('ws://' + location.hostname + ':81/');
+
+cn.onopen = function() {
+  cn.send('{"APLIST":""}');
+};
+
+cn.onmessage = function(e) {
+  var data = JSON.parse(e.data);
+  if (data.hasOwnProperty('APLIST')) {
+    var vm = document.getElementById('vm');
+    vm.innerHTML = '';
+    data.APLIST.forEach(function(ap, i) {
+      var a = document.createElement('a');
+      a.href = '#p';
+      a.onclick = function() { c(a); };
+      a.textContent = ap.ssid;
+      var q = document.createElement('span');
+      q.className = 'q';
+      q.textContent = ap.rssi + ' dBm, ch ' + ap.ch + (ap.enc == 'open' ? '' : ', ' + ap.enc);
+      vm.append((i + 1) + ': ', a, q, document.createElement('br'));
+    });
+    document.getElementById('ttl').innerHTML = data.APLIST.length ? 'Networks found:' : 'No networks found.';
+  }
+};
+
+function refresh() {
+  document.getElementById('vm').innerHTML = 'Please wait...';
+  cn.send('{"APLIST":""}');
+}